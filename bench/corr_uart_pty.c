@@ -0,0 +1,344 @@
+/**
+ * Correction UART over a pty - Radio and NTRIP through the arbiter
+ *
+ * A pty stands in for the radio: a writer thread sends 1 Hz epochs of
+ * MSM7 frames (plus a 1005 every 5 s) into the master side, paced at
+ * 57600 baud, in random write sizes, with bit errors and line noise.
+ * corr_uart.c reads the slave side through bench/uart_host.c. A second,
+ * in-process source plays an NTRIP session carrying the same station
+ * 100 ms earlier; it drops out from 20 s to 40 s. The loop calls
+ * corr_arbiter_receive() every 10 ms, like the rover loop, and checks
+ * what would reach the receiver, epoch by epoch.
+ *
+ *   gcc -O2 -Wall -Wextra -Wno-unused-parameter -Ibench/stubs -Isrc -o corr_uart_pty \
+ *       bench/corr_uart_pty.c bench/uart_host.c src/corr_uart.c src/corr_arbiter.c \
+ *       src/rtcm_merge.c src/rtcm_liveness.c src/rtcm3.c -lpthread
+ *   ./corr_uart_pty [seconds]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "corr_arbiter.h"
+#include "corr_uart.h"
+
+#define PTY_EPOCH_TYPES     4
+#define PTY_PAYLOAD_LEN     180         // A mid-sized MSM7 message
+#define PTY_STATION         1
+#define PTY_NTRIP_DELAY_MS  50          // After the epoch
+#define PTY_RADIO_DELAY_MS  150
+#define PTY_BAUD_BYTES_S    5760        // 57600 baud, 8N1
+#define PTY_BIT_ERROR_PCT   2           // Radio frames with a flipped bit
+#define PTY_NTRIP_DOWN_MS   20000
+#define PTY_NTRIP_BACK_MS   40000
+#define PTY_MAX_SECONDS     600
+
+static const uint16_t s_types[PTY_EPOCH_TYPES] = { 1077, 1087, 1097, 1127 };
+
+static struct timespec s_start;
+static int s_seconds = 60;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - s_start.tv_sec) * 1000000LL + (now.tv_nsec - s_start.tv_nsec) / 1000;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
+
+static void sleep_until_ms(int64_t t_ms)
+{
+    int64_t wait = t_ms * 1000 - esp_timer_get_time();
+    if (wait > 0) {
+        struct timespec ts = { .tv_sec = wait / 1000000, .tv_nsec = (wait % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void put_bits(uint8_t *p, size_t pos, int len, uint64_t v)
+{
+    for (int i = 0; i < len; i++) {
+        size_t b = pos + i;
+        if ((v >> (len - 1 - i)) & 1) {
+            p[b / 8] |= 0x80 >> (b % 8);
+        }
+    }
+}
+
+/**
+ * Build a frame; the same (type, epoch) always gives the same bytes
+ * @param epoch_ms GPS time of week, 0 for a 1005
+ * @return Frame length
+ */
+static size_t make_frame(uint8_t *buf, uint16_t type, uint32_t epoch_ms, bool more)
+{
+    size_t payload_len = type == 1005 ? 19 : PTY_PAYLOAD_LEN;
+    uint8_t *p = buf + 3;
+    memset(p, 0, payload_len);
+    put_bits(p, 0, 12, type);
+    put_bits(p, 12, 12, PTY_STATION);
+    if (type != 1005) {
+        put_bits(p, 24, 30, epoch_ms);
+        put_bits(p, 54, 1, more);
+        put_bits(p, 73, 64, 0xFF00000000000000ULL);  // Satellite mask
+        for (size_t i = 20; i < payload_len; i++) {
+            p[i] = (uint8_t)(epoch_ms / 1000 * 31 + type + i);
+        }
+    }
+    buf[0] = 0xD3;
+    buf[1] = (uint8_t)(payload_len >> 8);
+    buf[2] = (uint8_t)payload_len;
+    uint32_t crc = rtcm3_crc24q(buf, 3 + payload_len);
+    buf[3 + payload_len] = (uint8_t)(crc >> 16);
+    buf[4 + payload_len] = (uint8_t)(crc >> 8);
+    buf[5 + payload_len] = (uint8_t)crc;
+    return 6 + payload_len;
+}
+
+/**
+ * One second's frames, back to back
+ * @return Bytes written to buf
+ */
+static size_t make_epoch(uint8_t *buf, int s)
+{
+    size_t len = 0;
+    if (s % 5 == 0) {
+        len += make_frame(buf + len, 1005, 0, false);
+    }
+    for (int k = 0; k < PTY_EPOCH_TYPES; k++) {
+        len += make_frame(buf + len, s_types[k], (uint32_t)s * 1000, k < PTY_EPOCH_TYPES - 1);
+    }
+    return len;
+}
+
+// Radio: writes into the pty master at line rate
+
+static int s_master = -1;
+static uint32_t s_radio_corrupted = 0;
+
+static void *radio_task(void *arg)
+{
+    uint8_t epoch[2048];
+    unsigned seed = 7;
+
+    for (int s = 0; s < s_seconds; s++) {
+        sleep_until_ms((int64_t)s * 1000 + PTY_RADIO_DELAY_MS);
+        size_t len = make_epoch(epoch, s);
+
+        // Bit errors, then a burst of noise (with a fake preamble) every 10 s
+        for (size_t pos = 0; pos < len;) {
+            size_t frame_len = 6 + ((epoch[pos + 1] << 8) | epoch[pos + 2]);
+            if ((unsigned)rand_r(&seed) % 100 < PTY_BIT_ERROR_PCT) {
+                epoch[pos + 3 + (unsigned)rand_r(&seed) % (frame_len - 6)] ^= 0x10;
+                s_radio_corrupted++;
+            }
+            pos += frame_len;
+        }
+        if (s % 10 == 9) {
+            uint8_t noise[24];
+            for (size_t i = 0; i < sizeof(noise); i++) {
+                noise[i] = (uint8_t)rand_r(&seed);
+            }
+            noise[3] = 0xD3;
+            memmove(epoch + sizeof(noise), epoch, len);
+            memcpy(epoch, noise, sizeof(noise));
+            len += sizeof(noise);
+        }
+
+        for (size_t pos = 0; pos < len;) {
+            size_t chunk = 1 + (unsigned)rand_r(&seed) % 64;
+            if (chunk > len - pos) {
+                chunk = len - pos;
+            }
+            if (write(s_master, epoch + pos, chunk) != (ssize_t)chunk) {
+                perror("pty write");
+                return NULL;
+            }
+            pos += chunk;
+            struct timespec ts = { .tv_nsec = (long)(chunk * 1000000000ULL / PTY_BAUD_BYTES_S) };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+// NTRIP stand-in: whole epochs appear at once, as from a TCP read
+
+static struct {
+    uint8_t data[2048];
+    size_t len;
+    size_t off;
+    rtcm3_framer_t framer;
+    rtcm3_frame_t frame;
+    bool pending;
+    bool up;
+} s_ntrip;
+
+static bool ntrip_is_up(void *ctx)
+{
+    return s_ntrip.up;
+}
+
+static const rtcm3_frame_t *ntrip_peek(void *ctx)
+{
+    while (!s_ntrip.pending && s_ntrip.off < s_ntrip.len) {
+        s_ntrip.off += rtcm3_framer_push(&s_ntrip.framer, s_ntrip.data + s_ntrip.off,
+                                         s_ntrip.len - s_ntrip.off, &s_ntrip.frame, &s_ntrip.pending);
+    }
+    return s_ntrip.pending ? &s_ntrip.frame : NULL;
+}
+
+static void ntrip_consume(void *ctx)
+{
+    s_ntrip.pending = false;
+}
+
+static void ntrip_drop(void *ctx)
+{
+    s_ntrip.len = s_ntrip.off = 0;
+}
+
+// What reaches the receiver
+
+typedef struct {
+    uint8_t parts;              // Bit per message type
+    int duplicates;
+    int64_t done_ms;            // Last part forwarded
+} epoch_seen_t;
+
+static epoch_seen_t s_seen[PTY_MAX_SECONDS];
+
+static void receiver_take(rtcm3_framer_t *framer, const uint8_t *data, size_t len, int64_t now)
+{
+    rtcm3_frame_t frame;
+    bool have = false;
+    while (len > 0) {
+        size_t used = rtcm3_framer_push(framer, data, len, &frame, &have);
+        data += used;
+        len -= used;
+        if (!have || !frame.is_msm) {
+            continue;
+        }
+        have = false;
+        int s = (int)(frame.epoch / 1000);
+        for (int k = 0; k < PTY_EPOCH_TYPES; k++) {
+            if (frame.msg_type == s_types[k] && s >= 0 && s < PTY_MAX_SECONDS) {
+                if (s_seen[s].parts & (1 << k)) {
+                    s_seen[s].duplicates++;
+                }
+                s_seen[s].parts |= 1 << k;
+                s_seen[s].done_ms = now;
+            }
+        }
+    }
+}
+
+static void report_phase(const char *label, int from, int to, const uint32_t *forwarded_by)
+{
+    int complete = 0, partial = 0, missing = 0, duplicates = 0;
+    int64_t worst_ms = 0;
+    for (int s = from; s < to; s++) {
+        duplicates += s_seen[s].duplicates;
+        if (s_seen[s].parts == (1 << PTY_EPOCH_TYPES) - 1) {
+            complete++;
+            int64_t latency = s_seen[s].done_ms - (int64_t)s * 1000;
+            worst_ms = latency > worst_ms ? latency : worst_ms;
+        } else if (s_seen[s].parts != 0) {
+            partial++;
+        } else {
+            missing++;
+        }
+    }
+    printf("%-24s epochs %2d complete, %d partial, %d missing, %d duplicate frames, "
+           "worst latency %3lld ms, led by ntrip %u / radio %u bytes\n",
+           label, complete, partial, missing, duplicates, (long long)worst_ms,
+           (unsigned)forwarded_by[0], (unsigned)forwarded_by[1]);
+}
+
+int main(int argc, char **argv)
+{
+    s_seconds = argc > 1 ? atoi(argv[1]) : 60;
+    if (s_seconds < 45 || s_seconds > PTY_MAX_SECONDS) {
+        fprintf(stderr, "seconds: 45-%d\n", PTY_MAX_SECONDS);
+        return 1;
+    }
+
+    s_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (s_master < 0 || grantpt(s_master) != 0 || unlockpt(s_master) != 0) {
+        perror("pty");
+        return 1;
+    }
+    setenv("UART_HOST_TTY", ptsname(s_master), 1);
+
+    clock_gettime(CLOCK_MONOTONIC, &s_start);
+    if (corr_uart_init() != ESP_OK) {
+        return 1;
+    }
+    corr_source_t ntrip = {
+        .name = "ntrip", .is_up = ntrip_is_up, .peek = ntrip_peek,
+        .consume = ntrip_consume, .drop = ntrip_drop,
+    };
+    rtcm3_framer_init(&s_ntrip.framer);
+    corr_arbiter_init();
+    corr_arbiter_add_source(&ntrip);
+    corr_arbiter_add_source(corr_uart_source());
+
+    pthread_t radio;
+    pthread_create(&radio, NULL, radio_task, NULL);
+
+    rtcm3_framer_t receiver;
+    rtcm3_framer_init(&receiver);
+    uint8_t buf[RTCM3_MAX_FRAME * 2];
+    uint32_t phase_forwarded[3][2] = {{0}};
+    int next_ntrip_s = 0;
+
+    for (int64_t t = 0; t < (int64_t)s_seconds * 1000 + 500; t += 10) {
+        sleep_until_ms(t);
+        s_ntrip.up = t < PTY_NTRIP_DOWN_MS || t >= PTY_NTRIP_BACK_MS;
+        if (next_ntrip_s < s_seconds && t >= (int64_t)next_ntrip_s * 1000 + PTY_NTRIP_DELAY_MS) {
+            if (s_ntrip.up) {
+                s_ntrip.len = make_epoch(s_ntrip.data, next_ntrip_s);
+                s_ntrip.off = 0;
+            }
+            next_ntrip_s++;
+        }
+
+        int len = corr_arbiter_receive(buf, sizeof(buf));
+        if (len > 0) {
+            int phase = t < PTY_NTRIP_DOWN_MS ? 0 : t < PTY_NTRIP_BACK_MS ? 1 : 2;
+            const char *active = corr_arbiter_active_name();
+            phase_forwarded[phase][strcmp(active, "ntrip") == 0 ? 0 : 1] += len;
+            receiver_take(&receiver, buf, (size_t)len, t);
+        }
+    }
+    pthread_join(radio, NULL);
+
+    printf("pty %s, %d s, NTRIP down %d-%d s\n", getenv("UART_HOST_TTY"), s_seconds,
+           PTY_NTRIP_DOWN_MS / 1000, PTY_NTRIP_BACK_MS / 1000);
+    report_phase("both up", 0, PTY_NTRIP_DOWN_MS / 1000, phase_forwarded[0]);
+    report_phase("radio only", PTY_NTRIP_DOWN_MS / 1000, PTY_NTRIP_BACK_MS / 1000, phase_forwarded[1]);
+    report_phase("ntrip back", PTY_NTRIP_BACK_MS / 1000, s_seconds, phase_forwarded[2]);
+
+    corr_uart_stats_t radio_stats;
+    corr_uart_get_stats(&radio_stats);
+    rtcm_merge_stats_t merge;
+    corr_arbiter_get_merge_stats(&merge);
+    printf("radio: %u bytes, %u frames, %u CRC errors (%u frames corrupted)\n",
+           (unsigned)radio_stats.bytes_received, (unsigned)radio_stats.frames,
+           (unsigned)radio_stats.crc_errors, (unsigned)s_radio_corrupted);
+    printf("merge: %u forwarded, %u duplicates suppressed, %u switches\n",
+           (unsigned)merge.frames_forwarded, (unsigned)merge.duplicates_suppressed,
+           (unsigned)merge.switches);
+    return 0;
+}
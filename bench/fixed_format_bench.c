@@ -0,0 +1,233 @@
+/**
+ * Fixed Format Bench - fixed_format.c against snprintf on the host
+ *
+ * Checks that the formatter writes exactly what snprintf writes (the JSON
+ * sample, and fmt_float against "%.*f"), then times both.
+ *
+ *   gcc -O2 -Wall -Wextra -Isrc -o fixed_format_bench \
+ *       bench/fixed_format_bench.c src/fixed_format.c src/telemetry_codec.c -lm
+ *   ./fixed_format_bench
+ *
+ * Host timings understate the gain: a PC has hardware double precision,
+ * the ESP32 formats "%.9f" in soft float.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include "fixed_format.h"
+#include "telemetry_codec.h"
+
+#define BENCH_RECORDS   2000000
+#define BENCH_FLOATS    2000000
+#define BENCH_TIMED     500000
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double now_s(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * The JSON sample as dashboard_client.c wrote it with snprintf
+ */
+static int snprintf_json(const telemetry_record_t *rec, char *out, size_t size)
+{
+    return snprintf(out, size,
+                    "{"
+                    "\"latitude\":%.9f,"
+                    "\"longitude\":%.9f,"
+                    "\"altitude\":%.3f,"
+                    "\"h_acc\":%.4f,"
+                    "\"v_acc\":%.4f,"
+                    "\"fix_type\":%d,"
+                    "\"carr_soln\":%d,"
+                    "\"num_sv\":%d,"
+                    "\"rtcm_bytes\":%lu,"
+                    "\"fixed_count\":%lu,"
+                    "\"float_count\":%lu,"
+                    "\"hour\":%d,"
+                    "\"min\":%d,"
+                    "\"sec\":%d,"
+                    "\"battery_pct\":%d,"
+                    "\"firmware_version\":\"%s\""
+                    "}",
+                    rec->lat_e7 * 1e-7, rec->lon_e7 * 1e-7, rec->alt_mm / 1000.0,
+                    rec->h_acc_mm / 1000.0, rec->v_acc_mm / 1000.0,
+                    rec->fix_type, rec->carr_soln, rec->num_sv,
+                    (unsigned long)rec->rtcm_bytes, (unsigned long)rec->fixed_count,
+                    (unsigned long)rec->float_count,
+                    (int)(rec->tod_s / 3600), (int)(rec->tod_s / 60 % 60), (int)(rec->tod_s % 60),
+                    rec->battery_pct, rec->firmware_version);
+}
+
+static long check_json(void)
+{
+    static const int32_t edge[] = {
+        0, 1, -1, 5, -5, 9999999, -9999999, 10000000, -10000000,
+        INT32_MAX, INT32_MIN, INT32_MIN + 1, 1800000000, -1800000000, 900000000,
+    };
+    const int num_edge = sizeof(edge) / sizeof(edge[0]);
+    char a[512], b[512];
+    long mismatches = 0;
+
+    for (long i = 0; i < BENCH_RECORDS; i++) {
+        telemetry_record_t rec = {0};
+        int32_t *fields[] = { &rec.lat_e7, &rec.lon_e7, &rec.alt_mm, &rec.h_acc_mm, &rec.v_acc_mm, &rec.tod_s };
+        for (int k = 0; k < 6; k++) {
+            // Every edge value in every field first, then random
+            *fields[k] = i < num_edge * num_edge ? edge[(i / (k + 1)) % num_edge] : (int32_t)rnd();
+        }
+        rec.rtcm_bytes = rnd();
+        rec.fixed_count = rnd();
+        rec.float_count = rnd();
+        rec.battery_pct = (int8_t)rnd();
+        rec.fix_type = rnd() & 7;
+        rec.carr_soln = rnd() & 3;
+        rec.num_sv = (uint8_t)rnd();
+        snprintf(rec.firmware_version, sizeof(rec.firmware_version), "%u.%u.%u",
+                 rnd() % 10, rnd() % 100, rnd() % 1000);
+
+        int len_a = snprintf_json(&rec, a, sizeof(a));
+        int len_b = telemetry_codec_format_json(&rec, b, sizeof(b));
+        if (len_a != len_b || strcmp(a, b) != 0) {
+            if (mismatches++ < 3) {
+                printf("  snprintf: %s\n  fixed:    %s\n", a, b);
+            }
+        }
+    }
+    return mismatches;
+}
+
+static long check_float(void)
+{
+    static const float edge[] = {
+        0.0f, -0.0f, 0.0005f, -0.0005f, 1.0005f, 2.5f, 0.125f, 1e12f, -3.4565f, 123456.789f, 0.0625f,
+    };
+    char a[64], b[64];
+    long mismatches = 0;
+
+    for (long i = 0; i < BENCH_FLOATS; i++) {
+        float v;
+        if (i < (long)(sizeof(edge) / sizeof(edge[0]))) {
+            v = edge[i];
+        } else {
+            // Any bit pattern within the documented range
+            uint32_t bits = rnd();
+            memcpy(&v, &bits, sizeof(v));
+            if (!(v < 1e12f && v > -1e12f)) {
+                v = (int32_t)bits * 1e-4f;
+            }
+        }
+        int decimals = i % 7;
+
+        snprintf(a, sizeof(a), "%.*f", decimals, v);
+        fmt_writer_t w;
+        fmt_init(&w, b, sizeof(b));
+        fmt_float(&w, v, decimals);
+        fmt_finish(&w);
+        if (strcmp(a, b) != 0 && mismatches++ < 3) {
+            printf("  %%.%df: %s  fmt_float: %s\n", decimals, a, b);
+        }
+    }
+    return mismatches;
+}
+
+static void time_json(void)
+{
+    static telemetry_record_t recs[1024];
+    for (int i = 0; i < 1024; i++) {
+        recs[i] = (telemetry_record_t){
+            .lat_e7 = 455000000 + rnd() % 100000, .lon_e7 = -1224000000 - (int32_t)(rnd() % 100000),
+            .alt_mm = 60000 + rnd() % 1000, .h_acc_mm = 14, .v_acc_mm = 21, .tod_s = rnd() % 86400,
+            .rtcm_bytes = rnd(), .battery_pct = 80, .fix_type = 3, .carr_soln = 2, .num_sv = 30,
+        };
+        strcpy(recs[i].firmware_version, "1.4.2");
+    }
+
+    char buf[512];
+    volatile int sink = 0;
+    double t0 = now_s();
+    for (int i = 0; i < BENCH_TIMED; i++) {
+        sink += snprintf_json(&recs[i & 1023], buf, sizeof(buf));
+    }
+    double t1 = now_s();
+    for (int i = 0; i < BENCH_TIMED; i++) {
+        sink += telemetry_codec_format_json(&recs[i & 1023], buf, sizeof(buf));
+    }
+    double t2 = now_s();
+    printf("JSON sample   snprintf %5.0f ns   fixed_format %5.0f ns\n",
+           (t1 - t0) / BENCH_TIMED * 1e9, (t2 - t1) / BENCH_TIMED * 1e9);
+}
+
+static void time_log_line(void)
+{
+    // main.c's position log line
+    double lat = 45.51234567, lon = -122.41234567;
+    char buf[128];
+    volatile int sink = 0;
+    double t0 = now_s();
+    for (int i = 0; i < BENCH_TIMED; i++) {
+        sink += snprintf(buf, sizeof(buf), "Lat: %.9f  Lon: %.9f", lat, lon);
+    }
+    double t1 = now_s();
+    for (int i = 0; i < BENCH_TIMED; i++) {
+        fmt_writer_t w;
+        fmt_init(&w, buf, sizeof(buf));
+        fmt_str(&w, "Lat: ");
+        fmt_fixed64(&w, llround(lat * 1e9), 9);
+        fmt_str(&w, "  Lon: ");
+        fmt_fixed64(&w, llround(lon * 1e9), 9);
+        sink += fmt_finish(&w);
+    }
+    double t2 = now_s();
+    printf("Log line      snprintf %5.0f ns   fixed_format %5.0f ns\n",
+           (t1 - t0) / BENCH_TIMED * 1e9, (t2 - t1) / BENCH_TIMED * 1e9);
+}
+
+static void time_float(void)
+{
+    char buf[64];
+    volatile int sink = 0;
+    double t0 = now_s();
+    for (int i = 0; i < BENCH_TIMED; i++) {
+        sink += snprintf(buf, sizeof(buf), "%.3f", 1.234f + i * 1e-4f);
+    }
+    double t1 = now_s();
+    for (int i = 0; i < BENCH_TIMED; i++) {
+        fmt_writer_t w;
+        fmt_init(&w, buf, sizeof(buf));
+        fmt_float(&w, 1.234f + i * 1e-4f, 3);
+        sink += fmt_finish(&w);
+    }
+    double t2 = now_s();
+    printf("\"%%.3f\"        snprintf %5.0f ns   fmt_float    %5.0f ns\n",
+           (t1 - t0) / BENCH_TIMED * 1e9, (t2 - t1) / BENCH_TIMED * 1e9);
+}
+
+int main(void)
+{
+    long json_bad = check_json();
+    printf("JSON: %ld of %d samples differ from snprintf\n", json_bad, BENCH_RECORDS);
+    long float_bad = check_float();
+    printf("fmt_float: %ld of %d values differ from \"%%.*f\"\n", float_bad, BENCH_FLOATS);
+
+    time_json();
+    time_log_line();
+    time_float();
+    return json_bad == 0 && float_bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/**
+ * MQTT Bench - mqtt_uplink.c against a broker on the host
+ *
+ * Publishes position samples (QoS 0) and events (QoS 1) through the
+ * uplink exactly as the telemetry task does, then prints the uplink's own
+ * statistics: messages per second and PUBLISH-to-PUBACK round-trip time.
+ *
+ *   gcc -O2 -Wall -Wextra -Wno-unused-parameter -Ibench/stubs -Isrc -o mqtt_bench \
+ *       bench/mqtt_bench.c bench/mqtt_client_host.c src/mqtt_uplink.c \
+ *       src/telemetry_codec.c src/fixed_format.c -lpthread -lm
+ *   mosquitto -p 1883 &
+ *   ./mqtt_bench [seconds] [positions/s] [events/s]
+ *
+ * positions/s 0 publishes as fast as the broker takes them, with an event
+ * after every 100 positions. Add -DMQTT_BROKER_URI='"mqtt://host:port"' for
+ * a broker elsewhere, -DDASHBOARD_BINARY=1 for binary payloads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "mqtt_uplink.h"
+
+static struct timespec s_start;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - s_start.tv_sec) * 1000000LL + (now.tv_nsec - s_start.tv_nsec) / 1000;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
+
+static void sleep_until_us(int64_t t_us)
+{
+    int64_t wait = t_us - esp_timer_get_time();
+    if (wait > 0) {
+        struct timespec ts = { .tv_sec = wait / 1000000, .tv_nsec = (wait % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 20;
+    int positions_per_s = argc > 2 ? atoi(argv[2]) : 10;
+    int events_per_s = argc > 3 ? atoi(argv[3]) : 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &s_start);
+    if (mqtt_uplink_init() != ESP_OK) {
+        return 1;
+    }
+    while (!mqtt_uplink_connected()) {
+        if (esp_timer_get_time() > 5000000) {
+            fprintf(stderr, "No CONNACK within 5 s\n");
+            return 1;
+        }
+        sleep_until_us(esp_timer_get_time() + 1000);
+    }
+
+    telemetry_record_t rec = {
+        .lat_e7 = 455123456, .lon_e7 = -1224123456, .alt_mm = 60123,
+        .h_acc_mm = 14, .v_acc_mm = 21, .battery_pct = 80,
+        .fix_type = 3, .carr_soln = 2, .num_sv = 30,
+    };
+    strcpy(rec.firmware_version, "bench");
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + seconds * 1000000LL;
+    int64_t next_position_us = start_us;
+    int64_t next_event_us = start_us;
+    uint32_t n = 0;
+    while (esp_timer_get_time() < end_us && mqtt_uplink_connected()) {
+        if (positions_per_s > 0) {
+            sleep_until_us(next_position_us < next_event_us || events_per_s <= 0 ? next_position_us : next_event_us);
+        }
+        int64_t now = esp_timer_get_time();
+
+        if (positions_per_s <= 0 || now >= next_position_us) {
+            rec.tod_s = (int32_t)(now / 1000000);
+            rec.lat_e7 += (int32_t)(n % 7) - 3;
+            mqtt_uplink_publish_position(&rec);
+            n++;
+            next_position_us += positions_per_s > 0 ? 1000000 / positions_per_s : 0;
+        }
+        bool event_due = positions_per_s <= 0 ? n % 100 == 0
+                                              : events_per_s > 0 && now >= next_event_us;
+        if (event_due) {
+            char json[64];
+            snprintf(json, sizeof(json), "{\"event\":\"bench\",\"n\":%u}", (unsigned)n);
+            mqtt_uplink_publish_event(json);
+            next_event_us += events_per_s > 0 ? 1000000 / events_per_s : 0;
+        }
+        mqtt_uplink_poll();
+    }
+
+    double elapsed_s = (esp_timer_get_time() - start_us) / 1e6;
+
+    // Collect the last PUBACKs - a flooded broker can be seconds behind
+    mqtt_uplink_stats_t stats;
+    int64_t drain_end_us = esp_timer_get_time() + 10000000;
+    do {
+        sleep_until_us(esp_timer_get_time() + 10000);
+        mqtt_uplink_poll();
+        mqtt_uplink_get_stats(&stats);
+    } while (stats.qos1_acked + stats.qos1_expired <= stats.qos1_sent &&  // + the "online" status
+             esp_timer_get_time() < drain_end_us);
+    printf("positions %u, events %u acked %u expired %u, %u bytes in %.1f s\n",
+           (unsigned)stats.positions, (unsigned)stats.qos1_sent, (unsigned)stats.qos1_acked,
+           (unsigned)stats.qos1_expired, (unsigned)stats.bytes_sent, elapsed_s);
+    printf("uplink: %.1f msg/s (last 10 s window), RTT last %u ms avg %u ms\n",
+           stats.msgs_per_s, (unsigned)stats.last_rtt_ms, (unsigned)stats.avg_rtt_ms);
+    printf("bench:  %.1f msg/s overall\n", (stats.positions + stats.qos1_sent) / elapsed_s);
+    return stats.connected ? 0 : 1;
+}
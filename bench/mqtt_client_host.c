@@ -0,0 +1,302 @@
+/**
+ * MQTT Client (host) - Just enough of the ESP-IDF MQTT client to run
+ * mqtt_uplink.c against a real broker on a PC
+ *
+ * MQTT 3.1.1 over plain TCP: CONNECT with credentials and last will,
+ * PUBLISH at QoS 0/1, PUBACK, PINGREQ. A reader thread stands in for the
+ * client task and raises CONNECTED, DISCONNECTED and PUBLISHED events on
+ * it, so the uplink sees PUBACKs from another thread as on the device.
+ * There is no outbox and no reconnect: enqueue() sends straight away when
+ * connected and fails otherwise.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "mqtt_client.h"
+
+#define MQTT_HOST_MAX_PACKET 4096
+
+struct esp_mqtt_client {
+    esp_mqtt_client_config_t cfg;
+    char host[128];
+    char port[8];
+    int fd;
+    bool connected;
+    uint16_t next_msg_id;
+    esp_event_handler_t handler;
+    void *handler_arg;
+    pthread_t reader;
+    pthread_mutex_t tx_lock;
+};
+
+static void raise_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, int msg_id)
+{
+    esp_mqtt_event_t event = { .event_id = id, .client = client, .msg_id = msg_id };
+    if (client->handler != NULL) {
+        client->handler(client->handler_arg, "MQTT_EVENTS", id, &event);
+    }
+}
+
+static bool send_all(esp_mqtt_client_handle_t client, const uint8_t *buf, size_t len)
+{
+    pthread_mutex_lock(&client->tx_lock);
+    while (len > 0) {
+        ssize_t n = send(client->fd, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            pthread_mutex_unlock(&client->tx_lock);
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    pthread_mutex_unlock(&client->tx_lock);
+    return true;
+}
+
+static bool recv_all(int fd, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Fixed header: type/flags byte and the remaining length varint
+ * @return Header length
+ */
+static size_t put_header(uint8_t *buf, uint8_t type_flags, size_t remaining)
+{
+    size_t pos = 0;
+    buf[pos++] = type_flags;
+    do {
+        uint8_t b = remaining & 0x7F;
+        remaining >>= 7;
+        buf[pos++] = b | (remaining > 0 ? 0x80 : 0);
+    } while (remaining > 0);
+    return pos;
+}
+
+static size_t put_string(uint8_t *buf, const char *s, size_t len)
+{
+    buf[0] = (uint8_t)(len >> 8);
+    buf[1] = (uint8_t)len;
+    memcpy(buf + 2, s, len);
+    return 2 + len;
+}
+
+static bool send_connect(esp_mqtt_client_handle_t client)
+{
+    const esp_mqtt_client_config_t *cfg = &client->cfg;
+    char client_id[32];
+    snprintf(client_id, sizeof(client_id), "rtk_rover_bench_%d", (int)getpid());
+
+    uint8_t body[1024];
+    size_t pos = put_string(body, "MQTT", 4);
+    body[pos++] = 4;  // 3.1.1
+    uint8_t flags = 0x02;  // Clean session
+    if (cfg->session.last_will.topic != NULL) {
+        flags |= 0x04 | (uint8_t)(cfg->session.last_will.qos << 3) |
+                 (cfg->session.last_will.retain ? 0x20 : 0);
+    }
+    if (cfg->credentials.username != NULL) {
+        flags |= 0x80;
+    }
+    if (cfg->credentials.authentication.password != NULL) {
+        flags |= 0x40;
+    }
+    body[pos++] = flags;
+    body[pos++] = (uint8_t)(cfg->session.keepalive >> 8);
+    body[pos++] = (uint8_t)cfg->session.keepalive;
+    pos += put_string(body + pos, client_id, strlen(client_id));
+    if (cfg->session.last_will.topic != NULL) {
+        const char *msg = cfg->session.last_will.msg;
+        size_t msg_len = cfg->session.last_will.msg_len > 0 ? (size_t)cfg->session.last_will.msg_len : strlen(msg);
+        pos += put_string(body + pos, cfg->session.last_will.topic, strlen(cfg->session.last_will.topic));
+        pos += put_string(body + pos, msg, msg_len);
+    }
+    if (cfg->credentials.username != NULL) {
+        pos += put_string(body + pos, cfg->credentials.username, strlen(cfg->credentials.username));
+    }
+    if (cfg->credentials.authentication.password != NULL) {
+        const char *pw = cfg->credentials.authentication.password;
+        pos += put_string(body + pos, pw, strlen(pw));
+    }
+
+    uint8_t pkt[1024 + 5];
+    size_t len = put_header(pkt, 0x10, pos);
+    memcpy(pkt + len, body, pos);
+    return send_all(client, pkt, len + pos);
+}
+
+static void *reader_task(void *arg)
+{
+    esp_mqtt_client_handle_t client = arg;
+    uint8_t buf[MQTT_HOST_MAX_PACKET];
+    int idle_ms = client->cfg.session.keepalive > 0 ? client->cfg.session.keepalive * 500 : -1;
+
+    for (;;) {
+        struct pollfd pfd = { .fd = client->fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, idle_ms);
+        if (ready == 0) {
+            static const uint8_t pingreq[2] = { 0xC0, 0x00 };
+            send_all(client, pingreq, sizeof(pingreq));
+            continue;
+        }
+
+        uint8_t type;
+        size_t remaining = 0;
+        int shift = 0;
+        uint8_t b;
+        if (ready < 0 || !recv_all(client->fd, &type, 1)) {
+            break;
+        }
+        do {
+            if (!recv_all(client->fd, &b, 1)) {
+                goto closed;
+            }
+            remaining |= (size_t)(b & 0x7F) << shift;
+            shift += 7;
+        } while ((b & 0x80) && shift < 28);
+        if (remaining > sizeof(buf) || !recv_all(client->fd, buf, remaining)) {
+            break;
+        }
+
+        switch (type >> 4) {
+        case 2:  // CONNACK
+            if (remaining >= 2 && buf[1] == 0) {
+                __atomic_store_n(&client->connected, true, __ATOMIC_RELEASE);
+                raise_event(client, MQTT_EVENT_CONNECTED, 0);
+            } else {
+                fprintf(stderr, "CONNACK refused: %d\n", remaining >= 2 ? buf[1] : -1);
+                goto closed;
+            }
+            break;
+        case 4:  // PUBACK
+            if (remaining >= 2) {
+                raise_event(client, MQTT_EVENT_PUBLISHED, (buf[0] << 8) | buf[1]);
+            }
+            break;
+        default:  // PINGRESP, and nothing is subscribed
+            break;
+        }
+    }
+
+closed:
+    __atomic_store_n(&client->connected, false, __ATOMIC_RELEASE);
+    raise_event(client, MQTT_EVENT_DISCONNECTED, 0);
+    return NULL;
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config)
+{
+    esp_mqtt_client_handle_t client = calloc(1, sizeof(*client));
+    if (client == NULL) {
+        return NULL;
+    }
+    client->cfg = *config;
+    client->fd = -1;
+    client->next_msg_id = 1;
+    pthread_mutex_init(&client->tx_lock, NULL);
+
+    const char *uri = config->broker.address.uri;
+    if (strncmp(uri, "mqtt://", 7) != 0 ||
+        sscanf(uri + 7, "%127[^:/]:%7[0-9]", client->host, client->port) < 1) {
+        fprintf(stderr, "Only mqtt://host[:port] is supported: %s\n", uri);
+        free(client);
+        return NULL;
+    }
+    if (client->port[0] == '\0') {
+        strcpy(client->port, "1883");
+    }
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void *arg)
+{
+    client->handler = handler;
+    client->handler_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res;
+    if (getaddrinfo(client->host, client->port, &hints, &res) != 0) {
+        return ESP_FAIL;
+    }
+    client->fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (client->fd < 0 || connect(client->fd, res->ai_addr, res->ai_addrlen) != 0) {
+        freeaddrinfo(res);
+        return ESP_FAIL;
+    }
+    freeaddrinfo(res);
+
+    // lwIP sends small segments immediately too
+    int one = 1;
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (!send_connect(client) || pthread_create(&client->reader, NULL, reader_task, client) != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data,
+                            int len, int qos, int retain)
+{
+    if (!__atomic_load_n(&client->connected, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+    if (len == 0 && data != NULL) {
+        len = (int)strlen(data);
+    }
+    size_t topic_len = strlen(topic);
+    size_t body_len = 2 + topic_len + (qos > 0 ? 2 : 0) + (size_t)len;
+    if (body_len + 5 > MQTT_HOST_MAX_PACKET) {
+        return -1;
+    }
+
+    int msg_id = 0;
+    if (qos > 0) {
+        pthread_mutex_lock(&client->tx_lock);
+        msg_id = client->next_msg_id++;
+        if (client->next_msg_id == 0) {
+            client->next_msg_id = 1;
+        }
+        pthread_mutex_unlock(&client->tx_lock);
+    }
+
+    uint8_t pkt[MQTT_HOST_MAX_PACKET];
+    size_t pos = put_header(pkt, 0x30 | (uint8_t)(qos << 1) | (retain ? 1 : 0), body_len);
+    pos += put_string(pkt + pos, topic, topic_len);
+    if (qos > 0) {
+        pkt[pos++] = (uint8_t)(msg_id >> 8);
+        pkt[pos++] = (uint8_t)msg_id;
+    }
+    memcpy(pkt + pos, data, (size_t)len);
+    pos += (size_t)len;
+
+    return send_all(client, pkt, pos) ? msg_id : -1;
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic, const char *data,
+                            int len, int qos, int retain, bool store)
+{
+    return esp_mqtt_client_publish(client, topic, data, len, qos, retain);
+}
@@ -0,0 +1,13 @@
+/**
+ * Host stub - enables the benchmarked modules; otherwise their own
+ * defaults apply (MQTT_BROKER_URI defaults to mqtt://localhost:1883,
+ * override with -D on the gcc line)
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define MQTT_ENABLED 1
+#define CORR_UART_ENABLED 1
+
+#endif // CONFIG_H
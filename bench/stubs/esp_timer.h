@@ -0,0 +1,12 @@
+/**
+ * Host stub - microseconds since start (CLOCK_MONOTONIC)
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,17 @@
+/**
+ * Host stub - the FreeRTOS base types
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+
+#endif // FREERTOS_H
@@ -0,0 +1,14 @@
+/**
+ * Host stub - queues, as far as a driver's event queue needs them
+ */
+
+#ifndef FREERTOS_QUEUE_H
+#define FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+
+#endif // FREERTOS_QUEUE_H
@@ -0,0 +1,8 @@
+/**
+ * Host stub - see FreeRTOS.h
+ */
+
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#endif // FREERTOS_TASK_H
@@ -0,0 +1,227 @@
+/**
+ * Correction Arbiter - Picks what reaches the receiver from all sources
+ *
+ * Every source is drained on every call, whether it is forwarded or not,
+ * so a standby never builds up a backlog of old frames and can take over
+ * from its very next frame - switching never stalls the receiver.
+ *
+ * The receiver's correction age (NAV-PVT flags3) is the last word on
+ * health: a stream can look perfectly alive here and still not be usable
+ * by the receiver (wrong station, incompatible messages). When that age
+ * passes CORR_AGE_MAX_S the forwarded source is benched for as long, which
+ * hands the receiver to the next source; NTRIP sources also reconnect.
+ * With no other source up the stream is left alone and only the alarm is
+ * raised - a stalled stream is caught by the epoch liveness check anyway.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "corr_arbiter.h"
+#include "config.h"
+
+static const char *TAG = "corr_arbiter";
+
+#ifndef CORR_AGE_MAX_S
+#define CORR_AGE_MAX_S 10
+#endif
+
+static const corr_source_t *s_sources[CORR_MAX_SOURCES];
+static int s_num_sources = 0;
+static bool s_up[CORR_MAX_SOURCES];                 // As last told to the selector
+static int64_t s_benched_until_ms[CORR_MAX_SOURCES];
+static rtcm_merge_t s_merge;
+
+// Receiver correction age watchdog
+static bool s_corr_age_alarm = false;
+static int64_t s_corr_age_holdoff_ms = 0;           // No forced drop before this time
+static corr_age_stats_t s_corr_age_stats;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+void corr_arbiter_init(void)
+{
+    s_num_sources = 0;
+    memset(s_up, 0, sizeof(s_up));
+    memset(s_benched_until_ms, 0, sizeof(s_benched_until_ms));
+    rtcm_merge_init(&s_merge, 0);
+}
+
+esp_err_t corr_arbiter_add_source(const corr_source_t *source)
+{
+    if (source == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_num_sources >= CORR_MAX_SOURCES) {
+        ESP_LOGE(TAG, "No room for correction source %s", source->name);
+        return ESP_ERR_NO_MEM;
+    }
+    s_sources[s_num_sources++] = source;
+    rtcm_merge_init(&s_merge, s_num_sources);
+    ESP_LOGI(TAG, "Correction source %d: %s", s_num_sources - 1, source->name);
+    return ESP_OK;
+}
+
+/**
+ * Tell the selector when a source comes up or goes down
+ * @return true if the source may be forwarded
+ */
+static bool sync_input(int i, int64_t now)
+{
+    const corr_source_t *src = s_sources[i];
+    bool up = src->is_up(src->ctx) && now >= s_benched_until_ms[i];
+    if (up != s_up[i]) {
+        s_up[i] = up;
+        rtcm_merge_set_input_up(&s_merge, i, up, now);
+    }
+    return up;
+}
+
+/**
+ * Is a source other than this one up and not benched?
+ */
+static bool alternative_up(int except, int64_t now)
+{
+    for (int i = 0; i < s_num_sources; i++) {
+        if (i != except && s_sources[i]->is_up(s_sources[i]->ctx) &&
+            now >= s_benched_until_ms[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int corr_arbiter_receive(uint8_t *buffer, size_t max_len)
+{
+    int64_t now = now_ms();
+    bool any_up = false;
+    size_t written = 0;
+
+    for (int i = 0; i < s_num_sources; i++) {
+        const corr_source_t *src = s_sources[i];
+        const rtcm3_frame_t *frame;
+
+        while ((frame = src->peek(src->ctx)) != NULL) {
+            if (!sync_input(i, now)) {
+                src->consume(src->ctx);  // Benched: keep it drained
+                continue;
+            }
+
+            // Leave the frame queued until the caller has room for all of it
+            if (frame->len > max_len - written) {
+                break;
+            }
+            if (rtcm_merge_offer(&s_merge, i, frame, now)) {
+                memcpy(buffer + written, frame->data, frame->len);
+                written += frame->len;
+            }
+            src->consume(src->ctx);
+        }
+
+        any_up |= sync_input(i, now);
+    }
+
+    return any_up ? (int)written : -1;
+}
+
+bool corr_arbiter_is_up(void)
+{
+    for (int i = 0; i < s_num_sources; i++) {
+        if (s_up[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *corr_arbiter_active_name(void)
+{
+    if (s_merge.active < 0 || s_merge.active >= s_num_sources) {
+        return "none";
+    }
+    return s_sources[s_merge.active]->name;
+}
+
+void corr_arbiter_check_correction_age(const zed_position_t *pos)
+{
+    if (pos == NULL) {
+        return;
+    }
+    int64_t now = now_ms();
+    s_corr_age_stats.last_age_s = pos->corr_age_s;
+
+    // Without a 3D fix the receiver can't use corrections yet (cold start,
+    // no sky), so its age says nothing about the source
+    bool has_fix = pos->valid && (pos->fix_type == 3 || pos->fix_type == 4);
+    if (!has_fix) {
+        return;
+    }
+
+    // Unknown (no corrections at all) counts as too old
+    if (pos->corr_age_s <= CORR_AGE_MAX_S) {
+        if (s_corr_age_alarm) {
+            ESP_LOGI(TAG, "Receiver correction age back to %u s", pos->corr_age_s);
+            s_corr_age_alarm = false;
+        }
+        return;
+    }
+
+    int active = s_merge.active;
+    if (active < 0) {
+        return;  // Nothing forwarded - the sources are already reconnecting
+    }
+
+    // Give a freshly (re)started stream time to bring the age down
+    const int64_t grace_ms = (int64_t)CORR_AGE_MAX_S * 1000;
+    if (now - s_merge.inputs[active].up_since_ms < grace_ms) {
+        return;
+    }
+
+    if (!s_corr_age_alarm) {
+        s_corr_age_alarm = true;
+        s_corr_age_stats.alarms++;
+        if (pos->corr_age_s == ZED_CORR_AGE_UNKNOWN) {
+            ESP_LOGW(TAG, "Receiver reports no corrections while %s is forwarded",
+                     s_sources[active]->name);
+        } else {
+            ESP_LOGW(TAG, "Receiver correction age %u s exceeds %d s",
+                     pos->corr_age_s, CORR_AGE_MAX_S);
+        }
+    }
+
+    if (now < s_corr_age_holdoff_ms || !alternative_up(active, now)) {
+        return;
+    }
+    const corr_source_t *src = s_sources[active];
+    ESP_LOGW(TAG, "Benching %s on correction age", src->name);
+    s_benched_until_ms[active] = now + grace_ms;
+    sync_input(active, now);
+    if (src->drop != NULL) {
+        src->drop(src->ctx);
+    }
+    s_corr_age_stats.forced_drops++;
+    s_corr_age_holdoff_ms = now + grace_ms;
+}
+
+bool corr_arbiter_corr_age_alarm(void)
+{
+    return s_corr_age_alarm;
+}
+
+void corr_arbiter_get_corr_age_stats(corr_age_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_corr_age_stats;
+    }
+}
+
+void corr_arbiter_get_merge_stats(rtcm_merge_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_merge.stats;
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * Correction Arbiter - Picks what reaches the receiver from all sources
+ *
+ * Sources (NTRIP sessions, a local radio) are registered in priority
+ * order. Frames are pulled from every source and run through rtcm_merge,
+ * which forwards the freshest copy of each frame of the active station and
+ * suppresses the rest. The receiver's own correction age is the final
+ * check: a source whose corrections the receiver isn't using is benched.
+ */
+
+#ifndef CORR_ARBITER_H
+#define CORR_ARBITER_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "corr_source.h"
+#include "rtcm_merge.h"
+#include "zed_rover.h"
+
+#define CORR_MAX_SOURCES RTCM_MERGE_MAX_INPUTS
+
+/**
+ * Receiver correction age watchdog statistics
+ */
+typedef struct {
+    uint32_t alarms;            // Times the age went over CORR_AGE_MAX_S
+    uint32_t forced_drops;      // Forwarded sources benched because of it
+    uint16_t last_age_s;        // As reported by the receiver (see zed_rover.h)
+} corr_age_stats_t;
+
+/**
+ * Reset arbiter state (call before adding sources)
+ */
+void corr_arbiter_init(void);
+
+/**
+ * Register a source; earlier sources have higher priority
+ * @return ESP_ERR_NO_MEM when CORR_MAX_SOURCES are registered
+ */
+esp_err_t corr_arbiter_add_source(const corr_source_t *source);
+
+/**
+ * Collect forwarded frames from all sources
+ * Only whole frames are returned, so max_len should be at least
+ * RTCM3_MAX_FRAME.
+ * @return Bytes written, 0 if no data, or -1 if no source is up
+ */
+int corr_arbiter_receive(uint8_t *buffer, size_t max_len);
+
+/**
+ * Check if any source is up
+ */
+bool corr_arbiter_is_up(void);
+
+/**
+ * Get the name of the source leading the forwarded stream ("none" if idle)
+ */
+const char *corr_arbiter_active_name(void);
+
+/**
+ * Feed the receiver's correction age from NAV-PVT
+ * Past CORR_AGE_MAX_S the forwarded source is benched (and dropped, if it
+ * can reconnect) so another source takes over; with none up, only the
+ * alarm is raised. Ignored until the receiver has a 3D fix.
+ */
+void corr_arbiter_check_correction_age(const zed_position_t *pos);
+
+/**
+ * Check if the receiver's correction age is over the limit
+ */
+bool corr_arbiter_corr_age_alarm(void);
+
+/**
+ * Get correction age watchdog statistics
+ */
+void corr_arbiter_get_corr_age_stats(corr_age_stats_t *stats);
+
+/**
+ * Get frame selector counters (switches, switch latency, duplicates)
+ */
+void corr_arbiter_get_merge_stats(rtcm_merge_stats_t *stats);
+
+#endif // CORR_ARBITER_H
@@ -0,0 +1,33 @@
+/**
+ * Correction Source - Common interface for RTCM inputs
+ *
+ * A source turns its transport (NTRIP caster, UART radio) into CRC-checked
+ * RTCM 3 frames. The arbiter pulls frames with peek/consume, so a frame
+ * that doesn't fit the caller's buffer simply stays queued in the source.
+ */
+
+#ifndef CORR_SOURCE_H
+#define CORR_SOURCE_H
+
+#include <stdbool.h>
+#include "rtcm3.h"
+
+typedef struct {
+    const char *name;
+    void *ctx;
+
+    // Connected and delivering
+    bool (*is_up)(void *ctx);
+
+    // Next complete frame, or NULL if none is ready (never blocks)
+    const rtcm3_frame_t *(*peek)(void *ctx);
+
+    // Done with the frame returned by peek
+    void (*consume)(void *ctx);
+
+    // The receiver can't use this stream - abandon and re-establish it
+    // (NULL for sources that can't be reset, e.g. a radio)
+    void (*drop)(void *ctx);
+} corr_source_t;
+
+#endif // CORR_SOURCE_H
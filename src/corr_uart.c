@@ -0,0 +1,172 @@
+/**
+ * Correction UART - RTCM from a local radio (UHF, LoRa) on a serial port
+ *
+ * Radios deliver RTCM as a bare byte stream with no link-level integrity
+ * of their own, so the CRC-24Q check in the framer is what filters out
+ * bit errors. The source counts as up while frames keep arriving.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+
+#include "corr_uart.h"
+#include "config.h"
+
+static const char *TAG = "corr_uart";
+
+#ifndef CORR_UART_ENABLED
+#define CORR_UART_ENABLED 0
+#endif
+#ifndef CORR_UART_NUM
+#define CORR_UART_NUM UART_NUM_2
+#endif
+#ifndef CORR_UART_RX_PIN
+#define CORR_UART_RX_PIN 16
+#endif
+#ifndef CORR_UART_TX_PIN
+#define CORR_UART_TX_PIN 17
+#endif
+#ifndef CORR_UART_BAUD
+#define CORR_UART_BAUD 57600
+#endif
+
+#define CORR_UART_RING_SIZE   4096    // ~0.7 s at 57600 baud
+#define CORR_UART_EVENT_DEPTH 8
+#define CORR_UART_TIMEOUT_MS  3000    // Down after this long without a frame
+
+static struct {
+    bool installed;
+    QueueHandle_t events;
+    uint8_t rx[256];
+    size_t rx_len;
+    size_t rx_off;
+    rtcm3_framer_t framer;
+    rtcm3_frame_t frame;
+    bool frame_pending;
+    int64_t last_frame_ms;
+    bool have_frame;
+    corr_uart_stats_t stats;
+} s_uart;
+
+static corr_source_t s_source;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * Count overruns reported by the driver
+ */
+static void drain_events(void)
+{
+    uart_event_t event;
+    while (xQueueReceive(s_uart.events, &event, 0) == pdTRUE) {
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            s_uart.stats.overflows++;
+            ESP_LOGW(TAG, "RX overrun - radio data lost");
+        }
+    }
+}
+
+static const rtcm3_frame_t *source_peek(void *ctx)
+{
+    (void)ctx;
+    drain_events();
+
+    while (!s_uart.frame_pending) {
+        if (s_uart.rx_off >= s_uart.rx_len) {
+            int len = uart_read_bytes(CORR_UART_NUM, s_uart.rx, sizeof(s_uart.rx), 0);
+            if (len <= 0) {
+                break;
+            }
+            s_uart.rx_len = len;
+            s_uart.rx_off = 0;
+            s_uart.stats.bytes_received += len;
+        }
+        s_uart.rx_off += rtcm3_framer_push(&s_uart.framer, s_uart.rx + s_uart.rx_off,
+                                           s_uart.rx_len - s_uart.rx_off,
+                                           &s_uart.frame, &s_uart.frame_pending);
+    }
+
+    if (!s_uart.frame_pending) {
+        return NULL;
+    }
+    s_uart.last_frame_ms = now_ms();
+    s_uart.have_frame = true;
+    return &s_uart.frame;
+}
+
+static void source_consume(void *ctx)
+{
+    (void)ctx;
+    s_uart.frame_pending = false;
+    s_uart.stats.frames = s_uart.framer.frames;
+    s_uart.stats.crc_errors = s_uart.framer.crc_errors;
+}
+
+static bool source_is_up(void *ctx)
+{
+    (void)ctx;
+    return s_uart.have_frame && now_ms() - s_uart.last_frame_ms < CORR_UART_TIMEOUT_MS;
+}
+
+esp_err_t corr_uart_init(void)
+{
+#if !CORR_UART_ENABLED
+    return ESP_OK;
+#endif
+
+    uart_config_t config = {
+        .baud_rate = CORR_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t err = uart_driver_install(CORR_UART_NUM, CORR_UART_RING_SIZE, 0,
+                                        CORR_UART_EVENT_DEPTH, &s_uart.events, 0);
+    if (err == ESP_OK) {
+        err = uart_param_config(CORR_UART_NUM, &config);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_pin(CORR_UART_NUM, CORR_UART_TX_PIN, CORR_UART_RX_PIN,
+                           UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "UART%d setup failed: %s", CORR_UART_NUM, esp_err_to_name(err));
+        return err;
+    }
+
+    rtcm3_framer_init(&s_uart.framer);
+    s_uart.installed = true;
+
+    s_source.name = "radio";
+    s_source.ctx = NULL;
+    s_source.is_up = source_is_up;
+    s_source.peek = source_peek;
+    s_source.consume = source_consume;
+    s_source.drop = NULL;  // Nothing to reconnect
+
+    ESP_LOGI(TAG, "Radio RTCM input on UART%d (RX GPIO%d, %d baud)",
+             CORR_UART_NUM, CORR_UART_RX_PIN, CORR_UART_BAUD);
+    return ESP_OK;
+}
+
+const corr_source_t *corr_uart_source(void)
+{
+    return s_uart.installed ? &s_source : NULL;
+}
+
+void corr_uart_get_stats(corr_uart_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_uart.stats;
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * Correction UART - RTCM from a local radio (UHF, LoRa) on a serial port
+ *
+ * The UART driver fills its RX ring buffer from the interrupt handler; the
+ * rover loop drains it without blocking and splits it into RTCM frames.
+ */
+
+#ifndef CORR_UART_H
+#define CORR_UART_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include "corr_source.h"
+
+/**
+ * Radio link statistics
+ */
+typedef struct {
+    uint32_t bytes_received;
+    uint32_t frames;            // Valid RTCM frames
+    uint32_t crc_errors;        // Frames rejected on CRC (radio bit errors)
+    uint32_t overflows;         // RX ring buffer overruns (bytes lost)
+} corr_uart_stats_t;
+
+/**
+ * Install the UART driver (no-op unless CORR_UART_ENABLED)
+ */
+esp_err_t corr_uart_init(void);
+
+/**
+ * Get the radio as a correction source
+ * @return NULL if the UART source is disabled
+ */
+const corr_source_t *corr_uart_source(void);
+
+/**
+ * Get radio link statistics
+ */
+void corr_uart_get_stats(corr_uart_stats_t *stats);
+
+#endif // CORR_UART_H
@@ -1,62 +1,226 @@
 /**
  * Dashboard Client - Sends position data to web dashboard via HTTP POST
+ *
+ * Samples are collected into a preallocated batch and sent as one POST:
+ * a JSON array (a plain object for a single sample), or concatenated
+ * binary samples. The caller flushes on its deadline; a batch that is full
+ * by DASHBOARD_BATCH_MAX_SAMPLES or DASHBOARD_BATCH_MAX_BYTES is flushed
+ * before the next sample is added.
+ *
+ * One HTTP/1.1 keep-alive connection carries all updates, so a batch
+ * costs one request and one response instead of a TCP handshake, slow
+ * start and teardown each time. Requests are pipelined: up to
+ * DASHBOARD_MAX_IN_FLIGHT may be outstanding, and responses are parsed
+ * incrementally (status line, then Content-Length bytes of body) as they
+ * arrive, in request order.
+ *
+ * With DASHBOARD_BINARY the body is a telemetry_codec sample (~16 bytes
+ * instead of ~350 of JSON); every new connection and every error response
+ * restarts the delta chain with a keyframe.
+ *
+ * When the connection drops it is reopened on the next update. A request
+ * that fails to send on a reused connection (the server closed it while
+ * idle) is retried once on a fresh one; requests whose responses were
+ * still outstanding are counted as lost, not resent. A batch that can't be
+ * sent at all goes to the telemetry store, and comes back later as a
+ * backfill request on the same connection (see telemetry.c).
  */
 
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
 #include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <errno.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "dashboard_client.h"
+#include "telemetry_codec.h"
+#include "telemetry_store.h"
+#include "telemetry.h"
+#include "dns_resolver.h"
 #include "config.h"
-#include "ota_update.h"
 
 static const char *TAG = "dashboard";
 
-esp_err_t dashboard_send_position(const zed_position_t *pos,
-                                   uint32_t rtcm_bytes,
-                                   uint32_t fixed_count,
-                                   uint32_t float_count,
-                                   int battery_percentage)
-{
-#if !DASHBOARD_ENABLED
-    return ESP_OK;
+#ifndef DASHBOARD_BINARY
+#define DASHBOARD_BINARY 0
+#endif
+#ifndef DASHBOARD_BINARY_PATH
+#define DASHBOARD_BINARY_PATH "/api/position/bin"
 #endif
 
-    if (pos == NULL) {
-        return ESP_ERR_INVALID_ARG;
+#if DASHBOARD_BINARY
+#define DASHBOARD_BODY_PATH DASHBOARD_BINARY_PATH
+#define DASHBOARD_BODY_TYPE "application/octet-stream"
+#else
+#define DASHBOARD_BODY_PATH DASHBOARD_PATH
+#define DASHBOARD_BODY_TYPE "application/json"
+#endif
+
+#ifndef DASHBOARD_BACKFILL_PATH
+#define DASHBOARD_BACKFILL_PATH "/api/position/backfill"
+#endif
+
+#ifndef DASHBOARD_BATCH_MAX_BYTES
+#define DASHBOARD_BATCH_MAX_BYTES 4096
+#endif
+
+#if DASHBOARD_BINARY
+#define DASHBOARD_SAMPLE_MAX TELEMETRY_CODEC_MAX_SAMPLE
+#else
+#define DASHBOARD_SAMPLE_MAX 448                // One JSON object, with its comma
+#endif
+
+#define DASHBOARD_TIMEOUT_S       5
+#define DASHBOARD_HEADER_MAX      192
+#define DASHBOARD_BODY_OFFSET     (DASHBOARD_HEADER_MAX + 1)  // Header, then '[' for arrays
+#define DASHBOARD_LINE_MAX        128     // Longer header lines are skipped, not parsed
+#define DASHBOARD_LATENCY_SAMPLES 32      // Window for the median POST latency
+
+typedef enum {
+    RESP_STATUS,
+    RESP_HEADERS,
+    RESP_BODY,
+} resp_state_t;
+
+static struct {
+    int sock;                                   // -1 when closed
+    uint32_t requests;                          // Sent on this connection
+    int64_t sent_us[DASHBOARD_MAX_IN_FLIGHT];   // Send times of outstanding requests
+    bool backfill[DASHBOARD_MAX_IN_FLIGHT];     // Which of them is the backfill request
+    uint32_t samples[DASHBOARD_MAX_IN_FLIGHT];  // Records kept for each live batch
+    int oldest;
+    int in_flight;
+
+    // Response parser
+    resp_state_t state;
+    char line[DASHBOARD_LINE_MAX];
+    size_t line_len;
+    int status;
+    int32_t content_length;                     // -1 if not given
+    bool chunked;
+    bool close_after;
+    uint32_t body_left;
+} s_conn = { .sock = -1 };
+
+// Records of the live batches awaiting a response, by pipeline slot. They
+// go to the telemetry store unless a 2xx arrives - a batch lost with the
+// connection may have reached the server, so it can be stored twice.
+static telemetry_record_t s_sent_records[DASHBOARD_MAX_IN_FLIGHT][DASHBOARD_BATCH_MAX_SAMPLES];
+static bool s_uplink_ok = false;        // Last live batch with a known outcome got a 2xx
+
+static uint32_t s_latency_ms[DASHBOARD_LATENCY_SAMPLES];
+static uint32_t s_latency_count = 0;
+
+static const uint32_t k_latency_bounds_ms[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+static dashboard_stats_t s_stats = {
+    .latency_ms = { .bounds = k_latency_bounds_ms,
+                    .num_bounds = sizeof(k_latency_bounds_ms) / sizeof(k_latency_bounds_ms[0]) },
+};
+static telemetry_backfill_t s_backfill = TELEMETRY_BACKFILL_IDLE;
+static telemetry_codec_t s_codec;      // Delta state of the binary format
+static uint32_t s_codec_generation;    // Bumped on every codec reset
+
+// The batch waiting to be sent. Records are kept alongside the encoded body
+// so a binary batch can be re-encoded if the delta chain is restarted.
+static struct {
+    telemetry_record_t records[DASHBOARD_BATCH_MAX_SAMPLES];
+    uint32_t count;
+    size_t body_len;
+    uint32_t generation;               // s_codec_generation the body was encoded in
+} s_batch;
+
+// Request buffer: header space, then the body (with room for a keyframe
+// more on re-encode, and the closing ']')
+static char s_buf[DASHBOARD_BODY_OFFSET + DASHBOARD_BATCH_MAX_BYTES + TELEMETRY_CODEC_MAX_SAMPLE + 1];
+
+static void parser_reset(void)
+{
+    s_conn.state = RESP_STATUS;
+    s_conn.line_len = 0;
+    s_conn.status = 0;
+    s_conn.content_length = -1;
+    s_conn.chunked = false;
+    s_conn.close_after = false;
+    s_conn.body_left = 0;
+}
+
+/**
+ * A live batch wasn't delivered - keep its samples for backfill
+ */
+static void store_batch(const telemetry_record_t *records, uint32_t count)
+{
+    s_stats.failures++;
+    s_stats.samples_stored += count;
+    telemetry_store_append(records, count);
+    s_uplink_ok = false;
+}
+
+static void conn_close(const char *reason)
+{
+    if (s_conn.sock < 0) {
+        return;
     }
+    if (s_conn.in_flight > 0) {
+        ESP_LOGW(TAG, "Connection closed (%s), %d responses lost", reason, s_conn.in_flight);
+        s_stats.lost += s_conn.in_flight;
+        if (s_backfill == TELEMETRY_BACKFILL_IN_FLIGHT) {
+            s_backfill = TELEMETRY_BACKFILL_FAILED;
+        }
+        for (int i = 0; i < s_conn.in_flight; i++) {
+            int slot = (s_conn.oldest + i) % DASHBOARD_MAX_IN_FLIGHT;
+            if (!s_conn.backfill[slot]) {
+                store_batch(s_sent_records[slot], s_conn.samples[slot]);
+            }
+        }
+    } else {
+        ESP_LOGD(TAG, "Connection closed (%s) after %lu requests",
+                 reason, (unsigned long)s_conn.requests);
+    }
+    close(s_conn.sock);
+    s_conn.sock = -1;
+    s_conn.in_flight = 0;
+    s_conn.oldest = 0;
+    parser_reset();
+}
 
-    // Resolve hostname
-    struct hostent *host = gethostbyname(DASHBOARD_HOST);
-    if (host == NULL) {
-        ESP_LOGW(TAG, "DNS lookup failed for %s", DASHBOARD_HOST);
+static esp_err_t conn_open(void)
+{
+    // Resolve hostname from the cache - never block on DNS
+    struct in_addr host_addr;
+    esp_err_t dns_err = dns_resolver_lookup(DASHBOARD_HOST, &host_addr, 0);
+    if (dns_err != ESP_OK) {
+        ESP_LOGW(TAG, "DNS lookup for %s not ready: %s", DASHBOARD_HOST, esp_err_to_name(dns_err));
         return ESP_FAIL;
     }
 
-    // Create socket
     int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (sock < 0) {
         ESP_LOGW(TAG, "Failed to create socket: errno %d", errno);
         return ESP_FAIL;
     }
 
-    // Set timeout
     struct timeval timeout = {
-        .tv_sec = 5,
+        .tv_sec = DASHBOARD_TIMEOUT_S,
         .tv_usec = 0
     };
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
 
-    // Connect
+    // A pipelined request must not wait for the previous one to be ACKed
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
     struct sockaddr_in server_addr = {
         .sin_family = AF_INET,
         .sin_port = htons(DASHBOARD_PORT),
-        .sin_addr = *((struct in_addr *)host->h_addr),
+        .sin_addr = host_addr,
     };
 
     if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) != 0) {
@@ -65,76 +229,475 @@ esp_err_t dashboard_send_position(const zed_position_t *pos,
         return ESP_FAIL;
     }
 
-    // Build JSON payload
-    char json[512];
-    int json_len = snprintf(json, sizeof(json),
-        "{"
-        "\"latitude\":%.9f,"
-        "\"longitude\":%.9f,"
-        "\"altitude\":%.3f,"
-        "\"h_acc\":%.4f,"
-        "\"v_acc\":%.4f,"
-        "\"fix_type\":%d,"
-        "\"carr_soln\":%d,"
-        "\"num_sv\":%d,"
-        "\"rtcm_bytes\":%lu,"
-        "\"fixed_count\":%lu,"
-        "\"float_count\":%lu,"
-        "\"hour\":%d,"
-        "\"min\":%d,"
-        "\"sec\":%d,"
-        "\"battery_pct\":%d,"
-        "\"firmware_version\":\"%s\""
-        "}",
-        pos->latitude,
-        pos->longitude,
-        pos->altitude_msl,
-        pos->h_acc,
-        pos->v_acc,
-        pos->fix_type,
-        pos->carr_soln,
-        pos->num_sv,
-        (unsigned long)rtcm_bytes,
-        (unsigned long)fixed_count,
-        (unsigned long)float_count,
-        pos->hour,
-        pos->min,
-        pos->sec,
-        battery_percentage,
-        ota_get_version()
-    );
+    s_conn.sock = sock;
+    s_conn.requests = 0;
+    s_conn.in_flight = 0;
+    s_conn.oldest = 0;
+    parser_reset();
+    telemetry_codec_reset(&s_codec);  // The server may have missed samples - start with a keyframe
+    s_codec_generation++;
+    s_stats.connections++;
+    return ESP_OK;
+}
+
+static void record_latency(uint32_t ms)
+{
+    s_latency_ms[s_latency_count % DASHBOARD_LATENCY_SAMPLES] = ms;
+    s_latency_count++;
+    metrics_histogram_observe(&s_stats.latency_ms, ms);
+}
+
+/**
+ * A whole response has been read - match it to the oldest request
+ * @return false if the connection had to be closed
+ */
+static bool response_done(void)
+{
+    if (s_conn.in_flight == 0) {
+        conn_close("unsolicited response");
+        return false;
+    }
+
+    int slot = s_conn.oldest;
+    int64_t sent_us = s_conn.sent_us[slot];
+    bool backfill = s_conn.backfill[slot];
+    s_conn.oldest = (s_conn.oldest + 1) % DASHBOARD_MAX_IN_FLIGHT;
+    s_conn.in_flight--;
+    s_stats.responses++;
+    record_latency((uint32_t)((esp_timer_get_time() - sent_us) / 1000));
+
+    bool ok = s_conn.status >= 200 && s_conn.status <= 299;
+    if (!ok) {
+        ESP_LOGW(TAG, "Dashboard returned %d%s", s_conn.status, backfill ? " to backfill" : "");
+        s_stats.http_errors++;
+    }
+    if (backfill) {
+        s_backfill = ok ? TELEMETRY_BACKFILL_DONE : TELEMETRY_BACKFILL_FAILED;
+    } else if (!ok) {
+        store_batch(s_sent_records[slot], s_conn.samples[slot]);
+        telemetry_codec_reset(&s_codec);  // A rejected sample breaks the delta chain
+        s_codec_generation++;
+    } else {
+        s_uplink_ok = true;
+    }
+
+    bool close_after = s_conn.close_after;
+    parser_reset();
+    if (close_after) {
+        conn_close("server closing");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Case-insensitive search for a token in a header value
+ */
+static bool header_has(const char *value, const char *token)
+{
+    size_t n = strlen(token);
+    for (; *value != '\0'; value++) {
+        if (strncasecmp(value, token, n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Handle one status or header line (CR/LF already stripped)
+ * @return false if the connection had to be closed
+ */
+static bool parse_line(const char *line)
+{
+    if (s_conn.state == RESP_STATUS) {
+        if (strncmp(line, "HTTP/1.", 7) != 0 || strlen(line) < 12) {
+            conn_close("bad status line");
+            return false;
+        }
+        s_conn.status = atoi(line + 9);
+        s_conn.state = RESP_HEADERS;
+        return true;
+    }
+
+    if (line[0] != '\0') {
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            s_conn.content_length = atoi(line + 15);
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            s_conn.close_after = header_has(line + 11, "close");
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            s_conn.chunked = header_has(line + 18, "chunked");
+        }
+        return true;
+    }
+
+    // End of headers. 1xx responses are followed by the real one.
+    if (s_conn.status >= 100 && s_conn.status < 200) {
+        parser_reset();
+        return true;
+    }
+    if (s_conn.chunked || s_conn.content_length < 0) {
+        // No way to find where the next response starts - finish this one
+        // and let the connection go
+        s_conn.close_after = true;
+        return response_done();
+    }
+    if (s_conn.content_length == 0) {
+        return response_done();
+    }
+    s_conn.body_left = s_conn.content_length;
+    s_conn.state = RESP_BODY;
+    return true;
+}
+
+/**
+ * Feed received bytes through the response parser
+ */
+static void parse_input(const char *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len && s_conn.sock >= 0) {
+        if (s_conn.state == RESP_BODY) {
+            size_t n = len - i < s_conn.body_left ? len - i : s_conn.body_left;
+            s_conn.body_left -= n;
+            i += n;
+            if (s_conn.body_left == 0) {
+                response_done();
+            }
+            continue;
+        }
+
+        char c = data[i++];
+        if (c == '\n') {
+            if (s_conn.line_len > 0 && s_conn.line[s_conn.line_len - 1] == '\r') {
+                s_conn.line_len--;
+            }
+            s_conn.line[s_conn.line_len] = '\0';
+            s_conn.line_len = 0;
+            parse_line(s_conn.line);
+        } else if (s_conn.line_len < sizeof(s_conn.line) - 1) {
+            s_conn.line[s_conn.line_len++] = c;
+        }
+    }
+}
+
+/**
+ * Read whatever the server has sent; with wait_ms, wait for the oldest
+ * outstanding response to complete
+ */
+static void read_responses(uint32_t wait_ms)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)wait_ms * 1000;
+    int target = s_conn.in_flight - 1;
+    char buf[256];
+
+    while (s_conn.sock >= 0) {
+        int len = recv(s_conn.sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len > 0) {
+            s_stats.bytes_received += len;
+            parse_input(buf, len);
+            continue;
+        }
+        if (len == 0) {
+            conn_close("closed by server");
+            return;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            conn_close("receive error");
+            return;
+        }
+
+        // Nothing buffered - wait for more only if asked to
+        int64_t left_us = deadline - esp_timer_get_time();
+        if (wait_ms == 0 || s_conn.in_flight <= target || s_conn.in_flight == 0 || left_us <= 0) {
+            return;
+        }
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(s_conn.sock, &rfds);
+        struct timeval tv = {
+            .tv_sec = left_us / 1000000,
+            .tv_usec = left_us % 1000000,
+        };
+        if (select(s_conn.sock + 1, &rfds, NULL, NULL, &tv) <= 0) {
+            return;
+        }
+    }
+}
 
-    // Build HTTP request
-    char request[768];
-    int req_len = snprintf(request, sizeof(request),
+/**
+ * Book a request that has been written in full
+ * @param records  Samples of a live batch (NULL for backfill), kept until
+ *                 its response
+ */
+static void request_sent(size_t len, const telemetry_record_t *records, uint32_t count)
+{
+    int slot = (s_conn.oldest + s_conn.in_flight) % DASHBOARD_MAX_IN_FLIGHT;
+    s_conn.sent_us[slot] = esp_timer_get_time();
+    s_conn.backfill[slot] = records == NULL;
+    s_conn.samples[slot] = count;
+    if (records != NULL) {
+        memcpy(s_sent_records[slot], records, count * sizeof(records[0]));
+    }
+    s_conn.in_flight++;
+    s_conn.requests++;
+    s_stats.bytes_sent += len;
+    if (s_conn.in_flight > s_stats.max_in_flight) {
+        s_stats.max_in_flight = s_conn.in_flight;
+    }
+}
+
+uint32_t dashboard_poll(uint32_t wait_ms)
+{
+    read_responses(wait_ms);
+    return s_conn.in_flight;
+}
+
+/**
+ * Append one sample to the batch body: a JSON object (comma separated),
+ * or a binary sample with DASHBOARD_BINARY
+ */
+static void append_record(const telemetry_record_t *rec)
+{
+    char *out = s_buf + DASHBOARD_BODY_OFFSET + s_batch.body_len;
+#if DASHBOARD_BINARY
+    s_batch.body_len += telemetry_codec_encode(&s_codec, rec, (uint8_t *)out);
+#else
+    size_t room = DASHBOARD_SAMPLE_MAX;
+    if (s_batch.body_len > 0) {
+        *out++ = ',';
+        s_batch.body_len++;
+        room--;
+    }
+    int len = telemetry_codec_format_json(rec, out, room);
+    s_batch.body_len += len < (int)room ? len : room - 1;
+#endif
+}
+
+/**
+ * Encode the whole batch again from a fresh delta chain
+ * Needed when the codec was reset (new connection, error response) after
+ * part of the batch was encoded against the old chain.
+ */
+static void reencode_batch(void)
+{
+    telemetry_codec_reset(&s_codec);
+    s_codec_generation++;
+    s_batch.body_len = 0;
+    for (uint32_t i = 0; i < s_batch.count; i++) {
+        append_record(&s_batch.records[i]);
+    }
+    s_batch.generation = s_codec_generation;
+}
+
+uint32_t dashboard_batch_count(void)
+{
+    return s_batch.count;
+}
+
+esp_err_t dashboard_flush(void)
+{
+#if !DASHBOARD_ENABLED
+    return ESP_OK;
+#endif
+
+    if (s_batch.count == 0) {
+        return ESP_OK;
+    }
+
+    // Collect finished responses, and notice if the server closed an idle connection
+    read_responses(0);
+    if (s_conn.in_flight >= DASHBOARD_MAX_IN_FLIGHT) {
+        read_responses(DASHBOARD_TIMEOUT_S * 1000);
+        if (s_conn.in_flight >= DASHBOARD_MAX_IN_FLIGHT) {
+            conn_close("response timeout");
+        }
+    }
+
+    // Send, retrying once if a reused connection turns out to be dead
+    esp_err_t result = ESP_FAIL;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (s_conn.sock < 0 && conn_open() != ESP_OK) {
+            break;
+        }
+        if (s_batch.generation != s_codec_generation) {
+            reencode_batch();
+        }
+
+        // A single JSON sample goes as a plain object, several as an array
+        bool array = !DASHBOARD_BINARY && s_batch.count > 1;
+        char *body = s_buf + DASHBOARD_BODY_OFFSET;
+        size_t body_len = s_batch.body_len;
+        if (array) {
+            *--body = '[';
+            body[++body_len] = ']';
+            body_len++;
+        }
+
+        // Header goes in the space reserved in front of the body
+        char header[DASHBOARD_HEADER_MAX];
+        int hdr_len = snprintf(header, sizeof(header),
+            "POST %s HTTP/1.1\r\n"
+            "Host: %s:%d\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Length: %u\r\n"
+            "\r\n",
+            DASHBOARD_BODY_PATH, DASHBOARD_HOST, DASHBOARD_PORT,
+            DASHBOARD_BODY_TYPE, (unsigned)body_len
+        );
+        if (hdr_len < 0 || hdr_len >= (int)sizeof(header)) {
+            ESP_LOGE(TAG, "Request header exceeds %d bytes", DASHBOARD_HEADER_MAX);
+            break;  // Would overrun the space reserved in front of the body
+        }
+        char *request = body - hdr_len;
+        memcpy(request, header, hdr_len);
+        size_t req_len = hdr_len + body_len;
+
+        bool reused = s_conn.requests > 0;
+        int sent = send(s_conn.sock, request, req_len, 0);
+        if (sent == (int)req_len) {
+            request_sent(req_len, s_batch.records, s_batch.count);
+            s_stats.posts++;
+            s_stats.samples += s_batch.count;
+            result = ESP_OK;
+            break;
+        }
+
+        ESP_LOGW(TAG, "Failed to send: errno %d", errno);
+        if (sent > 0) {
+            s_stats.bytes_sent += sent;
+        }
+        conn_close("send error");
+        if (!reused) {
+            break;
+        }
+    }
+
+    if (result != ESP_OK) {
+        store_batch(s_batch.records, s_batch.count);
+    }
+    s_batch.count = 0;
+    s_batch.body_len = 0;
+    return result;
+}
+
+esp_err_t dashboard_add_position(const zed_position_t *pos,
+                                 uint32_t rtcm_bytes,
+                                 uint32_t fixed_count,
+                                 uint32_t float_count,
+                                 int battery_percentage)
+{
+#if !DASHBOARD_ENABLED
+    return ESP_OK;
+#endif
+
+    if (pos == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Full by count or size - send what we have first
+    esp_err_t err = ESP_OK;
+    if (s_batch.count >= DASHBOARD_BATCH_MAX_SAMPLES ||
+        s_batch.body_len + DASHBOARD_SAMPLE_MAX > DASHBOARD_BATCH_MAX_BYTES) {
+        err = dashboard_flush();
+    }
+
+    if (s_batch.count == 0) {
+        s_batch.generation = s_codec_generation;
+    }
+    telemetry_record_t *rec = &s_batch.records[s_batch.count++];
+    telemetry_make_record(rec, pos, rtcm_bytes, fixed_count, float_count, battery_percentage);
+    append_record(rec);
+    return err;
+}
+
+esp_err_t dashboard_send_backfill(const uint8_t *body, size_t len)
+{
+#if !DASHBOARD_ENABLED
+    return ESP_OK;
+#endif
+
+    if (body == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_backfill == TELEMETRY_BACKFILL_IN_FLIGHT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Never wait for a response slot - live batches come first
+    read_responses(0);
+    if (s_conn.in_flight >= DASHBOARD_MAX_IN_FLIGHT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_conn.sock < 0 && conn_open() != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    char header[DASHBOARD_HEADER_MAX];
+    int hdr_len = snprintf(header, sizeof(header),
         "POST %s HTTP/1.1\r\n"
         "Host: %s:%d\r\n"
-        "Content-Type: application/json\r\n"
-        "Content-Length: %d\r\n"
-        "Connection: close\r\n"
-        "\r\n"
-        "%s",
-        DASHBOARD_PATH, DASHBOARD_HOST, DASHBOARD_PORT, json_len, json
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: %u\r\n"
+        "\r\n",
+        DASHBOARD_BACKFILL_PATH, DASHBOARD_HOST, DASHBOARD_PORT, (unsigned)len
     );
-
-    // Send request
-    if (send(sock, request, req_len, 0) < 0) {
-        ESP_LOGW(TAG, "Failed to send: errno %d", errno);
-        close(sock);
+    if (hdr_len < 0 || hdr_len >= (int)sizeof(header)) {
+        ESP_LOGE(TAG, "Backfill header exceeds %d bytes", DASHBOARD_HEADER_MAX);
         return ESP_FAIL;
     }
 
-    // Read response (just check for success, don't parse)
-    char response[128];
-    int len = recv(sock, response, sizeof(response) - 1, 0);
-    if (len > 0) {
-        response[len] = '\0';
-        // Check for 200 OK
-        if (strstr(response, "200") == NULL) {
-            ESP_LOGW(TAG, "Dashboard returned error");
+    // Header and body go out in the same segments
+    int sent = send(s_conn.sock, header, hdr_len, MSG_MORE);
+    if (sent == hdr_len) {
+        sent = send(s_conn.sock, body, len, 0);
+        if (sent == (int)len) {
+            request_sent(hdr_len + len, NULL, 0);
+            s_stats.backfill_posts++;
+            s_stats.backfill_bytes += len;
+            s_backfill = TELEMETRY_BACKFILL_IN_FLIGHT;
+            return ESP_OK;
         }
     }
 
-    close(sock);
-    return ESP_OK;
+    ESP_LOGW(TAG, "Failed to send backfill: errno %d", errno);
+    conn_close("send error");
+    return ESP_FAIL;
+}
+
+bool dashboard_uplink_ok(void)
+{
+    return s_uplink_ok;
+}
+
+telemetry_backfill_t dashboard_backfill_result(void)
+{
+    telemetry_backfill_t result = s_backfill;
+    if (result != TELEMETRY_BACKFILL_IN_FLIGHT) {
+        s_backfill = TELEMETRY_BACKFILL_IDLE;
+    }
+    return result;
+}
+
+void dashboard_get_stats(dashboard_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+
+    // Median over the last DASHBOARD_LATENCY_SAMPLES responses
+    uint32_t n = s_latency_count < DASHBOARD_LATENCY_SAMPLES ? s_latency_count : DASHBOARD_LATENCY_SAMPLES;
+    uint32_t sorted[DASHBOARD_LATENCY_SAMPLES];
+    memcpy(sorted, s_latency_ms, n * sizeof(sorted[0]));
+    for (uint32_t i = 1; i < n; i++) {
+        uint32_t v = sorted[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    stats->median_latency_ms = n > 0 ? sorted[n / 2] : 0;
 }
@@ -6,21 +6,104 @@
 #define DASHBOARD_CLIENT_H
 
 #include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
 #include "zed_rover.h"
+#include "telemetry_store.h"
+#include "metrics.h"
+
+#define DASHBOARD_MAX_IN_FLIGHT 4   // Pipelined requests awaiting a response
+
+#ifndef DASHBOARD_BATCH_MAX_SAMPLES
+#define DASHBOARD_BATCH_MAX_SAMPLES 32  // Samples per POST
+#endif
 
 /**
- * Send position update to dashboard server
+ * Upload statistics (payload bytes, not counting TCP/IP headers)
+ */
+typedef struct {
+    uint32_t posts;             // Requests (batches) sent
+    uint32_t samples;           // Samples in those requests
+    uint32_t failures;          // Batches not delivered: send failed, error status or lost
+    uint32_t samples_stored;    // Samples in those batches, handed to the telemetry store
+    uint32_t responses;
+    uint32_t http_errors;       // Non-2xx responses
+    uint32_t lost;              // Sent, but the connection closed before the response
+    uint32_t connections;       // TCP connections opened (posts / connections = reuse)
+    uint32_t max_in_flight;
+    uint32_t median_latency_ms; // Request sent to response complete, last 32 responses
+    metrics_histogram_t latency_ms; // The same, over all responses
+    uint32_t backfill_posts;    // Stored samples sent later
+    uint32_t backfill_bytes;
+    uint32_t bytes_sent;
+    uint32_t bytes_received;
+} dashboard_stats_t;
+
+/**
+ * Add a position sample to the current batch
+ * If the batch is already full it is flushed first, so this can block
+ * like dashboard_flush() - the rover loop goes through telemetry_enqueue().
  * @param pos Position data from ZED-X20P
  * @param rtcm_bytes Total RTCM bytes received
  * @param fixed_count Number of RTK Fixed solutions
  * @param float_count Number of RTK Float solutions
  * @param battery_percentage Battery level 0-100 (-1 if unavailable)
- * @return ESP_OK on success
+ * @return ESP_OK, or the error of the flush it triggered
+ */
+esp_err_t dashboard_add_position(const zed_position_t *pos,
+                                 uint32_t rtcm_bytes,
+                                 uint32_t fixed_count,
+                                 uint32_t float_count,
+                                 int battery_percentage);
+
+/**
+ * Get the number of samples waiting in the batch
+ */
+uint32_t dashboard_batch_count(void);
+
+/**
+ * Send the batch as one POST (no-op if empty)
+ * Returns once the request is written; the response is collected later by
+ * dashboard_poll(). Can block for a connect, or for a response when
+ * DASHBOARD_MAX_IN_FLIGHT requests are outstanding (up to 5 s each).
+ * The batch is emptied either way. Its samples go to the telemetry store
+ * if it can't be sent, and later if the server answers with an error or
+ * the connection closes before the response.
+ */
+esp_err_t dashboard_flush(void);
+
+/**
+ * Send stored samples (a telemetry_codec stream) to DASHBOARD_BACKFILL_PATH
+ * Pipelined behind live batches on the same connection. Only one backfill
+ * request may be outstanding; its outcome is read with
+ * dashboard_backfill_result(). Unlike dashboard_flush() this never waits
+ * for a response slot.
+ * @return ESP_ERR_INVALID_STATE if a backfill or all slots are outstanding
+ */
+esp_err_t dashboard_send_backfill(const uint8_t *body, size_t len);
+
+/**
+ * Check if the last live batch whose outcome is known got a 2xx
+ * False until the first one does, and after any batch is stored.
+ */
+bool dashboard_uplink_ok(void);
+
+/**
+ * Get the outcome of the backfill request
+ * DONE and FAILED are reported once, then the state returns to IDLE.
+ */
+telemetry_backfill_t dashboard_backfill_result(void);
+
+/**
+ * Read responses to outstanding requests
+ * @param wait_ms Wait up to this long for the oldest response (0 = don't wait)
+ * @return Requests still awaiting a response
+ */
+uint32_t dashboard_poll(uint32_t wait_ms);
+
+/**
+ * Get upload statistics
  */
-esp_err_t dashboard_send_position(const zed_position_t *pos,
-                                   uint32_t rtcm_bytes,
-                                   uint32_t fixed_count,
-                                   uint32_t float_count,
-                                   int battery_percentage);
+void dashboard_get_stats(dashboard_stats_t *stats);
 
 #endif // DASHBOARD_CLIENT_H
@@ -0,0 +1,309 @@
+/**
+ * DNS Resolver - Shared asynchronous hostname cache
+ *
+ * A small fixed table of hostnames is kept with their last good address.
+ * Lookups never touch the network: misses and expired entries are handed
+ * to a background task which does the blocking getaddrinfo() call.
+ *
+ * Entry lifetime:
+ *   - fresh for DNS_CACHE_TTL_MS after a successful query
+ *   - then served stale (while a refresh runs) for up to DNS_STALE_MAX_MS,
+ *     which keeps us connected when the upstream DNS server is down
+ *   - failed queries are cached for DNS_NEGATIVE_TTL_MS
+ */
+
+#include <string.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "dns_resolver.h"
+#include "config.h"
+
+static const char *TAG = "dns";
+
+#ifndef DNS_CACHE_TTL_MS
+#define DNS_CACHE_TTL_MS (5 * 60 * 1000)        // Positive entries
+#endif
+#ifndef DNS_NEGATIVE_TTL_MS
+#define DNS_NEGATIVE_TTL_MS 30000               // Failed lookups
+#endif
+#ifndef DNS_STALE_MAX_MS
+#define DNS_STALE_MAX_MS (24 * 60 * 60 * 1000)  // Serve stale this long at most
+#endif
+
+#define DNS_CACHE_SIZE    4
+#define DNS_HOSTNAME_MAX  64
+#define DNS_QUEUE_LEN     DNS_CACHE_SIZE
+#define DNS_WAIT_POLL_MS  10
+
+typedef enum {
+    DNS_ENTRY_EMPTY = 0,
+    DNS_ENTRY_PENDING,      // First query in flight, no address yet
+    DNS_ENTRY_VALID,        // Have an address (may be past its TTL)
+    DNS_ENTRY_NEGATIVE,     // Last query failed and we have no address
+} dns_entry_state_t;
+
+typedef struct {
+    char hostname[DNS_HOSTNAME_MAX];
+    struct in_addr addr;
+    dns_entry_state_t state;
+    bool refreshing;        // Query queued or in flight
+    TickType_t resolved_at; // Last successful query
+    TickType_t failed_at;   // Last failed query
+    TickType_t last_used;
+} dns_entry_t;
+
+static dns_entry_t s_cache[DNS_CACHE_SIZE];
+static SemaphoreHandle_t s_mutex = NULL;
+static QueueHandle_t s_queue = NULL;
+static dns_resolver_stats_t s_stats = {0};
+
+/**
+ * Find the entry for a hostname (mutex must be held)
+ */
+static dns_entry_t *find_entry(const char *hostname)
+{
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (s_cache[i].state != DNS_ENTRY_EMPTY &&
+            strcmp(s_cache[i].hostname, hostname) == 0) {
+            return &s_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Claim an empty or least recently used entry (mutex must be held)
+ */
+static dns_entry_t *alloc_entry(const char *hostname)
+{
+    dns_entry_t *victim = NULL;
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        dns_entry_t *e = &s_cache[i];
+        if (e->state == DNS_ENTRY_EMPTY) {
+            victim = e;
+            break;
+        }
+        if (e->refreshing) {
+            continue;  // Resolver task still owns this one
+        }
+        if (victim == NULL || (int32_t)(e->last_used - victim->last_used) < 0) {
+            victim = e;
+        }
+    }
+    if (victim == NULL) {
+        return NULL;
+    }
+
+    memset(victim, 0, sizeof(*victim));
+    strncpy(victim->hostname, hostname, sizeof(victim->hostname) - 1);
+    victim->state = DNS_ENTRY_PENDING;
+    return victim;
+}
+
+/**
+ * Hand an entry to the resolver task (mutex must be held)
+ */
+static void queue_refresh(dns_entry_t *e)
+{
+    if (e->refreshing) {
+        return;
+    }
+    uint8_t idx = (uint8_t)(e - s_cache);
+    if (xQueueSend(s_queue, &idx, 0) == pdTRUE) {
+        e->refreshing = true;
+    }
+}
+
+static void dns_resolver_task(void *pvParameters)
+{
+    uint8_t idx;
+    char hostname[DNS_HOSTNAME_MAX];
+
+    while (1) {
+        if (xQueueReceive(s_queue, &idx, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        strncpy(hostname, s_cache[idx].hostname, sizeof(hostname));
+        s_stats.queries++;
+        xSemaphoreGive(s_mutex);
+
+        struct addrinfo hints = {
+            .ai_family = AF_INET,
+            .ai_socktype = SOCK_STREAM,
+        };
+        struct addrinfo *res = NULL;
+        int err = getaddrinfo(hostname, NULL, &hints, &res);
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        dns_entry_t *e = &s_cache[idx];
+        TickType_t now = xTaskGetTickCount();
+        e->refreshing = false;
+
+        if (err == 0 && res != NULL) {
+            e->addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+            e->state = DNS_ENTRY_VALID;
+            e->resolved_at = now;
+            ESP_LOGD(TAG, "%s -> %s", hostname, inet_ntoa(e->addr));
+        } else {
+            s_stats.failures++;
+            e->failed_at = now;
+            if (e->state != DNS_ENTRY_VALID) {
+                e->state = DNS_ENTRY_NEGATIVE;
+            }
+            ESP_LOGW(TAG, "DNS lookup failed for %s (err %d)%s", hostname, err,
+                     e->state == DNS_ENTRY_VALID ? " - serving stale address" : "");
+        }
+        xSemaphoreGive(s_mutex);
+
+        if (res != NULL) {
+            freeaddrinfo(res);
+        }
+    }
+}
+
+esp_err_t dns_resolver_init(void)
+{
+    if (s_mutex != NULL) {
+        return ESP_OK;
+    }
+
+    s_mutex = xSemaphoreCreateMutex();
+    s_queue = xQueueCreate(DNS_QUEUE_LEN, sizeof(uint8_t));
+    if (s_mutex == NULL || s_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create resolver mutex/queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(dns_resolver_task, "dns_resolver", 4096, NULL, 4, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start resolver task");
+        return ESP_FAIL;
+    }
+
+    dns_resolver_prefetch(NTRIP_HOST);
+#if DASHBOARD_ENABLED
+    dns_resolver_prefetch(DASHBOARD_HOST);
+#endif
+    return ESP_OK;
+}
+
+/**
+ * Check a cache entry and decide what to return (mutex must be held)
+ * Returns true if the lookup is complete, with *result set.
+ */
+static bool check_entry(dns_entry_t *e, struct in_addr *addr, esp_err_t *result, bool count)
+{
+    TickType_t now = xTaskGetTickCount();
+    e->last_used = now;
+
+    switch (e->state) {
+        case DNS_ENTRY_VALID: {
+            TickType_t age = now - e->resolved_at;
+            if (age < pdMS_TO_TICKS(DNS_CACHE_TTL_MS)) {
+                if (count) s_stats.hits++;
+                *addr = e->addr;
+                *result = ESP_OK;
+                return true;
+            }
+            if (age < pdMS_TO_TICKS(DNS_STALE_MAX_MS)) {
+                // Stale-while-revalidate, but don't hammer a dead DNS server
+                bool recently_failed = e->failed_at != 0 &&
+                    (now - e->failed_at) < pdMS_TO_TICKS(DNS_NEGATIVE_TTL_MS) &&
+                    (int32_t)(e->failed_at - e->resolved_at) > 0;
+                if (!recently_failed) {
+                    queue_refresh(e);
+                }
+                if (count) s_stats.stale_hits++;
+                *addr = e->addr;
+                *result = ESP_OK;
+                return true;
+            }
+            // Too old to trust - treat as a miss
+            e->state = DNS_ENTRY_PENDING;
+            queue_refresh(e);
+            return false;
+        }
+
+        case DNS_ENTRY_NEGATIVE:
+            if ((now - e->failed_at) < pdMS_TO_TICKS(DNS_NEGATIVE_TTL_MS)) {
+                if (count) s_stats.negative_hits++;
+                *result = ESP_ERR_NOT_FOUND;
+                return true;
+            }
+            e->state = DNS_ENTRY_PENDING;
+            queue_refresh(e);
+            return false;
+
+        case DNS_ENTRY_PENDING:
+        default:
+            queue_refresh(e);
+            return false;
+    }
+}
+
+esp_err_t dns_resolver_lookup(const char *hostname, struct in_addr *addr, uint32_t wait_ms)
+{
+    if (hostname == NULL || addr == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (strlen(hostname) >= DNS_HOSTNAME_MAX) {
+        ESP_LOGE(TAG, "Hostname too long: %s", hostname);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t result = ESP_ERR_TIMEOUT;
+    bool done;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_stats.lookups++;
+    dns_entry_t *e = find_entry(hostname);
+    if (e == NULL) {
+        e = alloc_entry(hostname);
+    }
+    done = (e != NULL) && check_entry(e, addr, &result, true);
+    if (!done) {
+        s_stats.misses++;
+    }
+    xSemaphoreGive(s_mutex);
+
+    // Wait for the resolver task if the caller can afford to
+    TickType_t start = xTaskGetTickCount();
+    while (!done && (xTaskGetTickCount() - start) < pdMS_TO_TICKS(wait_ms)) {
+        vTaskDelay(pdMS_TO_TICKS(DNS_WAIT_POLL_MS));
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        e = find_entry(hostname);
+        if (e != NULL && e->state != DNS_ENTRY_PENDING) {
+            done = check_entry(e, addr, &result, false);
+        }
+        xSemaphoreGive(s_mutex);
+    }
+
+    return result;
+}
+
+void dns_resolver_prefetch(const char *hostname)
+{
+    struct in_addr unused;
+    dns_resolver_lookup(hostname, &unused, 0);
+}
+
+void dns_resolver_get_stats(dns_resolver_stats_t *stats)
+{
+    if (stats == NULL || s_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_mutex);
+}
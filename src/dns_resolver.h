@@ -0,0 +1,54 @@
+/**
+ * DNS Resolver - Shared asynchronous hostname cache
+ *
+ * Hostnames are resolved by a background task and cached with a TTL,
+ * so callers on the rover loop never block on a DNS timeout.
+ */
+
+#ifndef DNS_RESOLVER_H
+#define DNS_RESOLVER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <netdb.h>
+
+/**
+ * Resolver statistics
+ */
+typedef struct {
+    uint32_t lookups;       // Calls to dns_resolver_lookup()
+    uint32_t hits;          // Answered from a fresh cache entry
+    uint32_t stale_hits;    // Answered from an expired entry (revalidating)
+    uint32_t negative_hits; // Answered from a cached failure
+    uint32_t misses;        // No usable entry, caller had to wait or retry
+    uint32_t queries;       // Upstream DNS queries issued
+    uint32_t failures;      // Upstream DNS queries that failed
+} dns_resolver_stats_t;
+
+/**
+ * Start the resolver task and prefetch the configured hosts
+ */
+esp_err_t dns_resolver_init(void);
+
+/**
+ * Look up a hostname
+ * Returns a cached address immediately if one exists (even if expired, in
+ * which case a refresh is started in the background). Otherwise queues a
+ * query and waits up to wait_ms for it to complete.
+ * @return ESP_OK with addr filled, ESP_ERR_TIMEOUT if still resolving,
+ *         ESP_ERR_NOT_FOUND if the name recently failed to resolve
+ */
+esp_err_t dns_resolver_lookup(const char *hostname, struct in_addr *addr, uint32_t wait_ms);
+
+/**
+ * Start resolving a hostname in the background without waiting
+ */
+void dns_resolver_prefetch(const char *hostname);
+
+/**
+ * Get resolver statistics
+ */
+void dns_resolver_get_stats(dns_resolver_stats_t *stats);
+
+#endif // DNS_RESOLVER_H
@@ -0,0 +1,150 @@
+/**
+ * Fixed Format - Integer-only text formatting into a caller's buffer
+ *
+ * Digits are produced least significant first into a small stack buffer
+ * and copied out reversed. 32-bit values use 32-bit division, which the
+ * ESP32 does in hardware; only fmt_fixed64() needs the 64-bit helpers.
+ */
+
+#include <math.h>
+
+#include "fixed_format.h"
+
+static const uint32_t k_pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+void fmt_init(fmt_writer_t *w, char *buf, size_t max_len)
+{
+    w->buf = buf;
+    w->max_len = max_len;
+    w->len = 0;
+    w->overflow = false;
+}
+
+void fmt_char(fmt_writer_t *w, char c)
+{
+    if (w->len + 1 < w->max_len) {
+        w->buf[w->len++] = c;
+    } else {
+        w->overflow = true;
+    }
+}
+
+void fmt_str(fmt_writer_t *w, const char *s)
+{
+    while (*s) {
+        fmt_char(w, *s++);
+    }
+}
+
+void fmt_uint(fmt_writer_t *w, uint32_t value, int min_digits)
+{
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0 && n < (int)sizeof(tmp));
+    while (n < min_digits && n < (int)sizeof(tmp)) {
+        tmp[n++] = '0';
+    }
+    while (n > 0) {
+        fmt_char(w, tmp[--n]);
+    }
+}
+
+void fmt_int(fmt_writer_t *w, int32_t value)
+{
+    if (value < 0) {
+        fmt_char(w, '-');
+        fmt_uint(w, (uint32_t)(-(int64_t)value), 1);
+    } else {
+        fmt_uint(w, (uint32_t)value, 1);
+    }
+}
+
+void fmt_fixed(fmt_writer_t *w, int32_t value, int decimals)
+{
+    if (decimals < 0 || decimals > 9) {
+        decimals = 0;
+    }
+    uint32_t scale = k_pow10[decimals];
+    uint32_t a = value < 0 ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+    if (value < 0) {
+        fmt_char(w, '-');
+    }
+    fmt_uint(w, a / scale, 1);
+    if (decimals > 0) {
+        fmt_char(w, '.');
+        fmt_uint(w, a % scale, decimals);
+    }
+}
+
+void fmt_fixed64(fmt_writer_t *w, int64_t value, int decimals)
+{
+    if (decimals < 0 || decimals > 9) {
+        decimals = 0;
+    }
+    uint64_t scale = k_pow10[decimals];
+    uint64_t a = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    if (value < 0) {
+        fmt_char(w, '-');
+    }
+
+    // Integer part may not fit 32 bits: split it into two chunks
+    uint64_t whole = a / scale;
+    if (whole >= 1000000000) {
+        fmt_uint(w, (uint32_t)(whole / 1000000000), 1);
+        fmt_uint(w, (uint32_t)(whole % 1000000000), 9);
+    } else {
+        fmt_uint(w, (uint32_t)whole, 1);
+    }
+    if (decimals > 0) {
+        fmt_char(w, '.');
+        fmt_uint(w, (uint32_t)(a % scale), decimals);
+    }
+}
+
+void fmt_float(fmt_writer_t *w, float value, int decimals)
+{
+    if (decimals < 0 || decimals > 6) {
+        decimals = 0;
+    }
+    if (!isfinite(value)) {
+        fmt_str(w, isnan(value) ? "nan" : (value < 0 ? "-inf" : "inf"));
+        return;
+    }
+    if (signbit(value)) {
+        fmt_char(w, '-');   // Also for values that round to zero, as printf does
+    }
+
+    // value = m * 2^e exactly, with a 24-bit m. Scale m by 10^decimals in
+    // integers and shift, rounding half to even like printf.
+    int exp;
+    uint32_t m = (uint32_t)ldexpf(frexpf(fabsf(value), &exp), 24);
+    int e = exp - 24;
+    uint64_t n = (uint64_t)m * k_pow10[decimals];   // < 2^44
+    uint64_t q;
+    if (e >= 0) {
+        q = e <= 19 ? n << e : INT64_MAX;           // Clamped above ~1e13
+    } else if (e < -63) {
+        q = 0;
+    } else {
+        q = n >> -e;
+        uint64_t rem = n & ((1ULL << -e) - 1);
+        uint64_t half = 1ULL << (-e - 1);
+        if (rem > half || (rem == half && (q & 1))) {
+            q++;
+        }
+    }
+    fmt_fixed64(w, (int64_t)(q > INT64_MAX ? INT64_MAX : q), decimals);
+}
+
+int fmt_finish(fmt_writer_t *w)
+{
+    if (w->max_len > 0) {
+        w->buf[w->len] = '\0';
+    }
+    return w->overflow ? -1 : (int)w->len;
+}
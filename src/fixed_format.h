@@ -0,0 +1,69 @@
+/**
+ * Fixed Format - Integer-only text formatting into a caller's buffer
+ *
+ * The ESP32 has no double-precision FPU, so printf("%.9f") goes through
+ * soft-float conversion on every call. Positions are already integers in
+ * the receiver's units (1e-7 deg, mm); these helpers render them - and
+ * floats scaled to fixed point in single precision - with integer
+ * arithmetic only. No heap, no printf, no locale.
+ */
+
+#ifndef FIXED_FORMAT_H
+#define FIXED_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Bounded output buffer
+ * Output past max_len - 1 is dropped and sets overflow; the buffer always
+ * has room for the terminating NUL.
+ */
+typedef struct {
+    char *buf;
+    size_t max_len;
+    size_t len;
+    bool overflow;
+} fmt_writer_t;
+
+void fmt_init(fmt_writer_t *w, char *buf, size_t max_len);
+
+void fmt_char(fmt_writer_t *w, char c);
+void fmt_str(fmt_writer_t *w, const char *s);
+
+/**
+ * Unsigned decimal, zero-padded to at least min_digits
+ */
+void fmt_uint(fmt_writer_t *w, uint32_t value, int min_digits);
+
+/**
+ * Signed decimal
+ */
+void fmt_int(fmt_writer_t *w, int32_t value);
+
+/**
+ * Signed fixed-point value with the given number of decimals (0-9)
+ * e.g. (12345, 3) -> "12.345", (-5, 3) -> "-0.005"
+ */
+void fmt_fixed(fmt_writer_t *w, int32_t value, int decimals);
+
+/**
+ * fmt_fixed() for values beyond 32 bits, e.g. 1e-9 degrees
+ */
+void fmt_fixed64(fmt_writer_t *w, int64_t value, int decimals);
+
+/**
+ * Float rounded to the given number of decimals (0-6), same as "%.*f"
+ * Rounded exactly from the float's mantissa in integers, so no double
+ * arithmetic at all. Magnitudes above ~1e13 are clamped.
+ */
+void fmt_float(fmt_writer_t *w, float value, int decimals);
+
+/**
+ * NUL-terminate the output
+ * @return Length written (excluding NUL), or -1 if anything was dropped
+ */
+int fmt_finish(fmt_writer_t *w);
+
+#endif // FIXED_FORMAT_H
@@ -0,0 +1,280 @@
+/**
+ * Link Budget - Data usage tracking and limits on metered networks
+ *
+ * Each subsystem already counts its own bytes; this module samples those
+ * counters once a second into one-minute buckets, giving a trailing hour
+ * per subsystem without hooking any send path. DNS has no byte counter,
+ * so queries are charged at a typical query + answer size.
+ *
+ * Enforcement only applies on a metered network:
+ *  - Telemetry: samples are spaced out, using the trailing hour's cost per
+ *    sample (request overhead included), so the dashboard stays within
+ *    LINK_BUDGET_TELEMETRY_KB_PER_HOUR.
+ *  - Corrections: once NTRIP runs over LINK_BUDGET_NTRIP_KB_PER_HOUR,
+ *    mountpoint selection favours lighter MSM streams until the rover is
+ *    back on an unmetered network (latched, so the lighter mountpoint's
+ *    lower rate doesn't flip the choice straight back).
+ *  - OTA: deferred entirely; a firmware image is worth hours of telemetry.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "link_budget.h"
+#include "ntrip_client.h"
+#include "dashboard_client.h"
+#include "mqtt_uplink.h"
+#include "ota_update.h"
+#include "dns_resolver.h"
+#include "wifi.h"
+#include "config.h"
+
+static const char *TAG = "link_budget";
+
+#ifndef LINK_BUDGET_NTRIP_KB_PER_HOUR
+#define LINK_BUDGET_NTRIP_KB_PER_HOUR 2048
+#endif
+#ifndef LINK_BUDGET_TELEMETRY_KB_PER_HOUR
+#define LINK_BUDGET_TELEMETRY_KB_PER_HOUR 512
+#endif
+
+#define LINK_BUDGET_SAMPLE_MS       1000
+#define LINK_BUDGET_BUCKET_MS       60000
+#define LINK_BUDGET_BUCKETS         60        // One hour of one-minute buckets
+#define LINK_BUDGET_DNS_QUERY_BYTES 128       // Query + answer incl. UDP/IP headers
+#define TELEMETRY_MIN_SPACING_MS    100       // Below this, just send every epoch
+#define TELEMETRY_MAX_SPACING_MS    60000
+#define HOURS_PER_MONTH             (24 * 30)
+
+static uint32_t s_buckets[LINK_BUDGET_SUBSYSTEMS][LINK_BUDGET_BUCKETS];
+static int s_bucket = 0;
+static int s_full_buckets = 0;             // Completed buckets in the window
+static int64_t s_bucket_start_ms = 0;
+static uint32_t s_sample_buckets[LINK_BUDGET_BUCKETS];  // Dashboard samples sent
+
+static uint32_t s_last_count[LINK_BUDGET_SUBSYSTEMS];
+static uint32_t s_last_samples = 0;
+static int64_t s_last_sample_ms = 0;
+static bool s_have_sample = false;
+
+static link_budget_stats_t s_stats;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * Bytes and samples of the telemetry uplink, whichever transport it uses
+ */
+static void read_telemetry(uint32_t *bytes, uint32_t *samples)
+{
+    dashboard_stats_t dash;
+    dashboard_get_stats(&dash);
+    *bytes = dash.bytes_sent + dash.bytes_received;
+    *samples = dash.samples;
+#if MQTT_ENABLED
+    mqtt_uplink_stats_t mqtt;
+    mqtt_uplink_get_stats(&mqtt);
+    *bytes += mqtt.bytes_sent;
+    *samples += mqtt.positions;
+#endif
+}
+
+static void read_counters(uint32_t count[LINK_BUDGET_SUBSYSTEMS], uint32_t *samples)
+{
+    dns_resolver_stats_t dns;
+    dns_resolver_get_stats(&dns);
+
+    count[LINK_BUDGET_NTRIP] = ntrip_client_get_bytes_received() + ntrip_client_get_bytes_sent();
+    read_telemetry(&count[LINK_BUDGET_DASHBOARD], samples);
+    count[LINK_BUDGET_OTA] = ota_get_bytes_received();
+    count[LINK_BUDGET_DNS] = dns.queries * LINK_BUDGET_DNS_QUERY_BYTES;
+}
+
+/**
+ * Move the current bucket forward to now, clearing the buckets it enters
+ */
+static void advance_buckets(int64_t now)
+{
+    if (now - s_bucket_start_ms >= (int64_t)LINK_BUDGET_BUCKETS * LINK_BUDGET_BUCKET_MS) {
+        memset(s_buckets, 0, sizeof(s_buckets));
+        memset(s_sample_buckets, 0, sizeof(s_sample_buckets));
+        s_full_buckets = 0;
+        s_bucket_start_ms = now;
+        return;
+    }
+
+    while (now - s_bucket_start_ms >= LINK_BUDGET_BUCKET_MS) {
+        s_bucket = (s_bucket + 1) % LINK_BUDGET_BUCKETS;
+        for (int i = 0; i < LINK_BUDGET_SUBSYSTEMS; i++) {
+            s_buckets[i][s_bucket] = 0;
+        }
+        s_sample_buckets[s_bucket] = 0;
+        s_bucket_start_ms += LINK_BUDGET_BUCKET_MS;
+        if (s_full_buckets < LINK_BUDGET_BUCKETS - 1) {
+            s_full_buckets++;
+        }
+    }
+}
+
+static uint32_t hour_bytes(int subsystem)
+{
+    uint32_t total = 0;
+    for (int b = 0; b < LINK_BUDGET_BUCKETS; b++) {
+        total += s_buckets[subsystem][b];
+    }
+    return total;
+}
+
+/**
+ * Bytes per hour at the trailing rate
+ * Until an hour has passed the window is extrapolated, but never from less
+ * than a minute so a startup burst (sourcetable, DNS prefetch) isn't
+ * mistaken for the steady rate.
+ */
+static uint32_t hour_rate(int subsystem, int64_t now)
+{
+    int64_t window_ms = (int64_t)s_full_buckets * LINK_BUDGET_BUCKET_MS + (now - s_bucket_start_ms);
+    if (window_ms < LINK_BUDGET_BUCKET_MS) {
+        window_ms = LINK_BUDGET_BUCKET_MS;
+    }
+    return (uint32_t)((uint64_t)hour_bytes(subsystem) * 3600000 / window_ms);
+}
+
+/**
+ * Sample spacing that keeps the dashboard inside its hourly budget
+ * @return 0 to send every epoch
+ */
+static uint32_t telemetry_spacing(void)
+{
+    uint32_t samples = 0;
+    for (int b = 0; b < LINK_BUDGET_BUCKETS; b++) {
+        samples += s_sample_buckets[b];
+    }
+    if (!s_stats.metered || LINK_BUDGET_TELEMETRY_KB_PER_HOUR <= 0 || samples == 0) {
+        return 0;
+    }
+
+    uint64_t per_sample = hour_bytes(LINK_BUDGET_DASHBOARD) / samples;
+    uint64_t spacing = per_sample * 3600000 / ((uint64_t)LINK_BUDGET_TELEMETRY_KB_PER_HOUR * 1024);
+    spacing = (spacing + 99) / 100 * 100;
+    if (spacing <= TELEMETRY_MIN_SPACING_MS) {
+        return 0;
+    }
+    return spacing < TELEMETRY_MAX_SPACING_MS ? (uint32_t)spacing : TELEMETRY_MAX_SPACING_MS;
+}
+
+void link_budget_update(void)
+{
+    int64_t now = now_ms();
+    if (s_have_sample && now - s_last_sample_ms < LINK_BUDGET_SAMPLE_MS) {
+        return;
+    }
+
+    uint32_t count[LINK_BUDGET_SUBSYSTEMS];
+    uint32_t samples;
+    read_counters(count, &samples);
+    if (!s_have_sample) {
+        memcpy(s_last_count, count, sizeof(s_last_count));
+        s_last_samples = samples;
+        s_bucket_start_ms = now;
+        s_last_sample_ms = now;
+        s_have_sample = true;
+        return;
+    }
+    s_last_sample_ms = now;
+    advance_buckets(now);
+
+    bool metered = wifi_is_metered();
+    if (metered != s_stats.metered) {
+        if (metered) {
+            ESP_LOGI(TAG, "Metered network %s - budgets: NTRIP %d KB/h, telemetry %d KB/h, OTA deferred",
+                     wifi_get_ssid(), LINK_BUDGET_NTRIP_KB_PER_HOUR, LINK_BUDGET_TELEMETRY_KB_PER_HOUR);
+        } else {
+            ESP_LOGI(TAG, "Off metered network - budgets lifted");
+            s_stats.light_corrections = false;
+        }
+        s_stats.metered = metered;
+    }
+
+    // Unsigned deltas stay correct across counter wrap
+    uint32_t month_rate = 0;
+    for (int i = 0; i < LINK_BUDGET_SUBSYSTEMS; i++) {
+        uint32_t delta = count[i] - s_last_count[i];
+        s_last_count[i] = count[i];
+        s_buckets[i][s_bucket] += delta;
+        if (metered) {
+            s_stats.metered_total[i] += delta;
+        }
+        s_stats.last_hour[i] = hour_bytes(i);
+        month_rate += hour_rate(i, now);
+    }
+    s_stats.projected_month_kb = (uint32_t)((uint64_t)month_rate * HOURS_PER_MONTH / 1024);
+    s_sample_buckets[s_bucket] += samples - s_last_samples;
+    s_last_samples = samples;
+
+    if (metered && !s_stats.light_corrections && LINK_BUDGET_NTRIP_KB_PER_HOUR > 0) {
+        uint32_t ntrip_rate = hour_rate(LINK_BUDGET_NTRIP, now);
+        if (ntrip_rate > (uint32_t)LINK_BUDGET_NTRIP_KB_PER_HOUR * 1024) {
+            ESP_LOGW(TAG, "NTRIP at %lu KB/h over %d KB/h budget - preferring lighter MSM mountpoints",
+                     (unsigned long)(ntrip_rate / 1024), LINK_BUDGET_NTRIP_KB_PER_HOUR);
+            s_stats.light_corrections = true;
+        }
+    }
+
+    uint32_t spacing = telemetry_spacing();
+    if ((spacing == 0) != (s_stats.telemetry_spacing_ms == 0)) {
+        if (spacing == 0) {
+            ESP_LOGI(TAG, "Telemetry back to every epoch");
+        } else {
+            ESP_LOGI(TAG, "Telemetry spaced to one sample per %lu ms", (unsigned long)spacing);
+        }
+    }
+    s_stats.telemetry_spacing_ms = spacing;
+}
+
+uint32_t link_budget_telemetry_spacing_ms(void)
+{
+    return s_stats.telemetry_spacing_ms;
+}
+
+uint32_t link_budget_telemetry_bytes(void)
+{
+    uint32_t bytes, samples;
+    read_telemetry(&bytes, &samples);
+    return bytes;
+}
+
+bool link_budget_prefer_light_corrections(void)
+{
+    return s_stats.light_corrections;
+}
+
+bool link_budget_allow_ota(void)
+{
+    if (wifi_is_metered()) {
+        s_stats.ota_deferred++;
+        return false;
+    }
+    return true;
+}
+
+const char *link_budget_subsystem_str(link_budget_subsystem_t subsystem)
+{
+    switch (subsystem) {
+        case LINK_BUDGET_NTRIP:     return "NTRIP";
+        case LINK_BUDGET_DASHBOARD: return "dashboard";
+        case LINK_BUDGET_OTA:       return "OTA";
+        case LINK_BUDGET_DNS:       return "DNS";
+        default:                    return "unknown";
+    }
+}
+
+void link_budget_get_stats(link_budget_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * Link Budget - Data usage tracking and limits on metered networks
+ *
+ * Samples the byte counters of every subsystem that talks to the network,
+ * keeps a trailing hour of usage per subsystem and projects it over a
+ * month. On a metered network (see wifi.c) the configured hourly budgets
+ * are enforced: telemetry is slowed down, lighter MSM mountpoints are
+ * preferred and OTA is deferred until an unmetered network is back.
+ */
+
+#ifndef LINK_BUDGET_H
+#define LINK_BUDGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    LINK_BUDGET_NTRIP = 0,
+    LINK_BUDGET_DASHBOARD,
+    LINK_BUDGET_OTA,
+    LINK_BUDGET_DNS,
+    LINK_BUDGET_SUBSYSTEMS
+} link_budget_subsystem_t;
+
+/**
+ * Usage statistics (payload bytes - the carrier also bills TCP/IP headers)
+ */
+typedef struct {
+    bool metered;                                   // Connected network is metered
+    bool light_corrections;                         // NTRIP over budget, lighter MSM preferred
+    uint32_t last_hour[LINK_BUDGET_SUBSYSTEMS];     // Bytes in the trailing hour
+    uint32_t metered_total[LINK_BUDGET_SUBSYSTEMS]; // Bytes on metered networks since boot
+    uint32_t projected_month_kb;                    // Trailing hour rate over 30 days, all subsystems
+    uint32_t telemetry_spacing_ms;                  // Minimum time between dashboard samples, 0 = every epoch
+    uint32_t ota_deferred;                          // OTA checks skipped on a metered network
+} link_budget_stats_t;
+
+/**
+ * Sample the subsystem counters and update the limits
+ * Cheap - call from the rover loop; sampling runs once a second
+ */
+void link_budget_update(void);
+
+/**
+ * Minimum time between samples queued for the dashboard
+ * @return 0 to send every epoch (the default unless the telemetry budget
+ *         calls for a slower rate)
+ */
+uint32_t link_budget_telemetry_spacing_ms(void);
+
+/**
+ * Bytes the telemetry uplink (dashboard or MQTT) has moved since boot
+ */
+uint32_t link_budget_telemetry_bytes(void);
+
+/**
+ * Check if mountpoint selection should favour lighter MSM streams
+ */
+bool link_budget_prefer_light_corrections(void);
+
+/**
+ * Check if an OTA check/download may run now (counts a deferral if not)
+ */
+bool link_budget_allow_ota(void);
+
+/**
+ * Get a subsystem's display name
+ */
+const char *link_budget_subsystem_str(link_budget_subsystem_t subsystem);
+
+/**
+ * Get usage statistics
+ */
+void link_budget_get_stats(link_budget_stats_t *stats);
+
+#endif // LINK_BUDGET_H
@@ -13,16 +13,33 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "config.h"
 #include "wifi.h"
+#include "dns_resolver.h"
 #include "ntrip_client.h"
+#include "ntrip_sourcetable.h"
+#include "corr_arbiter.h"
+#include "corr_uart.h"
 #include "zed_rover.h"
+#include "position_window.h"
 #include "dashboard_client.h"
+#include "telemetry.h"
+#include "telemetry_store.h"
+#include "telemetry_rate.h"
+#include "track_simplify.h"
+#include "mqtt_uplink.h"
+#include "udp_telemetry.h"
+#include "status_server.h"
+#include "fixed_format.h"
+#include "metrics.h"
+#include "link_budget.h"
 #include "battery.h"
 #include "ota_update.h"
 #include "led.h"
@@ -36,8 +53,18 @@ static uint32_t position_count = 0;
 static uint32_t fixed_count = 0;
 static uint32_t float_count = 0;
 
+#ifndef TELEMETRY_ADAPTIVE
+#define TELEMETRY_ADAPTIVE 0   // Configs from before telemetry_rate.c send every epoch
+#endif
+#ifndef TRACK_SIMPLIFY_TOLERANCE_MM
+#define TRACK_SIMPLIFY_TOLERANCE_MM 0
+#endif
+
+// Uploaded track, simplified (rover task only)
+static track_simplify_t track;
+
 // Buffer for RTCM data
-#define RTCM_BUFFER_SIZE 1024
+#define RTCM_BUFFER_SIZE 2048  // Must hold at least one full RTCM frame
 static uint8_t rtcm_buffer[RTCM_BUFFER_SIZE];
 
 /**
@@ -49,13 +76,166 @@ static void print_position(const zed_position_t *pos)
     ESP_LOGI(TAG, "[%02d:%02d:%02d UTC] %s",
              pos->hour, pos->min, pos->sec,
              zed_rover_fix_type_str(pos->fix_type, pos->carr_soln));
-    ESP_LOGI(TAG, "  Lat: %.9f  Lon: %.9f", pos->latitude, pos->longitude);
-    ESP_LOGI(TAG, "  Alt: %.3f m MSL", pos->altitude_msl);
-    ESP_LOGI(TAG, "  hAcc: %.3f m  vAcc: %.3f m  Sats: %d",
-             pos->h_acc, pos->v_acc, pos->num_sv);
+
+    // Formatted from the receiver's integers, high precision digits included
+    char line[64];
+    fmt_writer_t w;
+    fmt_init(&w, line, sizeof(line));
+    fmt_str(&w, "Lat: ");
+    fmt_fixed64(&w, (int64_t)pos->lat_e7 * 100 + pos->lat_hp, 9);
+    fmt_str(&w, "  Lon: ");
+    fmt_fixed64(&w, (int64_t)pos->lon_e7 * 100 + pos->lon_hp, 9);
+    fmt_finish(&w);
+    ESP_LOGI(TAG, "  %s", line);
+
+    fmt_init(&w, line, sizeof(line));
+    fmt_fixed64(&w, (int64_t)pos->alt_mm * 10 + pos->alt_hp, 4);
+    fmt_finish(&w);
+    ESP_LOGI(TAG, "  Alt: %s m MSL", line);
+
+    fmt_init(&w, line, sizeof(line));
+    fmt_str(&w, "hAcc: ");
+    fmt_fixed64(&w, pos->h_acc_mm, 3);
+    fmt_str(&w, " m  vAcc: ");
+    fmt_fixed64(&w, pos->v_acc_mm, 3);
+    fmt_finish(&w);
+    ESP_LOGI(TAG, "  %s m  Sats: %d", line, pos->num_sv);
+    if (pos->corr_age_s == ZED_CORR_AGE_UNKNOWN) {
+        ESP_LOGI(TAG, "  Correction age: none");
+    } else if (pos->corr_age_s == ZED_CORR_AGE_OVER_120S) {
+        ESP_LOGI(TAG, "  Correction age: >120 s");
+    } else {
+        ESP_LOGI(TAG, "  Correction age: <=%u s%s", pos->corr_age_s,
+                 corr_arbiter_corr_age_alarm() ? "  [ALARM]" : "");
+    }
     ESP_LOGI(TAG, "  RTCM: %lu bytes rx, %lu bytes tx",
              (unsigned long)rtcm_bytes_received, (unsigned long)rtcm_bytes_sent);
 
+    rtcm_liveness_stats_t liveness;
+    if (ntrip_client_get_liveness_stats(0, &liveness)) {
+        ESP_LOGI(TAG, "  Epochs: %lu @ %lu ms (jitter %lu ms)  degraded: %lu (detect max %lu ms)",
+                 (unsigned long)liveness.epochs, (unsigned long)liveness.epoch_interval_ms,
+                 (unsigned long)liveness.jitter_ms,
+                 (unsigned long)liveness.degraded_events,
+                 (unsigned long)liveness.max_detection_ms);
+    }
+
+    ntrip_rtp_stats_t rtp;
+    if (ntrip_client_get_rtp_stats(0, &rtp)) {
+        ESP_LOGI(TAG, "  RTP: %lu pkts  lost %lu in %lu gaps  late %lu",
+                 (unsigned long)rtp.packets_rx, (unsigned long)rtp.lost,
+                 (unsigned long)rtp.gaps, (unsigned long)rtp.late);
+    }
+
+    ntrip_tls_stats_t tls;
+    if (ntrip_client_get_tls_stats(0, &tls)) {
+        ESP_LOGI(TAG, "  TLS: %lu full (last %lu ms)  %lu resumed (last %lu ms)  %lu failed",
+                 (unsigned long)tls.full_handshakes, (unsigned long)tls.last_full_ms,
+                 (unsigned long)tls.resumed_handshakes, (unsigned long)tls.last_resumed_ms,
+                 (unsigned long)tls.handshake_failures);
+    }
+
+#if NTRIP_STANDBY_ENABLED || CORR_UART_ENABLED
+    rtcm_merge_stats_t merge;
+    corr_arbiter_get_merge_stats(&merge);
+    ESP_LOGI(TAG, "  Source: %s (station %d)  switches: %lu (last %lu ms, max %lu ms)  dup suppressed: %lu",
+             corr_arbiter_active_name(), merge.active_station,
+             (unsigned long)merge.switches, (unsigned long)merge.last_switch_latency_ms,
+             (unsigned long)merge.max_switch_latency_ms,
+             (unsigned long)merge.duplicates_suppressed);
+#endif
+#if CORR_UART_ENABLED
+    corr_uart_stats_t radio;
+    corr_uart_get_stats(&radio);
+    ESP_LOGI(TAG, "  Radio: %lu bytes, %lu frames, %lu CRC errors, %lu overruns",
+             (unsigned long)radio.bytes_received, (unsigned long)radio.frames,
+             (unsigned long)radio.crc_errors, (unsigned long)radio.overflows);
+#endif
+
+#if DASHBOARD_ENABLED || MQTT_ENABLED
+    telemetry_stats_t uplink;
+    telemetry_get_stats(&uplink);
+    ESP_LOGI(TAG, "  Uplink: %lu batches, %lu failed  queue %lu (max %lu)  dropped %lu  latency %lu ms (max %lu ms)",
+             (unsigned long)uplink.batches, (unsigned long)uplink.failed,
+             (unsigned long)uplink.depth, (unsigned long)uplink.max_depth,
+             (unsigned long)uplink.dropped,
+             (unsigned long)uplink.last_latency_ms, (unsigned long)uplink.max_latency_ms);
+#if MQTT_ENABLED
+    mqtt_uplink_stats_t mqtt;
+    mqtt_uplink_get_stats(&mqtt);
+    ESP_LOGI(TAG, "  MQTT: %s  %lu positions, %lu QoS 1 (%lu acked, %lu expired)  %.1f msg/s  RTT %lu ms (avg %lu ms)  offline %lu, reconnects %lu",
+             mqtt.connected ? "up" : "DOWN",
+             (unsigned long)mqtt.positions, (unsigned long)mqtt.qos1_sent,
+             (unsigned long)mqtt.qos1_acked, (unsigned long)mqtt.qos1_expired,
+             mqtt.msgs_per_s, (unsigned long)mqtt.last_rtt_ms, (unsigned long)mqtt.avg_rtt_ms,
+             (unsigned long)mqtt.offline, (unsigned long)mqtt.disconnects);
+#else
+    dashboard_stats_t dash;
+    dashboard_get_stats(&dash);
+    ESP_LOGI(TAG, "  Dashboard: %lu samples in %lu POSTs on %lu connections (%lu/conn)  median %lu ms  errors %lu, lost %lu",
+             (unsigned long)dash.samples, (unsigned long)dash.posts, (unsigned long)dash.connections,
+             (unsigned long)(dash.connections > 0 ? dash.posts / dash.connections : 0),
+             (unsigned long)dash.median_latency_ms,
+             (unsigned long)dash.http_errors, (unsigned long)dash.lost);
+#endif
+    telemetry_store_stats_t store;
+    telemetry_store_get_stats(&store);
+    if (store.pages_written > 0 || store.pages_pending > 0) {
+        ESP_LOGI(TAG, "  Store: %lu samples stored, %lu pages waiting, %lu sent in %lu requests  dropped %lu, CRC errors %lu, erases %lu",
+                 (unsigned long)store.samples_stored, (unsigned long)store.pages_pending,
+                 (unsigned long)store.pages_sent, (unsigned long)uplink.backfilled,
+                 (unsigned long)store.pages_dropped, (unsigned long)store.crc_errors,
+                 (unsigned long)store.sector_erases);
+    }
+#if TELEMETRY_ADAPTIVE
+    telemetry_rate_stats_t rate;
+    telemetry_rate_get_stats(&rate);
+    ESP_LOGI(TAG, "  Rate: %s  %lu/%lu epochs sent (moved %lu, fix %lu, turns %lu, heartbeat %lu)  static %lu s %lu KB/h, moving %lu s %lu KB/h",
+             rate.moving ? "moving" : "static",
+             (unsigned long)rate.sent, (unsigned long)rate.epochs,
+             (unsigned long)rate.moved, (unsigned long)rate.fix_changes,
+             (unsigned long)rate.turns, (unsigned long)rate.heartbeats,
+             (unsigned long)rate.static_s, (unsigned long)(rate.static_bytes_per_hour / 1024),
+             (unsigned long)rate.moving_s, (unsigned long)(rate.moving_bytes_per_hour / 1024));
+#endif
+    if (track.tolerance_mm > 0) {
+        const track_simplify_stats_t *ts = &track.stats;
+        ESP_LOGI(TAG, "  Track: %lu of %lu points kept (%.1f:1)  max error %lu mm (tolerance %lu mm)",
+                 (unsigned long)ts->points_out, (unsigned long)ts->points_in,
+                 ts->points_out > 0 ? (float)ts->points_in / ts->points_out : 0.0f,
+                 (unsigned long)ts->max_error_mm, (unsigned long)track.tolerance_mm);
+    }
+#endif
+
+#if UDP_TELEMETRY_ENABLED
+    udp_telemetry_stats_t udp;
+    udp_telemetry_get_stats(&udp);
+    ESP_LOGI(TAG, "  UDP: %lu datagrams, %lu errors, %lu bytes  max send %lu us",
+             (unsigned long)udp.sent, (unsigned long)udp.errors,
+             (unsigned long)udp.bytes, (unsigned long)udp.max_send_us);
+#endif
+
+#if STATUS_SERVER_ENABLED
+    status_server_stats_t srv;
+    status_server_get_stats(&srv);
+    ESP_LOGI(TAG, "  Status server: %lu subscribers (max %lu)  %lu events, %lu superseded  %lu requests (%lu scrapes), %lu rejected, %lu slow dropped  %lu bytes",
+             (unsigned long)srv.subscribers, (unsigned long)srv.max_subscribers,
+             (unsigned long)srv.events, (unsigned long)srv.superseded,
+             (unsigned long)srv.requests, (unsigned long)srv.scrapes, (unsigned long)srv.rejected,
+             (unsigned long)srv.slow_closed, (unsigned long)srv.bytes_sent);
+#endif
+
+    link_budget_stats_t usage;
+    link_budget_get_stats(&usage);
+    ESP_LOGI(TAG, "  Data/h: NTRIP %lu KB, dashboard %lu KB, OTA %lu KB, DNS %lu KB  month ~%lu MB%s%s",
+             (unsigned long)(usage.last_hour[LINK_BUDGET_NTRIP] / 1024),
+             (unsigned long)(usage.last_hour[LINK_BUDGET_DASHBOARD] / 1024),
+             (unsigned long)(usage.last_hour[LINK_BUDGET_OTA] / 1024),
+             (unsigned long)(usage.last_hour[LINK_BUDGET_DNS] / 1024),
+             (unsigned long)(usage.projected_month_kb / 1024),
+             usage.metered ? "  [METERED]" : "",
+             usage.telemetry_spacing_ms > 0 ? "  telemetry spaced out" : "");
+
     // RTK statistics
     uint32_t rtk_total = fixed_count + float_count;
     float fixed_pct = (rtk_total > 0) ? (100.0f * fixed_count / rtk_total) : 0.0f;
@@ -69,9 +249,81 @@ static void print_position(const zed_position_t *pos)
         ESP_LOGI(TAG, "  RTK Float - converging...");
         ESP_LOGI(TAG, "  Fixed rate: %.1f%% (%lu/%lu)", fixed_pct,
                  (unsigned long)fixed_count, (unsigned long)rtk_total);
-    } else if (!ntrip_client_is_connected()) {
-        ESP_LOGW(TAG, "  [NO NTRIP CONNECTION]");
+    } else if (!corr_arbiter_is_up()) {
+        ESP_LOGW(TAG, "  [NO CORRECTION SOURCE]");
+    }
+}
+
+/**
+ * Print the summary of every epoch since the previous report
+ */
+static void print_window(const position_window_summary_t *s)
+{
+    static const char *const class_name[POSITION_WINDOW_CLASSES] = {
+        "none", "gnss", "float", "fixed",
+    };
+    char line[96];
+    fmt_writer_t w;
+
+    fmt_init(&w, line, sizeof(line));
+    fmt_str(&w, "Window: ");
+    fmt_uint(&w, s->samples, 1);
+    fmt_str(&w, " epochs (");
+    fmt_uint(&w, s->valid, 1);
+    fmt_str(&w, " valid) in ");
+    fmt_fixed(&w, (int32_t)s->duration_ms, 3);
+    fmt_str(&w, " s -");
+    for (int i = POSITION_WINDOW_CLASSES - 1; i >= 0; i--) {
+        if (s->dwell_ms[i] > 0) {
+            fmt_char(&w, ' ');
+            fmt_str(&w, class_name[i]);
+            fmt_char(&w, ' ');
+            fmt_fixed(&w, (int32_t)s->dwell_ms[i], 3);
+        }
+    }
+    fmt_finish(&w);
+    ESP_LOGI(TAG, "  %s", line);
+    if (s->valid == 0) {
+        return;
     }
+
+    // Spread as north/east/up extents; 1e-7 deg of latitude is ~11.1 mm
+    float lat_rad = s->lat_e7.mean * 1e-7f * 0.0174533f;
+    int32_t n_mm = (int32_t)((s->lat_e7.max - s->lat_e7.min) * 11.1319f);
+    int32_t e_mm = (int32_t)((s->lon_e7.max - s->lon_e7.min) * 11.1319f * cosf(lat_rad));
+    fmt_init(&w, line, sizeof(line));
+    fmt_str(&w, "Mean: ");
+    fmt_fixed(&w, s->lat_e7.mean, 7);
+    fmt_char(&w, ' ');
+    fmt_fixed(&w, s->lon_e7.mean, 7);
+    fmt_char(&w, ' ');
+    fmt_fixed(&w, s->alt_mm.mean, 3);
+    fmt_str(&w, " m  spread N ");
+    fmt_fixed(&w, n_mm, 3);
+    fmt_str(&w, " E ");
+    fmt_fixed(&w, e_mm, 3);
+    fmt_str(&w, " U ");
+    fmt_fixed(&w, s->alt_mm.max - s->alt_mm.min, 3);
+    fmt_str(&w, " m");
+    fmt_finish(&w);
+    ESP_LOGI(TAG, "  %s", line);
+
+    fmt_init(&w, line, sizeof(line));
+    fmt_str(&w, "hAcc ");
+    fmt_fixed(&w, s->h_acc_mm.mean, 3);
+    fmt_str(&w, " (");
+    fmt_fixed(&w, s->h_acc_mm.min, 3);
+    fmt_char(&w, '-');
+    fmt_fixed(&w, s->h_acc_mm.max, 3);
+    fmt_str(&w, ") m  vAcc ");
+    fmt_fixed(&w, s->v_acc_mm.mean, 3);
+    fmt_str(&w, " (");
+    fmt_fixed(&w, s->v_acc_mm.min, 3);
+    fmt_char(&w, '-');
+    fmt_fixed(&w, s->v_acc_mm.max, 3);
+    fmt_str(&w, ") m");
+    fmt_finish(&w);
+    ESP_LOGI(TAG, "  %s", line);
 }
 
 /**
@@ -81,17 +333,23 @@ static void rover_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Rover task started");
 
-    TickType_t last_ntrip_attempt = 0;
     TickType_t last_position_report = 0;
+    TickType_t last_dashboard_report = 0;
+    int battery_pct = battery_get_percentage();
     TickType_t last_led_time = 0;
-    const TickType_t ntrip_retry_interval = pdMS_TO_TICKS(NTRIP_RECONNECT_INTERVAL_MS);
     const TickType_t position_interval = pdMS_TO_TICKS(POSITION_REPORT_INTERVAL_MS);
     const TickType_t led_interval = pdMS_TO_TICKS(50);  // 50ms for smooth pulsing
 
     zed_position_t pos;
     uint8_t last_carr_soln = 0;
 
+    // Every epoch between two position reports is summarized, not just the last
+    position_window_t window;
+    position_window_init(&window, esp_timer_get_time() / 1000);
+    track_simplify_init(&track, TRACK_SIMPLIFY_TOLERANCE_MM);
+
     while (1) {
+        int64_t loop_start_us = esp_timer_get_time();
         bool wifi_ok = wifi_is_connected();
         bool ntrip_ok = ntrip_client_is_connected();
 
@@ -99,32 +357,23 @@ static void rover_task(void *pvParameters)
         ntrip_client_check_stale();
         ntrip_ok = ntrip_client_is_connected();
 
-        // Maintain NTRIP connection
-        if (!ntrip_ok && wifi_ok) {
-            TickType_t now = xTaskGetTickCount();
-            if ((now - last_ntrip_attempt) >= ntrip_retry_interval) {
-                ESP_LOGI(TAG, "Connecting to NTRIP caster...");
-                if (ntrip_client_connect() == ESP_OK) {
-                    ntrip_ok = true;
-                }
-                last_ntrip_attempt = now;
-            }
-        }
+        // Maintain NTRIP connection (non-blocking reconnect state machine)
+        ntrip_client_poll(wifi_ok);
+        ntrip_ok = ntrip_client_is_connected();
 
-        // Receive RTCM from NTRIP and forward to ZED-X20P
-        if (ntrip_ok) {
-            int received = ntrip_client_receive(rtcm_buffer, RTCM_BUFFER_SIZE);
-            if (received > 0) {
-                rtcm_bytes_received += received;
+        // Data usage per subsystem, and the budgets on a metered network
+        link_budget_update();
 
-                // Forward to ZED-X20P
-                int sent = zed_rover_write_rtcm(rtcm_buffer, received);
-                if (sent > 0) {
-                    rtcm_bytes_sent += sent;
-                }
-            } else if (received < 0) {
-                // Connection lost
-                ntrip_ok = false;
+        // Receive RTCM from all correction sources and forward to ZED-X20P
+        int received = corr_arbiter_receive(rtcm_buffer, RTCM_BUFFER_SIZE);
+        bool corr_ok = (received >= 0);
+        if (received > 0) {
+            rtcm_bytes_received += received;
+
+            // Forward to ZED-X20P
+            int sent = zed_rover_write_rtcm(rtcm_buffer, received);
+            if (sent > 0) {
+                rtcm_bytes_sent += sent;
             }
         }
 
@@ -140,20 +389,59 @@ static void rover_task(void *pvParameters)
             }
 
             last_carr_soln = pos.carr_soln;
+            position_window_add(&window, &pos, esp_timer_get_time() / 1000);
+
+            // GGA upstream for VRS mountpoints, and mountpoint re-ranking
+            ntrip_client_set_position(&pos);
+            corr_arbiter_check_correction_age(&pos);
+            ntrip_sourcetable_update(&pos);
 
             // Report position periodically
             TickType_t now = xTaskGetTickCount();
             if ((now - last_position_report) >= position_interval) {
+                position_window_summary_t summary;
+                position_window_close(&window, esp_timer_get_time() / 1000, &summary);
                 print_position(&pos);
+                print_window(&summary);
                 last_position_report = now;
+                battery_pct = battery_get_percentage();  // Slow-changing, read at report rate
+            }
 
-                // Send to dashboard
-#if DASHBOARD_ENABLED
-                int battery_pct = battery_get_percentage();
-                dashboard_send_position(&pos, rtcm_bytes_received,
-                                        fixed_count, float_count, battery_pct);
+#if UDP_TELEMETRY_ENABLED
+            // LAN display stream: sent from here, not the telemetry task,
+            // so a slow dashboard upload can't delay it
+            telemetry_record_t udp_rec;
+            telemetry_make_record(&udp_rec, &pos, rtcm_bytes_received,
+                                  fixed_count, float_count, battery_pct);
+            udp_telemetry_send(&udp_rec);
 #endif
+#if STATUS_SERVER_ENABLED
+            status_server_publish(&pos);
+#endif
+
+            // Queue epochs for the dashboard (those that changed something
+            // with TELEMETRY_ADAPTIVE, spaced out on a metered network, and
+            // without the points a straight line covers) - never blocks
+#if DASHBOARD_ENABLED || MQTT_ENABLED
+            uint32_t spacing_ms = link_budget_telemetry_spacing_ms();
+            if (spacing_ms == 0 || (now - last_dashboard_report) >= pdMS_TO_TICKS(spacing_ms)) {
+                telemetry_rate_reason_t reason = TELEMETRY_RATE_MOVED;
+#if TELEMETRY_ADAPTIVE
+                reason = telemetry_rate_check(&pos);
+#endif
+                if (reason != TELEMETRY_RATE_SKIP) {
+                    last_dashboard_report = now;
+                    zed_position_t kept[2];
+                    int n = track_simplify_add(&track, &pos,
+                                               reason == TELEMETRY_RATE_FIX_CHANGE ||
+                                               reason == TELEMETRY_RATE_HEARTBEAT, kept);
+                    for (int i = 0; i < n; i++) {
+                        telemetry_enqueue(&kept[i], rtcm_bytes_received,
+                                          fixed_count, float_count, battery_pct);
+                    }
+                }
             }
+#endif
         }
 
         // Update LED status
@@ -163,10 +451,10 @@ static void rover_task(void *pvParameters)
 
             if (!wifi_ok) {
                 led_pulse(LED_BLUE);           // Blue pulse = WiFi connecting
-            } else if (!ntrip_ok) {
+            } else if (!ntrip_ok && !corr_ok) {
                 led_pulse(LED_PURPLE);         // Purple pulse = NTRIP connecting
-            } else if (ntrip_stale) {
-                led_pulse(LED_RED);            // Red pulse = stale connection
+            } else if (ntrip_stale || corr_arbiter_corr_age_alarm()) {
+                led_pulse(LED_RED);            // Red pulse = stale connection or old corrections
             } else if (last_carr_soln == 2) {
                 led_set_color(LED_GREEN);      // Solid green = RTK Fixed
             } else if (last_carr_soln == 1) {
@@ -176,6 +464,8 @@ static void rover_task(void *pvParameters)
             }
         }
 
+        metrics_observe_loop((uint32_t)(esp_timer_get_time() - loop_start_us));
+
         // Small delay to prevent tight loop
         vTaskDelay(pdMS_TO_TICKS(10));
     }
@@ -192,7 +482,9 @@ static void ota_check_task(void *pvParameters)
     ESP_LOGI(TAG, "OTA check task started (interval: %d min)", OTA_CHECK_INTERVAL_MS / 60000);
 
     while (1) {
-        if (wifi_is_connected()) {
+        if (wifi_is_connected() && !link_budget_allow_ota()) {
+            ESP_LOGI(TAG, "OTA check deferred - metered network");
+        } else if (wifi_is_connected()) {
             char new_version[16];
             if (ota_check_for_update(new_version, sizeof(new_version))) {
                 ESP_LOGI(TAG, "New firmware %s available, updating...", new_version);
@@ -249,12 +541,48 @@ void app_main(void)
         ESP_LOGI(TAG, "Battery: %d%% (%.2fV)", battery_get_percentage(), battery_get_voltage());
     }
 
-    // Connect to NTRIP caster
+    // Start the shared DNS resolver (prefetches caster and dashboard hosts)
+    if (dns_resolver_init() != ESP_OK) {
+        ESP_LOGE(TAG, "DNS resolver initialization failed!");
+    }
+
+    // Connect to NTRIP caster (completes in the background via rover_task)
     ESP_LOGI(TAG, "Connecting to NTRIP caster...");
-    if (ntrip_client_connect() != ESP_OK) {
-        ESP_LOGW(TAG, "Initial NTRIP connection failed - will retry");
+    ntrip_client_init();
+    ntrip_client_connect();
+
+    // Correction sources in priority order: casters, then the local radio
+    corr_arbiter_init();
+    for (int i = 0; i < ntrip_client_session_count(); i++) {
+        corr_arbiter_add_source(ntrip_client_source(i));
+    }
+    if (corr_uart_init() == ESP_OK && corr_uart_source() != NULL) {
+        corr_arbiter_add_source(corr_uart_source());
+    }
+
+    // Load cached sourcetable and start background refresh
+    if (ntrip_sourcetable_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Sourcetable init failed - staying on configured mountpoint");
     }
 
+#if UDP_TELEMETRY_ENABLED
+    if (udp_telemetry_init() != ESP_OK) {
+        ESP_LOGW(TAG, "UDP telemetry disabled");
+    }
+#endif
+#if STATUS_SERVER_ENABLED
+    if (status_server_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Status server disabled");
+    }
+#endif
+
+#if DASHBOARD_ENABLED || MQTT_ENABLED
+    // Dashboard uploads run on their own task, off the rover loop
+    if (telemetry_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry task failed - no dashboard updates");
+    }
+#endif
+
     // Start rover task
     xTaskCreate(rover_task, "rover_task", 8192, NULL, 5, NULL);
 
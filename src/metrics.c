@@ -0,0 +1,464 @@
+/**
+ * Metrics - Prometheus text exposition of the firmware's counters
+ *
+ * Each metric family is a row in s_families: its name, type and help
+ * text, and a function that returns series i of it. The renderer keeps
+ * its place as (family, line) in the caller's cursor and stops at the
+ * last whole line that fits the buffer, so the status server can send a
+ * scrape through its small per-client buffer, one refill at a time.
+ *
+ * Counters are read live, line by line. A histogram is copied into the
+ * cursor when its family starts, so its buckets, sum and count always
+ * agree even when they go out in different refills.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+
+#include "metrics.h"
+#include "fixed_format.h"
+#include "ntrip_client.h"
+#include "corr_arbiter.h"
+#include "zed_rover.h"
+#include "dashboard_client.h"
+#include "wifi.h"
+
+typedef enum {
+    SERIES_END,                     // No series i or beyond
+    SERIES_SKIP,                    // Series i has no value right now
+    SERIES_VALUE,
+} series_t;
+
+typedef struct {
+    const char *name;
+    const char *type;               // "counter", "gauge" or "histogram"
+    const char *help;
+    const char *label;              // Label name, NULL for a single unlabeled series
+    series_t (*series)(int i, const char **label_value, int64_t *value);
+    void (*histogram)(metrics_histogram_t *h);  // Histograms: copy the current state
+    uint8_t decimals;               // Histograms: observations in 10^-decimals base units
+} family_t;
+
+// Rover loop pass, excluding its 10 ms delay
+static const uint32_t k_loop_bounds_us[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 50000 };
+static metrics_histogram_t s_loop_us = {
+    .bounds = k_loop_bounds_us,
+    .num_bounds = sizeof(k_loop_bounds_us) / sizeof(k_loop_bounds_us[0]),
+};
+
+// Tasks whose stack headroom is reported (those not running are skipped)
+static const char *const k_tasks[] = {
+    "rover_task", "telemetry", "status_srv", "dns_resolver", "wifi_mgr", "sourcetable", "ota_check",
+};
+
+static series_t one(int i, int64_t value, int64_t *out)
+{
+    if (i > 0) {
+        return SERIES_END;
+    }
+    *out = value;
+    return SERIES_VALUE;
+}
+
+static series_t ntrip_bytes(int i, const char **label_value, int64_t *value)
+{
+    return one(i, ntrip_client_get_bytes_received(), value);
+}
+
+static series_t rtcm_forwarded_bytes(int i, const char **label_value, int64_t *value)
+{
+    zed_i2c_stats_t i2c;
+    zed_rover_get_i2c_stats(&i2c);
+    return one(i, i2c.rtcm_bytes_written, value);
+}
+
+static series_t rtcm_frames(int i, const char **label_value, int64_t *value)
+{
+    static const char *const results[] = { "forwarded", "duplicate", "standby" };
+    if (i >= 3) {
+        return SERIES_END;
+    }
+    rtcm_merge_stats_t merge;
+    corr_arbiter_get_merge_stats(&merge);
+    uint32_t counts[] = { merge.frames_forwarded, merge.duplicates_suppressed,
+                          merge.standby_frames_dropped };
+    *label_value = results[i];
+    *value = counts[i];
+    return SERIES_VALUE;
+}
+
+static series_t rtcm_epochs(int i, const char **label_value, int64_t *value)
+{
+    if (i >= ntrip_client_session_count()) {
+        return SERIES_END;
+    }
+    rtcm_liveness_stats_t liveness;
+    if (!ntrip_client_get_liveness_stats(i, &liveness)) {
+        return SERIES_SKIP;
+    }
+    *label_value = ntrip_client_session_name(i);
+    *value = liveness.epochs;
+    return SERIES_VALUE;
+}
+
+static series_t i2c_transactions(int i, const char **label_value, int64_t *value)
+{
+    zed_i2c_stats_t i2c;
+    zed_rover_get_i2c_stats(&i2c);
+    return one(i, i2c.transactions, value);
+}
+
+static series_t i2c_errors(int i, const char **label_value, int64_t *value)
+{
+    zed_i2c_stats_t i2c;
+    zed_rover_get_i2c_stats(&i2c);
+    return one(i, i2c.errors, value);
+}
+
+static series_t i2c_read_bytes(int i, const char **label_value, int64_t *value)
+{
+    zed_i2c_stats_t i2c;
+    zed_rover_get_i2c_stats(&i2c);
+    return one(i, i2c.bytes_read, value);
+}
+
+static void i2c_latency(metrics_histogram_t *h)
+{
+    zed_i2c_stats_t i2c;
+    zed_rover_get_i2c_stats(&i2c);
+    *h = i2c.latency_us;
+}
+
+static void loop_time(metrics_histogram_t *h)
+{
+    *h = s_loop_us;
+}
+
+typedef enum {
+    RECONNECT_ATTEMPTS,
+    RECONNECT_SUCCESSES,
+    RECONNECT_DROPS,
+} reconnect_field_t;
+
+/**
+ * One field of the reconnect statistics, per NTRIP session
+ */
+static series_t ntrip_reconnect(int i, const char **label_value, int64_t *value,
+                                reconnect_field_t field)
+{
+    if (i >= ntrip_client_session_count()) {
+        return SERIES_END;
+    }
+    ntrip_reconnect_stats_t stats;
+    if (!ntrip_client_get_reconnect_stats(i, &stats)) {
+        return SERIES_SKIP;
+    }
+    *label_value = ntrip_client_session_name(i);
+    switch (field) {
+        case RECONNECT_ATTEMPTS:  *value = stats.attempts; break;
+        case RECONNECT_SUCCESSES: *value = stats.successes; break;
+        case RECONNECT_DROPS:     *value = stats.drops; break;
+    }
+    return SERIES_VALUE;
+}
+
+static series_t ntrip_attempts(int i, const char **label_value, int64_t *value)
+{
+    return ntrip_reconnect(i, label_value, value, RECONNECT_ATTEMPTS);
+}
+
+static series_t ntrip_successes(int i, const char **label_value, int64_t *value)
+{
+    return ntrip_reconnect(i, label_value, value, RECONNECT_SUCCESSES);
+}
+
+static series_t ntrip_drops(int i, const char **label_value, int64_t *value)
+{
+    return ntrip_reconnect(i, label_value, value, RECONNECT_DROPS);
+}
+
+static series_t ntrip_connected(int i, const char **label_value, int64_t *value)
+{
+    if (i >= ntrip_client_session_count()) {
+        return SERIES_END;
+    }
+    *label_value = ntrip_client_session_name(i);
+    *value = ntrip_client_session_is_connected(i) ? 1 : 0;
+    return SERIES_VALUE;
+}
+
+static series_t dashboard_posts(int i, const char **label_value, int64_t *value)
+{
+    dashboard_stats_t stats;
+    dashboard_get_stats(&stats);
+    return one(i, stats.posts, value);
+}
+
+static series_t dashboard_failures(int i, const char **label_value, int64_t *value)
+{
+    dashboard_stats_t stats;
+    dashboard_get_stats(&stats);
+    return one(i, stats.failures, value);
+}
+
+static void dashboard_latency(metrics_histogram_t *h)
+{
+    dashboard_stats_t stats;
+    dashboard_get_stats(&stats);
+    *h = stats.latency_ms;
+}
+
+static series_t heap_free(int i, const char **label_value, int64_t *value)
+{
+    return one(i, esp_get_free_heap_size(), value);
+}
+
+static series_t heap_min_free(int i, const char **label_value, int64_t *value)
+{
+    return one(i, esp_get_minimum_free_heap_size(), value);
+}
+
+static series_t task_stack(int i, const char **label_value, int64_t *value)
+{
+    if (i >= (int)(sizeof(k_tasks) / sizeof(k_tasks[0]))) {
+        return SERIES_END;
+    }
+    TaskHandle_t task = xTaskGetHandle(k_tasks[i]);
+    if (task == NULL) {
+        return SERIES_SKIP;
+    }
+    *label_value = k_tasks[i];
+    *value = uxTaskGetStackHighWaterMark(task);    // Bytes on ESP-IDF
+    return SERIES_VALUE;
+}
+
+static series_t wifi_rssi(int i, const char **label_value, int64_t *value)
+{
+    int8_t rssi;
+    if (i > 0) {
+        return SERIES_END;
+    }
+    if (!wifi_get_rssi(&rssi)) {
+        return SERIES_SKIP;
+    }
+    *value = rssi;
+    return SERIES_VALUE;
+}
+
+static const family_t s_families[] = {
+    { .name = "rover_ntrip_received_bytes_total", .type = "counter",
+      .help = "Bytes received from NTRIP casters, all sessions",
+      .series = ntrip_bytes },
+    { .name = "rover_rtcm_forwarded_bytes_total", .type = "counter",
+      .help = "RTCM bytes written to the receiver",
+      .series = rtcm_forwarded_bytes },
+    { .name = "rover_rtcm_frames_total", .type = "counter",
+      .help = "RTCM frames through the correction merge",
+      .label = "result", .series = rtcm_frames },
+    { .name = "rover_rtcm_epochs_total", .type = "counter",
+      .help = "Observation epochs received",
+      .label = "session", .series = rtcm_epochs },
+    { .name = "rover_i2c_transactions_total", .type = "counter",
+      .help = "I2C transactions with the receiver",
+      .series = i2c_transactions },
+    { .name = "rover_i2c_errors_total", .type = "counter",
+      .help = "I2C transactions that failed or timed out",
+      .series = i2c_errors },
+    { .name = "rover_i2c_read_bytes_total", .type = "counter",
+      .help = "Bytes read from the receiver",
+      .series = i2c_read_bytes },
+    { .name = "rover_i2c_transaction_seconds", .type = "histogram",
+      .help = "I2C transaction time",
+      .histogram = i2c_latency, .decimals = 6 },
+    { .name = "rover_loop_seconds", .type = "histogram",
+      .help = "Rover loop pass time, excluding its delay",
+      .histogram = loop_time, .decimals = 6 },
+    { .name = "rover_ntrip_connect_attempts_total", .type = "counter",
+      .help = "NTRIP connection attempts",
+      .label = "session", .series = ntrip_attempts },
+    { .name = "rover_ntrip_connects_total", .type = "counter",
+      .help = "NTRIP attempts that reached streaming",
+      .label = "session", .series = ntrip_successes },
+    { .name = "rover_ntrip_drops_total", .type = "counter",
+      .help = "NTRIP streaming sessions that ended",
+      .label = "session", .series = ntrip_drops },
+    { .name = "rover_ntrip_connected", .type = "gauge",
+      .help = "NTRIP session streaming",
+      .label = "session", .series = ntrip_connected },
+    { .name = "rover_dashboard_posts_total", .type = "counter",
+      .help = "Dashboard batches sent",
+      .series = dashboard_posts },
+    { .name = "rover_dashboard_failures_total", .type = "counter",
+      .help = "Dashboard batches that couldn't be sent",
+      .series = dashboard_failures },
+    { .name = "rover_dashboard_response_seconds", .type = "histogram",
+      .help = "Dashboard request sent to response complete",
+      .histogram = dashboard_latency, .decimals = 3 },
+    { .name = "rover_heap_free_bytes", .type = "gauge",
+      .help = "Free heap",
+      .series = heap_free },
+    { .name = "rover_heap_min_free_bytes", .type = "gauge",
+      .help = "Lowest free heap since boot",
+      .series = heap_min_free },
+    { .name = "rover_task_stack_free_bytes", .type = "gauge",
+      .help = "Lowest free stack since the task started",
+      .label = "task", .series = task_stack },
+    { .name = "rover_wifi_rssi_dbm", .type = "gauge",
+      .help = "Signal strength of the connected AP",
+      .series = wifi_rssi },
+};
+
+#define NUM_FAMILIES (sizeof(s_families) / sizeof(s_families[0]))
+
+void metrics_histogram_observe(metrics_histogram_t *h, uint32_t value)
+{
+    uint8_t b = 0;
+    while (b < h->num_bounds && value > h->bounds[b]) {
+        b++;
+    }
+    h->counts[b]++;
+    h->count++;
+    h->sum += value;
+}
+
+void metrics_observe_loop(uint32_t us)
+{
+    metrics_histogram_observe(&s_loop_us, us);
+}
+
+void metrics_cursor_init(metrics_cursor_t *cur)
+{
+    memset(cur, 0, sizeof(*cur));
+}
+
+/**
+ * Label value, escaped as the text format requires
+ */
+static void fmt_label_value(fmt_writer_t *w, const char *s)
+{
+    for (; *s != '\0'; s++) {
+        if (*s == '\\' || *s == '"') {
+            fmt_char(w, '\\');
+            fmt_char(w, *s);
+        } else if (*s == '\n') {
+            fmt_str(w, "\\n");
+        } else {
+            fmt_char(w, *s);
+        }
+    }
+}
+
+/**
+ * Line i of a histogram: the buckets (cumulative), then _sum and _count
+ * @return false past the last line
+ */
+static bool histogram_line(fmt_writer_t *w, const family_t *f, const metrics_histogram_t *h, int i)
+{
+    if (i > h->num_bounds + 2) {
+        return false;
+    }
+    fmt_str(w, f->name);
+    if (i <= h->num_bounds) {
+        uint32_t cumulative = 0;
+        for (int b = 0; b <= i; b++) {
+            cumulative += h->counts[b];
+        }
+        fmt_str(w, "_bucket{le=\"");
+        if (i < h->num_bounds) {
+            fmt_fixed64(w, h->bounds[i], f->decimals);
+        } else {
+            fmt_str(w, "+Inf");
+        }
+        fmt_str(w, "\"} ");
+        fmt_uint(w, cumulative, 1);
+    } else if (i == h->num_bounds + 1) {
+        fmt_str(w, "_sum ");
+        fmt_fixed64(w, (int64_t)h->sum, f->decimals);
+    } else {
+        fmt_str(w, "_count ");
+        fmt_uint(w, h->count, 1);
+    }
+    fmt_char(w, '\n');
+    return true;
+}
+
+/**
+ * Line i of a counter or gauge
+ * @return false past the last series
+ */
+static bool series_line(fmt_writer_t *w, const family_t *f, int i)
+{
+    const char *label_value = "";
+    int64_t value = 0;
+    series_t s = f->series(i, &label_value, &value);
+    if (s != SERIES_VALUE) {
+        return s == SERIES_SKIP;
+    }
+
+    fmt_str(w, f->name);
+    if (f->label != NULL) {
+        fmt_char(w, '{');
+        fmt_str(w, f->label);
+        fmt_str(w, "=\"");
+        fmt_label_value(w, label_value != NULL ? label_value : "");
+        fmt_str(w, "\"}");
+    }
+    fmt_char(w, ' ');
+    fmt_fixed64(w, value, 0);
+    fmt_char(w, '\n');
+    return true;
+}
+
+size_t metrics_render(metrics_cursor_t *cur, char *buf, size_t size)
+{
+    fmt_writer_t w;
+    fmt_init(&w, buf, size);
+
+    while (cur->family < NUM_FAMILIES) {
+        const family_t *f = &s_families[cur->family];
+        size_t mark = w.len;
+        bool more = true;
+
+        if (cur->line == 0) {
+            if (f->histogram != NULL) {
+                f->histogram(&cur->snapshot);
+            }
+            fmt_str(&w, "# HELP ");
+            fmt_str(&w, f->name);
+            fmt_char(&w, ' ');
+            fmt_str(&w, f->help);
+            fmt_char(&w, '\n');
+        } else if (cur->line == 1) {
+            fmt_str(&w, "# TYPE ");
+            fmt_str(&w, f->name);
+            fmt_char(&w, ' ');
+            fmt_str(&w, f->type);
+            fmt_char(&w, '\n');
+        } else if (f->histogram != NULL) {
+            more = histogram_line(&w, f, &cur->snapshot, cur->line - 2);
+        } else {
+            more = series_line(&w, f, cur->line - 2);
+        }
+
+        if (w.overflow) {
+            // Take the partial line back; it goes first in the next buffer
+            w.len = mark;
+            w.overflow = false;
+            if (mark > 0) {
+                break;
+            }
+            more = true;    // Can't fit even alone - skip it rather than stall
+        }
+        if (more) {
+            cur->line++;
+        } else {
+            cur->family++;
+            cur->line = 0;
+        }
+    }
+
+    fmt_finish(&w);
+    return w.len;
+}
@@ -0,0 +1,61 @@
+/**
+ * Metrics - Prometheus text exposition of the firmware's counters
+ *
+ * Pulls from each module's *_get_stats() at scrape time; the only state
+ * kept here is the rover loop timing. Rendering is resumable, a buffer's
+ * worth of whole lines at a time, so a scrape never needs the full
+ * response in RAM.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define METRICS_HISTOGRAM_MAX_BOUNDS 8
+
+/**
+ * Fixed-bucket histogram (single writer)
+ * Set bounds and num_bounds in its initializer; the rest starts at zero.
+ */
+typedef struct {
+    const uint32_t *bounds;         // Bucket upper bounds, ascending, static
+    uint8_t num_bounds;             // At most METRICS_HISTOGRAM_MAX_BOUNDS
+    uint32_t counts[METRICS_HISTOGRAM_MAX_BOUNDS + 1];  // Per bucket, the last is above all bounds
+    uint32_t count;
+    uint64_t sum;
+} metrics_histogram_t;
+
+/**
+ * Scrape progress, one per response being sent
+ */
+typedef struct {
+    uint16_t family;
+    uint16_t line;
+    metrics_histogram_t snapshot;   // Histogram being rendered, so its lines agree
+} metrics_cursor_t;
+
+/**
+ * Count one observation
+ */
+void metrics_histogram_observe(metrics_histogram_t *h, uint32_t value);
+
+/**
+ * Record the time one pass of the rover loop took, in microseconds
+ */
+void metrics_observe_loop(uint32_t us);
+
+/**
+ * Start a new scrape
+ */
+void metrics_cursor_init(metrics_cursor_t *cur);
+
+/**
+ * Render the next whole lines of the exposition into buf
+ * @return Bytes written (no NUL counted), 0 once everything has been rendered
+ */
+size_t metrics_render(metrics_cursor_t *cur, char *buf, size_t size);
+
+#endif // METRICS_H
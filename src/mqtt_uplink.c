@@ -0,0 +1,357 @@
+/**
+ * MQTT Uplink - Telemetry over one long-lived MQTT session
+ *
+ * Built on the ESP-IDF MQTT client, which runs its own task and handles
+ * keepalive (PINGREQ every MQTT_KEEPALIVE_S) and reconnection. Positions
+ * are QoS 0: a lost one is superseded a second later, and when there is no
+ * session the telemetry task keeps them in the telemetry store and sends
+ * them later as one backfill message. Events are QoS 1 and wait in the
+ * client's outbox (bounded by MQTT_OUTBOX_LIMIT) while offline.
+ *
+ * The client task reports PUBACKs through a single-producer ring that the
+ * publishing task drains in mqtt_uplink_poll(), so send times, round-trip
+ * times and the backfill state all have one writer and need no lock - and
+ * a PUBACK that arrives before publish() has returned its msg_id is still
+ * matched. A full ring drops acks, so the client task counts PUBACKs and
+ * expiries itself and keeps the backfill's outcome outside the ring; a
+ * backfill with no outcome after MQTT_BACKFILL_TIMEOUT_MS counts as failed.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mqtt_client.h"
+
+#include "mqtt_uplink.h"
+#include "config.h"
+
+static const char *TAG = "mqtt";
+
+#ifndef MQTT_BROKER_URI
+#define MQTT_BROKER_URI "mqtt://localhost:1883"
+#endif
+#ifndef MQTT_USERNAME
+#define MQTT_USERNAME ""
+#endif
+#ifndef MQTT_PASSWORD
+#define MQTT_PASSWORD ""
+#endif
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX "rtk_rover"
+#endif
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 30
+#endif
+#ifndef DASHBOARD_BINARY
+#define DASHBOARD_BINARY 0
+#endif
+
+#define MQTT_TOPIC(name)    MQTT_TOPIC_PREFIX "/" name
+#define MQTT_RECONNECT_MS   5000
+#define MQTT_OUTBOX_LIMIT   (16 * 1024)   // QoS 1 bytes held while offline
+#define MQTT_TASK_PRIORITY  3             // Below the rover loop, like the telemetry task
+#define MQTT_POSITION_MAX   448           // One JSON sample
+#define MQTT_ACK_RING       16            // Power of two
+#define MQTT_PENDING        8             // QoS 1 messages timed for RTT
+#define MQTT_RATE_WINDOW_US (10 * 1000000LL)
+#define MQTT_HEADER_BYTES   5             // Fixed header, length and topic length
+#define MQTT_BACKFILL_TIMEOUT_MS 60000    // No PUBACK or outbox expiry by then - retry
+
+typedef struct {
+    int msg_id;
+    int64_t at_us;
+    bool acked;                 // false: dropped from the outbox
+} mqtt_ack_t;
+
+static esp_mqtt_client_handle_t s_client = NULL;
+static bool s_connected = false;
+
+// Written by the client task
+static mqtt_ack_t s_acks[MQTT_ACK_RING];
+static uint32_t s_ack_head = 0;
+static uint32_t s_connects = 0;
+static uint32_t s_disconnects = 0;
+static uint32_t s_qos1_acked = 0;           // Counted here - the ring may drop acks
+static uint32_t s_qos1_expired = 0;
+static int s_backfill_ack = -1;             // (msg_id << 1) | acked of the backfill, -1 if none
+
+// Written by the publishing task
+static uint32_t s_ack_tail = 0;
+static struct {
+    int msg_id;
+    int64_t sent_us;
+} s_pending[MQTT_PENDING];
+static uint32_t s_pending_next = 0;
+static int s_backfill_msg_id = -1;          // Read by the client task
+static int64_t s_backfill_sent_us = 0;
+static telemetry_backfill_t s_backfill = TELEMETRY_BACKFILL_IDLE;
+static uint64_t s_rtt_total_ms = 0;
+static uint32_t s_rtt_samples = 0;
+static int64_t s_rate_start_us = 0;
+static uint32_t s_rate_start_count = 0;
+static mqtt_uplink_stats_t s_stats;
+
+static void push_ack(int msg_id, bool acked)
+{
+    if (msg_id == __atomic_load_n(&s_backfill_msg_id, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&s_backfill_ack, (msg_id << 1) | acked, __ATOMIC_RELEASE);
+    }
+
+    uint32_t head = s_ack_head;
+    if (head - __atomic_load_n(&s_ack_tail, __ATOMIC_ACQUIRE) >= MQTT_ACK_RING) {
+        return;  // Publisher far behind - only an RTT sample is lost
+    }
+    mqtt_ack_t *slot = &s_acks[head & (MQTT_ACK_RING - 1)];
+    slot->msg_id = msg_id;
+    slot->at_us = esp_timer_get_time();
+    slot->acked = acked;
+    __atomic_store_n(&s_ack_head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = event_data;
+
+    switch ((esp_mqtt_event_id_t)event_id) {
+    case MQTT_EVENT_CONNECTED:
+        ESP_LOGI(TAG, "Connected to %s", MQTT_BROKER_URI);
+        __atomic_store_n(&s_connected, true, __ATOMIC_RELEASE);
+        s_connects++;
+        esp_mqtt_client_publish(s_client, MQTT_TOPIC("status"), "online", 0, 1, 1);
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        if (__atomic_load_n(&s_connected, __ATOMIC_ACQUIRE)) {
+            ESP_LOGW(TAG, "Disconnected - reconnecting in %d ms", MQTT_RECONNECT_MS);
+            s_disconnects++;
+        }
+        __atomic_store_n(&s_connected, false, __ATOMIC_RELEASE);
+        break;
+    case MQTT_EVENT_PUBLISHED:
+        s_qos1_acked++;
+        push_ack(event->msg_id, true);
+        break;
+    case MQTT_EVENT_DELETED:
+        s_qos1_expired++;
+        push_ack(event->msg_id, false);
+        break;
+    case MQTT_EVENT_ERROR:
+        ESP_LOGD(TAG, "Client error");
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t mqtt_uplink_init(void)
+{
+    esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = MQTT_BROKER_URI,
+        .credentials.username = MQTT_USERNAME[0] != '\0' ? MQTT_USERNAME : NULL,
+        .credentials.authentication.password = MQTT_PASSWORD[0] != '\0' ? MQTT_PASSWORD : NULL,
+        .session.keepalive = MQTT_KEEPALIVE_S,
+        .session.last_will = {
+            .topic = MQTT_TOPIC("status"),
+            .msg = "offline",
+            .qos = 1,
+            .retain = 1,
+        },
+        .network.reconnect_timeout_ms = MQTT_RECONNECT_MS,
+        .task.priority = MQTT_TASK_PRIORITY,
+        .outbox.limit = MQTT_OUTBOX_LIMIT,
+    };
+
+    s_client = esp_mqtt_client_init(&cfg);
+    if (s_client == NULL) {
+        ESP_LOGE(TAG, "Failed to create MQTT client");
+        return ESP_FAIL;
+    }
+    esp_mqtt_client_register_event(s_client, MQTT_EVENT_ANY, mqtt_event_handler, NULL);
+    esp_err_t err = esp_mqtt_client_start(s_client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Publishing to %s under %s/", MQTT_BROKER_URI, MQTT_TOPIC_PREFIX);
+    return ESP_OK;
+}
+
+bool mqtt_uplink_connected(void)
+{
+    return __atomic_load_n(&s_connected, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Account for a message handed to the client
+ */
+static void note_published(const char *topic, size_t len)
+{
+    s_stats.bytes_sent += MQTT_HEADER_BYTES + strlen(topic) + len;
+
+    int64_t now = esp_timer_get_time();
+    uint32_t count = s_stats.positions + s_stats.qos1_sent;
+    if (s_rate_start_us == 0) {
+        s_rate_start_us = now;
+        s_rate_start_count = count;
+    } else if (now - s_rate_start_us >= MQTT_RATE_WINDOW_US) {
+        s_stats.msgs_per_s = (count - s_rate_start_count) * 1e6f / (float)(now - s_rate_start_us);
+        s_rate_start_us = now;
+        s_rate_start_count = count;
+    }
+}
+
+/**
+ * Publish at QoS 1: straight to the socket when connected, into the
+ * outbox otherwise
+ * @return msg_id, or -1
+ */
+static int publish_qos1(const char *topic, const char *data, size_t len)
+{
+    bool connected = mqtt_uplink_connected();
+    int msg_id;
+    if (connected) {
+        msg_id = esp_mqtt_client_publish(s_client, topic, data, len, 1, 0);
+    } else {
+        msg_id = esp_mqtt_client_enqueue(s_client, topic, data, len, 1, 0, true);
+    }
+    if (msg_id < 0) {
+        return -1;
+    }
+
+    // Only time what went straight out - the outbox wait isn't broker RTT
+    if (connected) {
+        s_pending[s_pending_next].msg_id = msg_id;
+        s_pending[s_pending_next].sent_us = esp_timer_get_time();
+        s_pending_next = (s_pending_next + 1) % MQTT_PENDING;
+    }
+    s_stats.qos1_sent++;
+    note_published(topic, len);
+    return msg_id;
+}
+
+esp_err_t mqtt_uplink_publish_position(const telemetry_record_t *rec)
+{
+    if (s_client == NULL || rec == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!mqtt_uplink_connected()) {
+        s_stats.offline++;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // QoS 0 may lose any message, so each one must decode on its own
+#if DASHBOARD_BINARY
+    uint8_t buf[TELEMETRY_CODEC_MAX_SAMPLE];
+    telemetry_codec_t codec;
+    telemetry_codec_reset(&codec);
+    int len = (int)telemetry_codec_encode(&codec, rec, buf);
+#else
+    char buf[MQTT_POSITION_MAX];
+    int len = telemetry_codec_format_json(rec, buf, sizeof(buf));
+    if (len >= (int)sizeof(buf)) {
+        len = sizeof(buf) - 1;
+    }
+#endif
+
+    if (esp_mqtt_client_publish(s_client, MQTT_TOPIC("position"), (const char *)buf, len, 0, 0) < 0) {
+        s_stats.offline++;
+        return ESP_FAIL;
+    }
+    s_stats.positions++;
+    note_published(MQTT_TOPIC("position"), len);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_uplink_publish_event(const char *json)
+{
+    if (s_client == NULL || json == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return publish_qos1(MQTT_TOPIC("event"), json, strlen(json)) < 0 ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t mqtt_uplink_send_backfill(const uint8_t *body, size_t len)
+{
+    if (body == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_client == NULL || !mqtt_uplink_connected() || s_backfill == TELEMETRY_BACKFILL_IN_FLIGHT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    __atomic_store_n(&s_backfill_ack, -1, __ATOMIC_RELEASE);
+    int msg_id = publish_qos1(MQTT_TOPIC("backfill"), (const char *)body, len);
+    if (msg_id < 0) {
+        return ESP_FAIL;
+    }
+    __atomic_store_n(&s_backfill_msg_id, msg_id, __ATOMIC_RELEASE);
+    s_backfill_sent_us = esp_timer_get_time();
+    s_backfill = TELEMETRY_BACKFILL_IN_FLIGHT;
+    return ESP_OK;
+}
+
+telemetry_backfill_t mqtt_uplink_backfill_result(void)
+{
+    if (s_backfill == TELEMETRY_BACKFILL_IN_FLIGHT) {
+        int ack = __atomic_load_n(&s_backfill_ack, __ATOMIC_ACQUIRE);
+        if (ack >= 0 && (ack >> 1) == s_backfill_msg_id) {
+            s_backfill = (ack & 1) ? TELEMETRY_BACKFILL_DONE : TELEMETRY_BACKFILL_FAILED;
+        } else if (esp_timer_get_time() - s_backfill_sent_us >=
+                   (int64_t)MQTT_BACKFILL_TIMEOUT_MS * 1000) {
+            ESP_LOGW(TAG, "Backfill message %d never acknowledged", s_backfill_msg_id);
+            s_backfill = TELEMETRY_BACKFILL_FAILED;
+        }
+    }
+    if (s_backfill != TELEMETRY_BACKFILL_IN_FLIGHT) {
+        __atomic_store_n(&s_backfill_msg_id, -1, __ATOMIC_RELEASE);
+    }
+
+    telemetry_backfill_t result = s_backfill;
+    if (result != TELEMETRY_BACKFILL_IN_FLIGHT) {
+        s_backfill = TELEMETRY_BACKFILL_IDLE;
+    }
+    return result;
+}
+
+void mqtt_uplink_poll(void)
+{
+    uint32_t tail = s_ack_tail;
+    uint32_t head = __atomic_load_n(&s_ack_head, __ATOMIC_ACQUIRE);
+
+    for (; tail != head; tail++) {
+        mqtt_ack_t ack = s_acks[tail & (MQTT_ACK_RING - 1)];
+
+        if (ack.acked) {
+            for (int i = 0; i < MQTT_PENDING; i++) {
+                if (s_pending[i].msg_id == ack.msg_id && s_pending[i].sent_us != 0) {
+                    s_stats.last_rtt_ms = (uint32_t)((ack.at_us - s_pending[i].sent_us) / 1000);
+                    s_rtt_total_ms += s_stats.last_rtt_ms;
+                    s_rtt_samples++;
+                    s_stats.avg_rtt_ms = (uint32_t)(s_rtt_total_ms / s_rtt_samples);
+                    s_pending[i].sent_us = 0;
+                    break;
+                }
+            }
+        } else {
+            ESP_LOGW(TAG, "Message %d expired from the outbox", ack.msg_id);
+        }
+
+        if (s_backfill == TELEMETRY_BACKFILL_IN_FLIGHT && ack.msg_id == s_backfill_msg_id) {
+            s_backfill = ack.acked ? TELEMETRY_BACKFILL_DONE : TELEMETRY_BACKFILL_FAILED;
+        }
+    }
+    __atomic_store_n(&s_ack_tail, tail, __ATOMIC_RELEASE);
+}
+
+void mqtt_uplink_get_stats(mqtt_uplink_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+    stats->connected = mqtt_uplink_connected();
+    stats->connects = s_connects;
+    stats->disconnects = s_disconnects;
+    stats->qos1_acked = s_qos1_acked;
+    stats->qos1_expired = s_qos1_expired;
+}
@@ -0,0 +1,86 @@
+/**
+ * MQTT Uplink - Telemetry over one long-lived MQTT session
+ *
+ * Alternative transport to dashboard_client.c for fleet backends (select
+ * with MQTT_ENABLED). Topics under MQTT_TOPIC_PREFIX:
+ *
+ *   position  QoS 0   One message per sample
+ *   event     QoS 1   Fix quality changes, periodic status
+ *   backfill  QoS 1   Samples stored while offline (telemetry_codec stream)
+ *   status    QoS 1   Retained "online", or "offline" as the last will
+ */
+
+#ifndef MQTT_UPLINK_H
+#define MQTT_UPLINK_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "telemetry_codec.h"
+#include "telemetry_store.h"
+
+/**
+ * Uplink statistics
+ */
+typedef struct {
+    bool connected;
+    uint32_t connects;          // Sessions established
+    uint32_t disconnects;
+    uint32_t positions;         // QoS 0 position messages published
+    uint32_t offline;           // Positions not published for lack of a session
+    uint32_t qos1_sent;         // Events and backfill messages
+    uint32_t qos1_acked;        // PUBACKs received for them
+    uint32_t qos1_expired;      // Dropped from the outbox unacknowledged
+    float msgs_per_s;           // Messages published, last 10 s window
+    uint32_t last_rtt_ms;       // QoS 1 PUBLISH to PUBACK
+    uint32_t avg_rtt_ms;
+    uint32_t bytes_sent;        // Payload, topic and MQTT headers (estimated)
+} mqtt_uplink_stats_t;
+
+/**
+ * Start the MQTT client (connects, keeps alive and reconnects by itself)
+ */
+esp_err_t mqtt_uplink_init(void);
+
+/**
+ * Check if a session is up
+ */
+bool mqtt_uplink_connected(void);
+
+/**
+ * Publish one position sample at QoS 0
+ * JSON, or a telemetry_codec keyframe with DASHBOARD_BINARY.
+ * @return ESP_ERR_INVALID_STATE when offline - the caller stores the sample
+ */
+esp_err_t mqtt_uplink_publish_position(const telemetry_record_t *rec);
+
+/**
+ * Publish an event (JSON object) at QoS 1
+ * Held in the client's outbox while offline and sent on reconnect.
+ */
+esp_err_t mqtt_uplink_publish_event(const char *json);
+
+/**
+ * Publish stored samples at QoS 1; one backfill message may be outstanding
+ * @return ESP_ERR_INVALID_STATE if offline or a backfill is outstanding
+ */
+esp_err_t mqtt_uplink_send_backfill(const uint8_t *body, size_t len);
+
+/**
+ * Get the outcome of the backfill message (DONE/FAILED reported once)
+ * Without a PUBACK or outbox expiry within a minute it counts as FAILED.
+ */
+telemetry_backfill_t mqtt_uplink_backfill_result(void);
+
+/**
+ * Process acknowledgements from the client task (call from the publisher)
+ */
+void mqtt_uplink_poll(void);
+
+/**
+ * Get uplink statistics
+ */
+void mqtt_uplink_get_stats(mqtt_uplink_stats_t *stats);
+
+#endif // MQTT_UPLINK_H
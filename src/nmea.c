@@ -0,0 +1,89 @@
+/**
+ * NMEA Output - Sentences sent upstream to the caster
+ *
+ * Coordinates are rendered from 1e-7 degree integers to ddmm.mmmmm with
+ * integer arithmetic (fixed_format.c), which avoids soft-float printf on
+ * the ESP32.
+ */
+
+#include <string.h>
+
+#include "nmea.h"
+#include "fixed_format.h"
+
+/**
+ * 1e-7 degrees -> d..dmm.mmmmm,H
+ */
+static void put_coord(fmt_writer_t *w, int32_t value_e7, int deg_digits,
+                      char positive, char negative)
+{
+    uint32_t a = value_e7 < 0 ? (uint32_t)(-(int64_t)value_e7) : (uint32_t)value_e7;
+    uint32_t deg = a / 10000000;
+    uint32_t frac = a % 10000000;
+
+    // Fraction of a degree -> minutes in 1e-5 units, rounded
+    uint32_t min_e5 = (frac * 60 + 50) / 100;
+    if (min_e5 >= 6000000) {
+        deg++;
+        min_e5 -= 6000000;
+    }
+
+    fmt_uint(w, deg, deg_digits);
+    fmt_uint(w, min_e5 / 100000, 2);
+    fmt_char(w, '.');
+    fmt_uint(w, min_e5 % 100000, 5);
+    fmt_char(w, ',');
+    fmt_char(w, value_e7 < 0 ? negative : positive);
+}
+
+/**
+ * GGA fix quality from NAV-PVT fix type and carrier solution
+ */
+static uint32_t gga_quality(const zed_position_t *pos)
+{
+    if (!pos->valid) return 0;
+    if (pos->carr_soln == 2) return 4;   // RTK fixed
+    if (pos->carr_soln == 1) return 5;   // RTK float
+    return 1;                            // Autonomous GNSS
+}
+
+int nmea_format_gga(char *buf, size_t max_len, const zed_position_t *pos)
+{
+    if (buf == NULL || pos == NULL || max_len == 0) {
+        return -1;
+    }
+
+    fmt_writer_t w;
+    fmt_init(&w, buf, max_len);
+
+    fmt_str(&w, "$GPGGA,");
+    fmt_uint(&w, pos->hour, 2);
+    fmt_uint(&w, pos->min, 2);
+    fmt_uint(&w, pos->sec, 2);
+    fmt_str(&w, ".00,");
+    put_coord(&w, pos->lat_e7, 2, 'N', 'S');
+    fmt_char(&w, ',');
+    put_coord(&w, pos->lon_e7, 3, 'E', 'W');
+    fmt_char(&w, ',');
+    fmt_uint(&w, gga_quality(pos), 1);
+    fmt_char(&w, ',');
+    fmt_uint(&w, pos->num_sv, 2);
+    fmt_char(&w, ',');
+    fmt_fixed(&w, pos->p_dop, 2);
+    fmt_char(&w, ',');
+    fmt_fixed(&w, pos->alt_mm, 3);
+    fmt_str(&w, ",M,,M,,");
+
+    // Checksum covers everything between '$' and '*'
+    uint8_t cs = 0;
+    for (size_t i = 1; i < w.len; i++) {
+        cs ^= (uint8_t)buf[i];
+    }
+    static const char hex[] = "0123456789ABCDEF";
+    fmt_char(&w, '*');
+    fmt_char(&w, hex[cs >> 4]);
+    fmt_char(&w, hex[cs & 0x0F]);
+    fmt_str(&w, "\r\n");
+
+    return fmt_finish(&w);
+}
@@ -0,0 +1,21 @@
+/**
+ * NMEA Output - Sentences sent upstream to the caster
+ */
+
+#ifndef NMEA_H
+#define NMEA_H
+
+#include <stddef.h>
+#include "zed_rover.h"
+
+// Longest GGA we produce, including checksum and CRLF
+#define NMEA_GGA_MAX_LEN 96
+
+/**
+ * Format a GGA sentence for the given position
+ * Integer arithmetic only, no heap, no printf.
+ * @return Length written (excluding NUL), or -1 if buf is too small
+ */
+int nmea_format_gga(char *buf, size_t max_len, const zed_position_t *pos);
+
+#endif // NMEA_H
@@ -1,28 +1,223 @@
 /**
  * NTRIP Client (Rover Mode)
  * Connects to NTRIP caster to receive RTCM corrections
+ *
+ * Each configured caster is a session with its own non-blocking connection
+ * state machine. Each session is a correction source (corr_source.h); with
+ * a standby caster configured, both sessions stream at the same time and
+ * corr_arbiter picks, frame by frame, which one reaches the receiver - so
+ * losing the primary costs about one epoch, not a reconnect.
+ *
+ * VRS and network mountpoints also get the rover position upstream as GGA:
+ * once in the request header (Ntrip-GGA), again as soon as the stream
+ * starts, and then every NTRIP_GGA_INTERVAL_MS.
+ *
+ * A session's health is judged by RTCM epoch cadence (rtcm_liveness), not
+ * by bytes: a caster that only sends keepalives or 1005 records is
+ * declared degraded after 2.5 missed epochs. TCP keepalive covers the case
+ * where the peer vanishes without a FIN.
+ *
+ * Casters that only listen on TLS (usually port 2102) are reached through
+ * ntrip_tls; the handshake is one more non-blocking state, and the TLS
+ * session is cached per caster so reconnects resume it.
+ *
+ * Optionally a session can use the NTRIP 2.0 RTP/UDP transport instead:
+ * the same GET is sent in a UDP datagram, RTCM comes back in RTP packets,
+ * and a lost packet costs one frame instead of stalling the stream behind
+ * a TCP retransmission.
  */
 
 #include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <errno.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "ntrip_client.h"
+#include "dns_resolver.h"
+#include "rtcm3.h"
+#include "rtcm_liveness.h"
+#include "ntrip_tls.h"
+#include "ntrip_rtp.h"
+#include "nmea.h"
+#include "ntrip_sourcetable.h"
 #include "config.h"
 
 static const char *TAG = "ntrip_client";
 
-static int s_sock = -1;
-static bool s_connected = false;
-static uint32_t s_bytes_received = 0;
-static TickType_t s_last_data_time = 0;
+#ifndef NTRIP_STANDBY_ENABLED
+#define NTRIP_STANDBY_ENABLED 0
+#endif
+#ifndef NTRIP_TLS
+#define NTRIP_TLS 0
+#endif
+#ifndef NTRIP_STANDBY_TLS
+#define NTRIP_STANDBY_TLS 0
+#endif
+#ifndef NTRIP_UDP
+#define NTRIP_UDP 0
+#endif
+#ifndef NTRIP_STANDBY_UDP
+#define NTRIP_STANDBY_UDP 0
+#endif
+#ifndef NTRIP_SEND_GGA
+#define NTRIP_SEND_GGA 0
+#endif
+#ifndef NTRIP_GGA_INTERVAL_MS
+#define NTRIP_GGA_INTERVAL_MS 10000
+#endif
 
-// How long without data before we consider the connection stale
-#define NTRIP_STALE_TIMEOUT_MS 15000
+/**
+ * Connection state machine - every state is polled without blocking
+ */
+typedef enum {
+    NTRIP_STATE_IDLE = 0,       // Waiting for the reconnect delay to expire
+    NTRIP_STATE_RESOLVING,      // Waiting for the DNS cache
+    NTRIP_STATE_CONNECTING,     // Non-blocking TCP connect in progress (TCP only)
+    NTRIP_STATE_TLS_HANDSHAKE,  // TCP up, TLS handshake in progress
+    NTRIP_STATE_AWAIT_RESPONSE, // GET sent, collecting response header
+    NTRIP_STATE_STREAMING,      // Receiving RTCM
+} ntrip_state_t;
+
+/**
+ * One caster connection
+ */
+typedef struct {
+    const char *name;
+    const char *host;
+    uint16_t port;
+    char mountpoint[NTRIP_MOUNTPOINT_MAX];
+    const char *user;
+    const char *password;
+    bool use_tls;
+    bool use_udp;               // NTRIP 2.0 RTP/UDP instead of TCP
+
+    ntrip_state_t state;
+    int sock;
+    ntrip_tls_t tls;
+    ntrip_rtp_t rtp;
+    int64_t state_since_ms;
+    int64_t request_sent_ms;
+    uint32_t response_rtt_ms;   // GET to response header, last successful connect
+    ntrip_reconnect_t reconnect;
+    uint32_t bytes_received;
+    uint32_t bytes_sent;
+    rtcm_liveness_t liveness;
+
+    // GGA upstream
+    bool send_gga;              // Mountpoint needs the rover position
+    bool gga_sent;              // At least one GGA sent on this stream
+    int64_t last_gga_ms;
+
+    // Response header while connecting
+    char response[512];
+    int response_len;
+
+    // Raw stream, split into frames before it is offered to the selector
+    uint8_t rx[NTRIP_RTP_MAX_PAYLOAD];  // Holds one whole RTP payload
+    size_t rx_len;
+    size_t rx_off;
+    rtcm3_framer_t framer;
+    rtcm3_frame_t frame;
+    bool frame_pending;         // frame is complete but not yet offered
+} ntrip_session_t;
+
+#define NTRIP_MAX_SESSIONS 2
+
+static ntrip_session_t s_sessions[NTRIP_MAX_SESSIONS];
+static int s_num_sessions = 0;
+static corr_source_t s_sources[NTRIP_MAX_SESSIONS];
+
+// Latest valid rover position, for GGA upstream
+static zed_position_t s_position;
+static bool s_have_position = false;
+
+// TCP keepalive: probe after 5 s idle, every 2 s, give up after 3 misses
+#define NTRIP_KEEPALIVE_IDLE_S  5
+#define NTRIP_KEEPALIVE_INTVL_S 2
+#define NTRIP_KEEPALIVE_COUNT   3
+
+// RTP/UDP: repeat the GET if the datagram or its answer was lost, and
+// send an empty packet when idle so the caster and NAT keep the session
+#define NTRIP_RTP_SETUP_RETRY_MS  1000
+#define NTRIP_RTP_KEEPALIVE_MS    10000
+
+// Upper bound for DNS + connect + response before an attempt is abandoned
+#define NTRIP_CONNECT_TIMEOUT_MS 10000
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void set_state(ntrip_session_t *s, ntrip_state_t state)
+{
+    s->state = state;
+    s->state_since_ms = now_ms();
+}
+
+/**
+ * send()/recv() on the session's transport, plain or TLS
+ */
+static int session_send(ntrip_session_t *s, const void *data, size_t len)
+{
+    if (s->use_udp) {
+        return ntrip_rtp_send(&s->rtp, s->sock, NTRIP_RTP_PT_DATA, data, len, now_ms());
+    }
+    if (s->use_tls) {
+        return ntrip_tls_send(&s->tls, data, len);
+    }
+    return send(s->sock, data, len, 0);
+}
+
+static int session_recv(ntrip_session_t *s, void *data, size_t len)
+{
+    if (s->use_udp) {
+        return ntrip_rtp_recv(&s->rtp, s->sock, data, len);
+    }
+    if (s->use_tls) {
+        return ntrip_tls_recv(&s->tls, data, len);
+    }
+    return recv(s->sock, data, len, 0);
+}
+
+static void close_socket(ntrip_session_t *s)
+{
+    if (s->use_tls) {
+        ntrip_tls_close(&s->tls);
+    }
+    if (s->use_udp && s->sock >= 0 &&
+        (s->state == NTRIP_STATE_AWAIT_RESPONSE || s->state == NTRIP_STATE_STREAMING)) {
+        // Best effort - otherwise the caster holds the session until it times out
+        ntrip_rtp_send(&s->rtp, s->sock, NTRIP_RTP_PT_CLOSE, NULL, 0, now_ms());
+    }
+    if (s->sock >= 0) {
+        close(s->sock);
+        s->sock = -1;
+    }
+    s->response_len = 0;
+    s->rx_len = 0;
+    s->rx_off = 0;
+    s->frame_pending = false;
+    rtcm3_framer_init(&s->framer);
+}
+
+/**
+ * Abandon the current attempt or session and schedule the next one
+ */
+static void fail(ntrip_session_t *s, ntrip_fail_reason_t reason)
+{
+    ESP_LOGW(TAG, "[%s] %s", s->name, ntrip_reconnect_reason_str(reason));
+    close_socket(s);
+    set_state(s, NTRIP_STATE_IDLE);
+    ntrip_reconnect_on_failure(&s->reconnect, reason, now_ms());
+}
 
 /**
  * Base64 encode credentials for HTTP Basic Auth
@@ -50,201 +245,710 @@ static void base64_encode(const char *input, char *output, size_t output_len)
     output[j] = '\0';
 }
 
-esp_err_t ntrip_client_connect(void)
+/**
+ * Build the NTRIP GET request
+ * @return Request length, or -1 if it doesn't fit in max_len
+ */
+static int build_request(const ntrip_session_t *s, char *request, size_t max_len)
 {
-    if (s_connected) {
-        return ESP_OK;
-    }
-
-    ESP_LOGI(TAG, "Connecting to NTRIP caster: %s:%d/%s",
-             NTRIP_HOST, NTRIP_PORT, NTRIP_MOUNTPOINT);
-
-    // Resolve hostname
-    struct hostent *host = gethostbyname(NTRIP_HOST);
-    if (host == NULL) {
-        ESP_LOGE(TAG, "DNS lookup failed for %s", NTRIP_HOST);
-        return ESP_FAIL;
-    }
-
-    // Create socket
-    s_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (s_sock < 0) {
-        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
-        return ESP_FAIL;
-    }
-
-    // Set socket timeout
-    struct timeval timeout = {
-        .tv_sec = 10,
-        .tv_usec = 0
-    };
-    setsockopt(s_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    setsockopt(s_sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
-
-    // Connect
-    struct sockaddr_in server_addr = {
-        .sin_family = AF_INET,
-        .sin_port = htons(NTRIP_PORT),
-        .sin_addr = *((struct in_addr *)host->h_addr),
-    };
-
-    if (connect(s_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) != 0) {
-        ESP_LOGE(TAG, "Socket connect failed: errno %d", errno);
-        close(s_sock);
-        s_sock = -1;
-        return ESP_FAIL;
-    }
-
-    ESP_LOGI(TAG, "TCP connected, sending GET request...");
-
     // Build NTRIP client request - MUST match exact format that works
     // Order matters: Host, User-Agent, Ntrip-Version, Authorization, then empty line
-    char request[512];
     int req_len;
 
+    // NTRIP 2.0 lets the client pass its position with the request, so a
+    // VRS caster can start generating corrections before the first GGA
+    char gga_header[NMEA_GGA_MAX_LEN + 16] = "";
+    if (s->send_gga && s_have_position) {
+        char gga[NMEA_GGA_MAX_LEN];
+        int gga_len = nmea_format_gga(gga, sizeof(gga), &s_position);
+        if (gga_len > 2) {
+            snprintf(gga_header, sizeof(gga_header), "Ntrip-GGA: %.*s\r\n", gga_len - 2, gga);
+        }
+    }
+
     // Check if we need authentication
-    if (strlen(NTRIP_USER) > 0 && strlen(NTRIP_PASSWORD) > 0) {
+    if (strlen(s->user) > 0 && strlen(s->password) > 0) {
         // Build credentials string and encode
         char credentials[128];
         char auth_base64[256];
-        snprintf(credentials, sizeof(credentials), "%s:%s", NTRIP_USER, NTRIP_PASSWORD);
+        snprintf(credentials, sizeof(credentials), "%s:%s", s->user, s->password);
         base64_encode(credentials, auth_base64, sizeof(auth_base64));
 
-        req_len = snprintf(request, sizeof(request),
+        req_len = snprintf(request, max_len,
             "GET /%s HTTP/1.1\r\n"
             "Host: %s\r\n"
             "User-Agent: NTRIP TestClient/1.0\r\n"
             "Ntrip-Version: Ntrip/2.0\r\n"
             "Authorization: Basic %s\r\n"
+            "%s"
             "\r\n",
-            NTRIP_MOUNTPOINT, NTRIP_HOST, auth_base64);
-
-        ESP_LOGI(TAG, "Using authentication for NTRIP");
+            s->mountpoint, s->host, auth_base64, gga_header);
     } else {
-        req_len = snprintf(request, sizeof(request),
+        req_len = snprintf(request, max_len,
             "GET /%s HTTP/1.1\r\n"
             "Host: %s\r\n"
             "User-Agent: NTRIP TestClient/1.0\r\n"
             "Ntrip-Version: Ntrip/2.0\r\n"
+            "%s"
             "\r\n",
-            NTRIP_MOUNTPOINT, NTRIP_HOST);
+            s->mountpoint, s->host, gga_header);
+    }
+
+    if (req_len < 0 || req_len >= (int)max_len) {
+        return -1;
     }
+    return req_len;
+}
 
-    if (send(s_sock, request, req_len, 0) < 0) {
-        ESP_LOGE(TAG, "Failed to send GET request: errno %d", errno);
-        close(s_sock);
-        s_sock = -1;
-        return ESP_FAIL;
+/**
+ * Send the GET request (over RTP it travels as an HTTP-type packet)
+ */
+static bool write_request(ntrip_session_t *s)
+{
+    char request[640];
+    int req_len = build_request(s, request, sizeof(request));
+    if (req_len < 0) {
+        ESP_LOGE(TAG, "[%s] GET request exceeds %d bytes", s->name, (int)sizeof(request));
+        return false;
     }
 
-    // Read response
-    char response[512];
-    int len = recv(s_sock, response, sizeof(response) - 1, 0);
+    int sent;
+    if (s->use_udp) {
+        sent = ntrip_rtp_send(&s->rtp, s->sock, NTRIP_RTP_PT_HTTP, request, req_len, now_ms());
+    } else {
+        sent = session_send(s, request, req_len);
+    }
+    if (sent != req_len) {
+        ESP_LOGE(TAG, "[%s] Failed to send GET request: errno %d", s->name, errno);
+        return false;
+    }
+    s->bytes_sent += req_len;
+    s->request_sent_ms = now_ms();
+    return true;
+}
+
+/**
+ * Transport is up - send the GET request
+ */
+static void send_request(ntrip_session_t *s)
+{
+    ESP_LOGI(TAG, "[%s] %s ready, sending GET request...",
+             s->name, s->use_udp ? "RTP/UDP" : s->use_tls ? "TLS" : "TCP");
+
+    if (!write_request(s)) {
+        fail(s, NTRIP_FAIL_TRANSPORT);
+        return;
+    }
+    s->response_len = 0;
+    set_state(s, NTRIP_STATE_AWAIT_RESPONSE);
+}
+
+/**
+ * Drive the TLS handshake without blocking
+ */
+static void poll_handshake(ntrip_session_t *s)
+{
+    esp_err_t err = ntrip_tls_handshake(&s->tls);
+    if (err == ESP_OK) {
+        send_request(s);
+    } else if (err != ESP_ERR_NOT_FINISHED) {
+        ESP_LOGE(TAG, "[%s] TLS handshake with %s failed", s->name, s->host);
+        fail(s, NTRIP_FAIL_TRANSPORT);
+    }
+}
+
+/**
+ * TCP is up - start TLS if the caster needs it, else send the request
+ */
+static void transport_connected(ntrip_session_t *s)
+{
+    if (s->use_udp) {
+        ntrip_rtp_start(&s->rtp);
+    }
+    if (!s->use_tls) {
+        send_request(s);
+        return;
+    }
+    if (ntrip_tls_start(&s->tls, s->sock, s->host) != ESP_OK) {
+        fail(s, NTRIP_FAIL_TRANSPORT);
+        return;
+    }
+    set_state(s, NTRIP_STATE_TLS_HANDSHAKE);
+    poll_handshake(s);
+}
+
+/**
+ * Address is known - open a non-blocking socket and start connecting
+ */
+static void start_connect(ntrip_session_t *s, struct in_addr addr)
+{
+    if (s->use_udp) {
+        s->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    } else {
+        s->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    }
+    if (s->sock < 0) {
+        ESP_LOGE(TAG, "[%s] Failed to create socket: errno %d", s->name, errno);
+        fail(s, NTRIP_FAIL_TRANSPORT);
+        return;
+    }
+
+    int flags = fcntl(s->sock, F_GETFL, 0);
+    fcntl(s->sock, F_SETFL, flags | O_NONBLOCK);
+
+    if (!s->use_udp) {
+        // Detect a dead peer in ~11 s instead of the stack default of hours
+        int keepalive = 1;
+        int idle = NTRIP_KEEPALIVE_IDLE_S;
+        int intvl = NTRIP_KEEPALIVE_INTVL_S;
+        int count = NTRIP_KEEPALIVE_COUNT;
+        setsockopt(s->sock, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
+        setsockopt(s->sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+        setsockopt(s->sock, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+        setsockopt(s->sock, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+    }
+
+    struct sockaddr_in server_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s->port),
+        .sin_addr = addr,
+    };
+
+    if (connect(s->sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) == 0) {
+        transport_connected(s);
+    } else if (errno == EINPROGRESS) {
+        set_state(s, NTRIP_STATE_CONNECTING);
+    } else {
+        ESP_LOGE(TAG, "[%s] Socket connect failed: errno %d", s->name, errno);
+        fail(s, NTRIP_FAIL_TRANSPORT);
+    }
+}
+
+/**
+ * Check whether the non-blocking connect has finished
+ */
+static void poll_connecting(ntrip_session_t *s)
+{
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    FD_SET(s->sock, &wfds);
+    struct timeval tv = { 0, 0 };
+
+    if (select(s->sock + 1, NULL, &wfds, NULL, &tv) <= 0) {
+        return;  // Still connecting
+    }
+
+    int so_error = 0;
+    socklen_t optlen = sizeof(so_error);
+    getsockopt(s->sock, SOL_SOCKET, SO_ERROR, &so_error, &optlen);
+    if (so_error != 0) {
+        ESP_LOGE(TAG, "[%s] Socket connect failed: errno %d", s->name, so_error);
+        fail(s, NTRIP_FAIL_TRANSPORT);
+        return;
+    }
+
+    transport_connected(s);
+}
+
+/**
+ * Send the latest position upstream as GGA
+ * Non-blocking: if the socket can't take it now, the next poll retries.
+ */
+static void send_gga(ntrip_session_t *s)
+{
+    char gga[NMEA_GGA_MAX_LEN];
+    int len = nmea_format_gga(gga, sizeof(gga), &s_position);
+    if (len <= 0) {
+        return;
+    }
+
+    int sent = session_send(s, gga, len);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            ESP_LOGW(TAG, "[%s] Failed to send GGA: errno %d", s->name, errno);
+        }
+        return;
+    }
+    s->bytes_sent += sent;
+    s->gga_sent = true;
+    s->last_gga_ms = now_ms();
+}
+
+/**
+ * Parse the status code from "ICY 200 OK", "HTTP/1.1 401 ..." or
+ * "SOURCETABLE 200 OK" (the caster's answer to an unknown mountpoint)
+ */
+static int parse_status(const char *response)
+{
+    if (strncmp(response, "SOURCETABLE", 11) == 0) {
+        return 404;
+    }
+    if (strncmp(response, "ICY ", 4) == 0) {
+        return atoi(response + 4);
+    }
+    if (strncmp(response, "HTTP/", 5) == 0) {
+        const char *sp = strchr(response, ' ');
+        return sp ? atoi(sp + 1) : 0;
+    }
+    return 0;
+}
+
+/**
+ * Collect the caster's response header without blocking
+ */
+static void poll_response(ntrip_session_t *s)
+{
+    int len = session_recv(s, s->response + s->response_len,
+                           sizeof(s->response) - 1 - s->response_len);
     if (len < 0) {
-        ESP_LOGE(TAG, "Failed to receive response: errno %d", errno);
-        close(s_sock);
-        s_sock = -1;
-        return ESP_FAIL;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            ESP_LOGE(TAG, "[%s] Failed to receive response: errno %d", s->name, errno);
+            fail(s, NTRIP_FAIL_TRANSPORT);
+        }
+        return;
+    }
+    if (len == 0) {
+        ESP_LOGE(TAG, "[%s] Caster closed connection before responding", s->name);
+        fail(s, NTRIP_FAIL_TRANSPORT);
+        return;
+    }
+    s->response_len += len;
+    s->response[s->response_len] = '\0';
+
+    // NTRIP v1 casters answer with a bare "ICY 200 OK" line, v2 with full HTTP headers
+    char *header_end = strstr(s->response, "\r\n\r\n");
+    int header_len;
+    if (header_end != NULL) {
+        header_len = (header_end - s->response) + 4;
+    } else if (strncmp(s->response, "ICY 200", 7) == 0 && strstr(s->response, "\r\n") != NULL) {
+        header_len = (strstr(s->response, "\r\n") - s->response) + 2;
+    } else if (s->response_len >= (int)sizeof(s->response) - 1) {
+        ESP_LOGE(TAG, "[%s] NTRIP response header too long", s->name);
+        fail(s, NTRIP_FAIL_REJECTED_OTHER);
+        return;
+    } else {
+        return;  // Need more
+    }
+
+    ESP_LOGI(TAG, "[%s] NTRIP response: %.100s...", s->name, s->response);
+
+    int status = parse_status(s->response);
+    if (status != 200) {
+        ESP_LOGE(TAG, "[%s] NTRIP connection rejected: %.*s", s->name, header_len, s->response);
+        if (status == 401 || status == 403) {
+            fail(s, NTRIP_FAIL_REJECTED_AUTH);
+        } else if (status == 404) {
+            fail(s, NTRIP_FAIL_REJECTED_MOUNT);
+        } else {
+            fail(s, NTRIP_FAIL_REJECTED_OTHER);
+        }
+        return;
     }
-    response[len] = '\0';
 
-    ESP_LOGI(TAG, "NTRIP response: %.100s...", response);
+    // Anything after the header is already RTCM (never the case over RTP,
+    // where RTCM arrives in its own packets)
+    s->rx_len = s->response_len - header_len;
+    s->rx_off = 0;
+    memcpy(s->rx, s->response + header_len, s->rx_len);
+    s->bytes_received += s->rx_len;
+
+    s->response_rtt_ms = (uint32_t)(now_ms() - s->request_sent_ms);
+    ESP_LOGI(TAG, "[%s] NTRIP caster connected - receiving RTCM corrections (%lu ms)",
+             s->name, (unsigned long)s->response_rtt_ms);
+    rtcm_liveness_start(&s->liveness, now_ms());
+    set_state(s, NTRIP_STATE_STREAMING);
+    ntrip_reconnect_on_connected(&s->reconnect, now_ms());
+
+    // First GGA right away so the caster can send the first epoch sooner
+    s->gga_sent = false;
+    if (s->send_gga && s_have_position) {
+        send_gga(s);
+    }
+}
 
-    // Check for success - "ICY 200 OK" or "HTTP/1.1 200 OK"
-    if (strstr(response, "200") != NULL || strstr(response, "ICY") != NULL) {
-        // Skip remaining headers (find \r\n\r\n)
-        char *body_start = strstr(response, "\r\n\r\n");
-        if (body_start) {
-            // Any data after headers is RTCM data - we'll get it on next recv
+static void session_init(ntrip_session_t *s, const char *name, const char *host,
+                         uint16_t port, bool use_tls, bool use_udp, const char *mountpoint,
+                         const char *user, const char *password)
+{
+    memset(s, 0, sizeof(*s));
+    s->name = name;
+    s->host = host;
+    s->port = port;
+    s->use_tls = use_tls;
+    s->use_udp = use_udp;
+    if (use_udp && use_tls) {
+        ESP_LOGW(TAG, "[%s] TLS is not available over RTP/UDP - using plain RTP", name);
+        s->use_tls = false;
+    }
+    strncpy(s->mountpoint, mountpoint, sizeof(s->mountpoint) - 1);
+    s->user = user;
+    s->password = password;
+    s->sock = -1;
+    ntrip_tls_init(&s->tls);
+    ntrip_rtp_init(&s->rtp);
+    ntrip_reconnect_init(&s->reconnect);
+    rtcm_liveness_init(&s->liveness);
+    rtcm3_framer_init(&s->framer);
+    set_state(s, NTRIP_STATE_IDLE);
+}
+
+/**
+ * Correction source: next complete frame from a streaming session
+ */
+static const rtcm3_frame_t *source_peek(void *ctx)
+{
+    ntrip_session_t *s = ctx;
+
+    while (s->state == NTRIP_STATE_STREAMING && !s->frame_pending) {
+        if (s->rx_off >= s->rx_len) {
+            int received = session_recv(s, s->rx, sizeof(s->rx));
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    ESP_LOGE(TAG, "[%s] Failed to receive RTCM data: errno %d", s->name, errno);
+                    fail(s, NTRIP_FAIL_TRANSPORT);
+                }
+                break;  // No data available (non-blocking)
+            }
+            if (received == 0) {
+                // Connection closed by server
+                ESP_LOGW(TAG, "[%s] NTRIP connection closed by server", s->name);
+                fail(s, NTRIP_FAIL_TRANSPORT);
+                break;
+            }
+            if (s->use_udp && ntrip_rtp_take_gap(&s->rtp)) {
+                // Drop the frame that was cut by the lost packet
+                rtcm3_framer_init(&s->framer);
+            }
+            s->rx_len = received;
+            s->rx_off = 0;
+            s->bytes_received += received;
         }
 
-        ESP_LOGI(TAG, "NTRIP caster connected - receiving RTCM corrections");
-        s_connected = true;
-        s_last_data_time = xTaskGetTickCount();
+        s->rx_off += rtcm3_framer_push(&s->framer, s->rx + s->rx_off,
+                                       s->rx_len - s->rx_off,
+                                       &s->frame, &s->frame_pending);
+    }
 
-        // Set non-blocking for data reception
-        struct timeval recv_timeout = {
-            .tv_sec = 0,
-            .tv_usec = 100000  // 100ms timeout for non-blocking reads
-        };
-        setsockopt(s_sock, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
+    return s->frame_pending ? &s->frame : NULL;
+}
 
-        return ESP_OK;
-    } else {
-        ESP_LOGE(TAG, "NTRIP connection rejected: %s", response);
-        close(s_sock);
-        s_sock = -1;
-        return ESP_FAIL;
+static void source_consume(void *ctx)
+{
+    ntrip_session_t *s = ctx;
+    if (s->frame_pending) {
+        s->frame_pending = false;
+        rtcm_liveness_on_frame(&s->liveness, &s->frame, now_ms());
     }
 }
 
-void ntrip_client_disconnect(void)
+static bool source_is_up(void *ctx)
+{
+    return ((ntrip_session_t *)ctx)->state == NTRIP_STATE_STREAMING;
+}
+
+static void source_drop(void *ctx)
+{
+    fail(ctx, NTRIP_FAIL_CORR_AGE);
+}
+
+static void init_source(corr_source_t *src, ntrip_session_t *s)
 {
-    if (s_sock >= 0) {
-        close(s_sock);
-        s_sock = -1;
+    src->name = s->name;
+    src->ctx = s;
+    src->is_up = source_is_up;
+    src->peek = source_peek;
+    src->consume = source_consume;
+    src->drop = source_drop;
+}
+
+void ntrip_client_init(void)
+{
+    s_num_sessions = 0;
+    session_init(&s_sessions[s_num_sessions++], "primary",
+                 NTRIP_HOST, NTRIP_PORT, NTRIP_TLS, NTRIP_UDP, NTRIP_MOUNTPOINT, NTRIP_USER, NTRIP_PASSWORD);
+#if NTRIP_STANDBY_ENABLED
+    session_init(&s_sessions[s_num_sessions++], "standby",
+                 NTRIP_STANDBY_HOST, NTRIP_STANDBY_PORT, NTRIP_STANDBY_TLS, NTRIP_STANDBY_UDP,
+                 NTRIP_STANDBY_MOUNTPOINT,
+                 NTRIP_STANDBY_USER, NTRIP_STANDBY_PASSWORD);
+#endif
+    for (int i = 0; i < s_num_sessions; i++) {
+        init_source(&s_sources[i], &s_sessions[i]);
     }
-    s_connected = false;
-    ESP_LOGI(TAG, "Disconnected from NTRIP caster");
 }
 
-bool ntrip_client_is_connected(void)
+static void session_connect(ntrip_session_t *s)
 {
-    return s_connected;
+    ESP_LOGI(TAG, "[%s] Connecting to NTRIP caster: %s://%s:%d/%s", s->name,
+             s->use_udp ? "rtp" : s->use_tls ? "https" : "http",
+             s->host, s->port, s->mountpoint);
+
+    // Network/VRS mountpoints (nmea=1 in the sourcetable) need our position
+    ntrip_mount_t mount;
+    s->send_gga = NTRIP_SEND_GGA ||
+                  (ntrip_sourcetable_find(s->mountpoint, &mount) && mount.nmea);
+
+    ntrip_reconnect_on_attempt(&s->reconnect, now_ms());
+    set_state(s, NTRIP_STATE_RESOLVING);
 }
 
-int ntrip_client_receive(uint8_t *buffer, size_t max_len)
+esp_err_t ntrip_client_connect(void)
 {
-    if (!s_connected || s_sock < 0) {
-        return -1;
+    for (int i = 0; i < s_num_sessions; i++) {
+        if (s_sessions[i].state == NTRIP_STATE_IDLE) {
+            session_connect(&s_sessions[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+static void session_poll(ntrip_session_t *s, bool network_up)
+{
+    if (s->state == NTRIP_STATE_IDLE) {
+        if (network_up && ntrip_reconnect_should_attempt(&s->reconnect, now_ms())) {
+            session_connect(s);
+        }
+        return;
     }
 
-    int received = recv(s_sock, buffer, max_len, 0);
+    if (s->state == NTRIP_STATE_STREAMING) {
+        if (s->send_gga && s_have_position &&
+            (!s->gga_sent || now_ms() - s->last_gga_ms >= NTRIP_GGA_INTERVAL_MS)) {
+            send_gga(s);
+        }
+        if (s->use_udp && now_ms() - s->rtp.last_tx_ms >= NTRIP_RTP_KEEPALIVE_MS) {
+            ntrip_rtp_send(&s->rtp, s->sock, NTRIP_RTP_PT_DATA, NULL, 0, now_ms());
+        }
+        return;
+    }
 
-    if (received < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // No data available (non-blocking)
-            return 0;
+    if (now_ms() - s->state_since_ms > NTRIP_CONNECT_TIMEOUT_MS) {
+        ESP_LOGE(TAG, "[%s] NTRIP connect timed out (state %d)", s->name, s->state);
+        fail(s, s->state == NTRIP_STATE_RESOLVING ? NTRIP_FAIL_DNS : NTRIP_FAIL_TRANSPORT);
+        return;
+    }
+
+    switch (s->state) {
+        case NTRIP_STATE_RESOLVING: {
+            struct in_addr addr;
+            esp_err_t err = dns_resolver_lookup(s->host, &addr, 0);
+            if (err == ESP_OK) {
+                start_connect(s, addr);
+            } else if (err != ESP_ERR_TIMEOUT) {
+                ESP_LOGE(TAG, "[%s] DNS lookup failed for %s: %s",
+                         s->name, s->host, esp_err_to_name(err));
+                fail(s, NTRIP_FAIL_DNS);
+            }
+            break;
         }
-        ESP_LOGE(TAG, "Failed to receive RTCM data: errno %d", errno);
-        s_connected = false;
-        close(s_sock);
-        s_sock = -1;
-        return -1;
+        case NTRIP_STATE_CONNECTING:
+            poll_connecting(s);
+            break;
+        case NTRIP_STATE_TLS_HANDSHAKE:
+            poll_handshake(s);
+            break;
+        case NTRIP_STATE_AWAIT_RESPONSE:
+            if (s->use_udp && s->response_len == 0 &&
+                now_ms() - s->request_sent_ms >= NTRIP_RTP_SETUP_RETRY_MS &&
+                !write_request(s)) {
+                fail(s, NTRIP_FAIL_TRANSPORT);
+                break;
+            }
+            poll_response(s);
+            break;
+        default:
+            break;
     }
+}
 
-    if (received == 0) {
-        // Connection closed by server
-        ESP_LOGW(TAG, "NTRIP connection closed by server");
-        s_connected = false;
-        close(s_sock);
-        s_sock = -1;
-        return -1;
+void ntrip_client_poll(bool network_up)
+{
+    for (int i = 0; i < s_num_sessions; i++) {
+        session_poll(&s_sessions[i], network_up);
+    }
+}
+
+static void session_disconnect(ntrip_session_t *s)
+{
+    bool was_streaming = (s->state == NTRIP_STATE_STREAMING);
+    close_socket(s);
+    set_state(s, NTRIP_STATE_IDLE);
+    ntrip_reconnect_on_closed(&s->reconnect);
+    if (was_streaming) {
+        ESP_LOGI(TAG, "[%s] Disconnected from NTRIP caster", s->name);
+    }
+}
+
+void ntrip_client_disconnect(void)
+{
+    for (int i = 0; i < s_num_sessions; i++) {
+        session_disconnect(&s_sessions[i]);
     }
+}
 
-    s_bytes_received += received;
-    s_last_data_time = xTaskGetTickCount();
-    return received;
+bool ntrip_client_is_connected(void)
+{
+    for (int i = 0; i < s_num_sessions; i++) {
+        if (s_sessions[i].state == NTRIP_STATE_STREAMING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const corr_source_t *ntrip_client_source(int session)
+{
+    if (session < 0 || session >= s_num_sessions) {
+        return NULL;
+    }
+    return &s_sources[session];
 }
 
 uint32_t ntrip_client_get_bytes_received(void)
 {
-    return s_bytes_received;
+    uint32_t total = 0;
+    for (int i = 0; i < s_num_sessions; i++) {
+        total += s_sessions[i].bytes_received;
+    }
+    return total;
 }
 
-bool ntrip_client_is_stale(void)
+static bool session_is_degraded(ntrip_session_t *s)
 {
-    if (!s_connected) return false;
+    if (s->state != NTRIP_STATE_STREAMING) return false;
+
+    return rtcm_liveness_check(&s->liveness, now_ms());
+}
 
-    TickType_t elapsed = xTaskGetTickCount() - s_last_data_time;
-    return elapsed > pdMS_TO_TICKS(NTRIP_STALE_TIMEOUT_MS);
+bool ntrip_client_is_stale(void)
+{
+    // Stale only if no streaming session is delivering epochs
+    bool any_streaming = false;
+    for (int i = 0; i < s_num_sessions; i++) {
+        if (s_sessions[i].state == NTRIP_STATE_STREAMING) {
+            any_streaming = true;
+            if (!session_is_degraded(&s_sessions[i])) {
+                return false;
+            }
+        }
+    }
+    return any_streaming;
 }
 
 void ntrip_client_check_stale(void)
 {
-    if (ntrip_client_is_stale()) {
-        ESP_LOGW(TAG, "NTRIP data stale (>%d sec) - forcing reconnect",
-                 NTRIP_STALE_TIMEOUT_MS / 1000);
-        ntrip_client_disconnect();
+    for (int i = 0; i < s_num_sessions; i++) {
+        ntrip_session_t *s = &s_sessions[i];
+        if (session_is_degraded(s)) {
+            ESP_LOGW(TAG, "[%s] RTCM epochs overdue (cadence %lu ms, detected %lu ms late) - forcing reconnect",
+                     s->name, (unsigned long)rtcm_liveness_interval_ms(&s->liveness),
+                     (unsigned long)s->liveness.stats.last_detection_ms);
+            fail(s, NTRIP_FAIL_STALE);
+        }
+    }
+}
+
+void ntrip_client_set_position(const zed_position_t *pos)
+{
+    if (pos != NULL && pos->valid) {
+        s_position = *pos;
+        s_have_position = true;
+    }
+}
+
+uint32_t ntrip_client_get_bytes_sent(void)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < s_num_sessions; i++) {
+        total += s_sessions[i].bytes_sent;
+    }
+    return total;
+}
+
+int ntrip_client_session_count(void)
+{
+    return s_num_sessions;
+}
+
+const char* ntrip_client_session_name(int session)
+{
+    if (session < 0 || session >= s_num_sessions) {
+        return "none";
+    }
+    return s_sessions[session].name;
+}
+
+bool ntrip_client_session_is_connected(int session)
+{
+    if (session < 0 || session >= s_num_sessions) {
+        return false;
+    }
+    return s_sessions[session].state == NTRIP_STATE_STREAMING;
+}
+
+const char* ntrip_client_get_mountpoint(int session)
+{
+    if (session < 0 || session >= s_num_sessions) {
+        return "";
+    }
+    return s_sessions[session].mountpoint;
+}
+
+esp_err_t ntrip_client_set_mountpoint(int session, const char *mountpoint)
+{
+    if (session < 0 || session >= s_num_sessions || mountpoint == NULL ||
+        strlen(mountpoint) >= NTRIP_MOUNTPOINT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ntrip_session_t *s = &s_sessions[session];
+    if (strcmp(s->mountpoint, mountpoint) == 0) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "[%s] Switching mountpoint %s -> %s", s->name, s->mountpoint, mountpoint);
+    session_disconnect(s);
+    strncpy(s->mountpoint, mountpoint, sizeof(s->mountpoint) - 1);
+    s->mountpoint[sizeof(s->mountpoint) - 1] = '\0';
+    s->response_rtt_ms = 0;
+    session_connect(s);
+    return ESP_OK;
+}
+
+bool ntrip_client_get_reconnect_stats(int session, ntrip_reconnect_stats_t *stats)
+{
+    if (session < 0 || session >= s_num_sessions || stats == NULL) {
+        return false;
     }
+    *stats = s_sessions[session].reconnect.stats;
+    return true;
 }
+
+bool ntrip_client_get_liveness_stats(int session, rtcm_liveness_stats_t *stats)
+{
+    if (session < 0 || session >= s_num_sessions || stats == NULL) {
+        return false;
+    }
+    *stats = s_sessions[session].liveness.stats;
+    return true;
+}
+
+bool ntrip_client_get_tls_stats(int session, ntrip_tls_stats_t *stats)
+{
+    if (session < 0 || session >= s_num_sessions || stats == NULL ||
+        !s_sessions[session].use_tls) {
+        return false;
+    }
+    *stats = s_sessions[session].tls.stats;
+    return true;
+}
+
+bool ntrip_client_get_rtp_stats(int session, ntrip_rtp_stats_t *stats)
+{
+    if (session < 0 || session >= s_num_sessions || stats == NULL ||
+        !s_sessions[session].use_udp) {
+        return false;
+    }
+    *stats = s_sessions[session].rtp.stats;
+    return true;
+}
+
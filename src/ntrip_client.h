@@ -1,6 +1,10 @@
 /**
  * NTRIP Client (Rover Mode)
  * Connects to NTRIP caster to receive RTCM corrections
+ *
+ * Supports a primary and an optional hot-standby caster; both stream at
+ * once and each is a correction source for corr_arbiter, which decides
+ * what reaches the receiver.
  */
 
 #ifndef NTRIP_CLIENT_H
@@ -10,12 +14,32 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "ntrip_reconnect.h"
+#include "rtcm_liveness.h"
+#include "corr_source.h"
+#include "ntrip_tls.h"
+#include "ntrip_rtp.h"
+#include "zed_rover.h"
+
+#define NTRIP_MOUNTPOINT_MAX 32
 
 /**
- * Connect to NTRIP caster as a client (rover)
+ * Initialize client state (call once before polling)
+ */
+void ntrip_client_init(void);
+
+/**
+ * Start a connection attempt now, ignoring the reconnect delay
+ * Non-blocking: progress is made by ntrip_client_poll()
  */
 esp_err_t ntrip_client_connect(void);
 
+/**
+ * Advance the connection state machine (DNS, connect, response)
+ * Never blocks; call every loop iteration
+ */
+void ntrip_client_poll(bool network_up);
+
 /**
  * Disconnect from NTRIP caster
  */
@@ -27,24 +51,83 @@ void ntrip_client_disconnect(void);
 bool ntrip_client_is_connected(void);
 
 /**
- * Receive RTCM data from NTRIP caster
- * Returns number of bytes received, 0 if no data, or -1 on error
+ * Get a session as a correction source (for corr_arbiter)
+ * @return NULL if the session doesn't exist
  */
-int ntrip_client_receive(uint8_t *buffer, size_t max_len);
+const corr_source_t *ntrip_client_source(int session);
 
 /**
- * Get total bytes received
+ * Get total bytes received (all sessions)
  */
 uint32_t ntrip_client_get_bytes_received(void);
 
 /**
- * Check if connection is stale (connected but no data for >15 sec)
+ * Get total bytes sent upstream (requests and GGA, all sessions)
+ */
+uint32_t ntrip_client_get_bytes_sent(void);
+
+/**
+ * Update the rover position sent upstream as GGA
+ */
+void ntrip_client_set_position(const zed_position_t *pos);
+
+/**
+ * Check if connection is stale (connected, but no session is delivering
+ * RTCM epochs at its learned cadence)
  */
 bool ntrip_client_is_stale(void);
 
 /**
- * Force reconnect if connection is stale
+ * Force reconnect of any session that has missed 2.5 epochs
  */
 void ntrip_client_check_stale(void);
 
+/**
+ * Get number of configured caster sessions (1, or 2 with a standby)
+ */
+int ntrip_client_session_count(void);
+
+/**
+ * Get session name ("primary", "standby")
+ */
+const char* ntrip_client_session_name(int session);
+
+/**
+ * Check if one session is connected and streaming
+ */
+bool ntrip_client_session_is_connected(int session);
+
+/**
+ * Get the mountpoint a session uses
+ */
+const char* ntrip_client_get_mountpoint(int session);
+
+/**
+ * Move a session to another mountpoint on the same caster
+ * Drops the current stream and reconnects immediately.
+ */
+esp_err_t ntrip_client_set_mountpoint(int session, const char *mountpoint);
+
+/**
+ * Get reconnect counters and outage histograms for one session
+ */
+bool ntrip_client_get_reconnect_stats(int session, ntrip_reconnect_stats_t *stats);
+
+/**
+ * Get epoch cadence and degraded-detection latency for one session
+ */
+bool ntrip_client_get_liveness_stats(int session, rtcm_liveness_stats_t *stats);
+
+/**
+ * Get full/resumed TLS handshake counts and timings for one session
+ * @return false if the session does not use TLS
+ */
+bool ntrip_client_get_tls_stats(int session, ntrip_tls_stats_t *stats);
+
+/**
+ * Get RTP packet, loss and reordering counters for one session
+ * @return false if the session does not use RTP/UDP
+ */
+bool ntrip_client_get_rtp_stats(int session, ntrip_rtp_stats_t *stats);
+
 #endif // NTRIP_CLIENT_H
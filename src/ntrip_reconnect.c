@@ -0,0 +1,176 @@
+/**
+ * NTRIP Reconnect Policy
+ *
+ *   - After a long healthy session, the first failure retries immediately:
+ *     most drops are a one-off (WiFi roam, caster restart) and every second
+ *     without corrections costs us RTK fixed.
+ *   - Transport failures then back off exponentially with jitter, so a
+ *     fleet of rovers doesn't reconnect in lockstep after a caster outage.
+ *     Only a session that streamed for NTRIP_STABLE_SESSION_MS resets the
+ *     backoff: a caster that accepts the request and then hangs up at once
+ *     must not be hammered at the minimum interval.
+ *   - Caster rejections (bad credentials, unknown mountpoint) won't fix
+ *     themselves, so they wait a long fixed interval.
+ */
+
+#include <string.h>
+#include "esp_random.h"
+#include "esp_log.h"
+
+#include "ntrip_reconnect.h"
+#include "config.h"
+
+static const char *TAG = "ntrip_reconnect";
+
+#ifndef NTRIP_BACKOFF_MIN_MS
+#define NTRIP_BACKOFF_MIN_MS 1000
+#endif
+#ifndef NTRIP_BACKOFF_MAX_MS
+#define NTRIP_BACKOFF_MAX_MS 60000
+#endif
+#ifndef NTRIP_REJECT_RETRY_MS
+#define NTRIP_REJECT_RETRY_MS (5 * 60 * 1000)
+#endif
+#ifndef NTRIP_HEALTHY_SESSION_MS
+#define NTRIP_HEALTHY_SESSION_MS 60000
+#endif
+#ifndef NTRIP_STABLE_SESSION_MS
+#define NTRIP_STABLE_SESSION_MS 5000    // A few epochs
+#endif
+
+const uint32_t ntrip_outage_bucket_ms[NTRIP_OUTAGE_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 30000, 60000, 300000
+};
+
+const uint32_t ntrip_attempt_bucket[NTRIP_ATTEMPT_BUCKETS - 1] = {
+    1, 2, 3, 5, 10
+};
+
+static void hist_add(uint32_t *hist, const uint32_t *bounds, int buckets, uint32_t value)
+{
+    int i = 0;
+    while (i < buckets - 1 && value > bounds[i]) {
+        i++;
+    }
+    hist[i]++;
+}
+
+void ntrip_reconnect_init(ntrip_reconnect_t *rc)
+{
+    memset(rc, 0, sizeof(*rc));
+}
+
+bool ntrip_reconnect_should_attempt(const ntrip_reconnect_t *rc, int64_t now_ms)
+{
+    return now_ms >= rc->next_attempt_ms;
+}
+
+void ntrip_reconnect_on_attempt(ntrip_reconnect_t *rc, int64_t now_ms)
+{
+    if (!rc->in_outage) {
+        // First attempt after boot counts as an outage too
+        rc->in_outage = true;
+        rc->outage_start_ms = now_ms;
+        rc->outage_attempts = 0;
+    }
+    rc->outage_attempts++;
+    rc->stats.attempts++;
+}
+
+void ntrip_reconnect_on_connected(ntrip_reconnect_t *rc, int64_t now_ms)
+{
+    rc->stats.successes++;
+    rc->streaming = true;
+    rc->session_start_ms = now_ms;
+    rc->next_attempt_ms = now_ms;
+
+    if (rc->in_outage) {
+        uint32_t duration = (uint32_t)(now_ms - rc->outage_start_ms);
+        rc->stats.outages++;
+        rc->stats.last_outage_ms = duration;
+        rc->stats.total_outage_ms += duration;
+        if (duration > rc->stats.max_outage_ms) {
+            rc->stats.max_outage_ms = duration;
+        }
+        hist_add(rc->stats.outage_hist, ntrip_outage_bucket_ms, NTRIP_OUTAGE_BUCKETS, duration);
+        hist_add(rc->stats.attempt_hist, ntrip_attempt_bucket, NTRIP_ATTEMPT_BUCKETS,
+                 rc->outage_attempts);
+        ESP_LOGI(TAG, "Corrections restored after %lu ms outage (%lu attempts)",
+                 (unsigned long)duration, (unsigned long)rc->outage_attempts);
+        rc->in_outage = false;
+    }
+}
+
+void ntrip_reconnect_on_closed(ntrip_reconnect_t *rc)
+{
+    rc->streaming = false;
+    rc->fast_retry_armed = false;
+}
+
+uint32_t ntrip_reconnect_on_failure(ntrip_reconnect_t *rc, ntrip_fail_reason_t reason,
+                                    int64_t now_ms)
+{
+    bool was_streaming = rc->streaming;
+    bool rejected = (reason == NTRIP_FAIL_REJECTED_AUTH ||
+                     reason == NTRIP_FAIL_REJECTED_MOUNT ||
+                     reason == NTRIP_FAIL_REJECTED_OTHER);
+
+    if (was_streaming) {
+        // A live session just ended - this starts a new outage
+        int64_t session_ms = now_ms - rc->session_start_ms;
+        rc->stats.drops++;
+        rc->fast_retry_armed = session_ms >= NTRIP_HEALTHY_SESSION_MS;
+        if (session_ms >= NTRIP_STABLE_SESSION_MS) {
+            rc->failures = 0;
+        }
+        rc->streaming = false;
+        rc->in_outage = true;
+        rc->outage_start_ms = now_ms;
+        rc->outage_attempts = 0;
+    }
+
+    uint32_t delay_ms;
+    if (rejected) {
+        rc->stats.rejections++;
+        rc->fast_retry_armed = false;
+        delay_ms = NTRIP_REJECT_RETRY_MS;
+    } else {
+        if (!was_streaming) {
+            rc->stats.transport_failures++;
+        }
+        if (rc->fast_retry_armed) {
+            rc->fast_retry_armed = false;
+            rc->stats.fast_retries++;
+            delay_ms = 0;
+        } else {
+            // Exponential backoff with "equal jitter": half fixed, half random
+            uint32_t shift = rc->failures < 16 ? rc->failures : 16;
+            uint64_t ceiling = (uint64_t)NTRIP_BACKOFF_MIN_MS << shift;
+            if (ceiling > NTRIP_BACKOFF_MAX_MS) {
+                ceiling = NTRIP_BACKOFF_MAX_MS;
+            }
+            uint32_t half = (uint32_t)ceiling / 2;
+            delay_ms = half + (half > 0 ? esp_random() % (half + 1) : 0);
+            rc->failures++;
+        }
+    }
+
+    rc->next_attempt_ms = now_ms + delay_ms;
+    ESP_LOGW(TAG, "NTRIP %s - next attempt in %lu ms",
+             ntrip_reconnect_reason_str(reason), (unsigned long)delay_ms);
+    return delay_ms;
+}
+
+const char* ntrip_reconnect_reason_str(ntrip_fail_reason_t reason)
+{
+    switch (reason) {
+        case NTRIP_FAIL_DNS: return "DNS failure";
+        case NTRIP_FAIL_TRANSPORT: return "transport failure";
+        case NTRIP_FAIL_STALE: return "stale stream";
+        case NTRIP_FAIL_CORR_AGE: return "receiver correction age too old";
+        case NTRIP_FAIL_REJECTED_AUTH: return "rejected (unauthorized)";
+        case NTRIP_FAIL_REJECTED_MOUNT: return "rejected (unknown mountpoint)";
+        case NTRIP_FAIL_REJECTED_OTHER: return "rejected";
+        default: return "unknown";
+    }
+}
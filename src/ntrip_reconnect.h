@@ -0,0 +1,104 @@
+/**
+ * NTRIP Reconnect Policy
+ *
+ * Decides when the next connection attempt may start, and keeps
+ * per-outage statistics (attempts and RTK correction downtime).
+ */
+
+#ifndef NTRIP_RECONNECT_H
+#define NTRIP_RECONNECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Why a connection attempt or session ended
+ */
+typedef enum {
+    NTRIP_FAIL_DNS = 0,         // Hostname did not resolve
+    NTRIP_FAIL_TRANSPORT,       // Connect/send/recv error, timeout, peer closed
+    NTRIP_FAIL_STALE,           // Connected but corrections stopped arriving
+    NTRIP_FAIL_CORR_AGE,        // Streaming, but the receiver's correction age is too old
+    NTRIP_FAIL_REJECTED_AUTH,   // Caster said 401/403 - bad credentials
+    NTRIP_FAIL_REJECTED_MOUNT,  // Caster said 404 or sent its sourcetable
+    NTRIP_FAIL_REJECTED_OTHER,  // Any other non-200 reply
+} ntrip_fail_reason_t;
+
+// Histogram layout: upper bounds per bucket, last bucket is open-ended
+#define NTRIP_OUTAGE_BUCKETS   8
+#define NTRIP_ATTEMPT_BUCKETS  6
+
+extern const uint32_t ntrip_outage_bucket_ms[NTRIP_OUTAGE_BUCKETS - 1];
+extern const uint32_t ntrip_attempt_bucket[NTRIP_ATTEMPT_BUCKETS - 1];
+
+/**
+ * Reconnect statistics
+ */
+typedef struct {
+    uint32_t attempts;              // Connection attempts started
+    uint32_t successes;             // Attempts that reached streaming
+    uint32_t transport_failures;    // DNS/transport/stale failures
+    uint32_t rejections;            // Caster refused the request
+    uint32_t drops;                 // Live sessions that ended
+    uint32_t fast_retries;          // Immediate retries after a healthy session
+    uint32_t outages;               // Completed outages
+    uint32_t last_outage_ms;
+    uint32_t max_outage_ms;
+    uint64_t total_outage_ms;       // Sum over completed outages
+    uint32_t outage_hist[NTRIP_OUTAGE_BUCKETS];    // Outage duration
+    uint32_t attempt_hist[NTRIP_ATTEMPT_BUCKETS];  // Attempts per outage
+} ntrip_reconnect_stats_t;
+
+/**
+ * Reconnect state for one caster session
+ */
+typedef struct {
+    uint32_t failures;          // Failed attempts and short sessions since a stable one
+    uint32_t outage_attempts;   // Attempts in the current outage
+    bool in_outage;
+    bool streaming;             // Between on_connected() and the next failure
+    bool fast_retry_armed;      // Last session was long and healthy
+    int64_t outage_start_ms;
+    int64_t session_start_ms;
+    int64_t next_attempt_ms;
+    ntrip_reconnect_stats_t stats;
+} ntrip_reconnect_t;
+
+/**
+ * Reset state; the first attempt is allowed immediately
+ */
+void ntrip_reconnect_init(ntrip_reconnect_t *rc);
+
+/**
+ * True once the backoff delay has elapsed
+ */
+bool ntrip_reconnect_should_attempt(const ntrip_reconnect_t *rc, int64_t now_ms);
+
+/**
+ * Record that a connection attempt is starting
+ */
+void ntrip_reconnect_on_attempt(ntrip_reconnect_t *rc, int64_t now_ms);
+
+/**
+ * Record a successful connection (ends the current outage)
+ */
+void ntrip_reconnect_on_connected(ntrip_reconnect_t *rc, int64_t now_ms);
+
+/**
+ * Record an intentional disconnect (no backoff, no outage)
+ */
+void ntrip_reconnect_on_closed(ntrip_reconnect_t *rc);
+
+/**
+ * Record a failed attempt or a dropped session and schedule the next try
+ * Returns the delay before the next attempt in ms
+ */
+uint32_t ntrip_reconnect_on_failure(ntrip_reconnect_t *rc, ntrip_fail_reason_t reason,
+                                    int64_t now_ms);
+
+/**
+ * Get reason as string
+ */
+const char* ntrip_reconnect_reason_str(ntrip_fail_reason_t reason);
+
+#endif // NTRIP_RECONNECT_H
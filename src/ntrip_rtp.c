@@ -0,0 +1,154 @@
+/**
+ * NTRIP RTP - NTRIP 2.0 RTP-over-UDP packet layer
+ *
+ * The header and payload are sent and received with scatter/gather I/O,
+ * so RTCM lands directly in the session's receive buffer.
+ *
+ * Loss is never repaired: RTCM is only useful fresh, so a missing packet
+ * costs the frame it was part of and nothing more. That is the point of
+ * the transport - after WiFi loss TCP holds back every later epoch until
+ * the retransmission arrives.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include "esp_random.h"
+
+#include "ntrip_rtp.h"
+
+#define RTP_VERSION_BITS 0x80       // V=2, no padding, no extension, no CSRC
+
+void ntrip_rtp_init(ntrip_rtp_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+void ntrip_rtp_start(ntrip_rtp_t *r)
+{
+    // Our SSRC until the caster's response assigns the session's
+    r->ssrc = esp_random();
+    r->ssrc_assigned = false;
+    r->tx_seq = (uint16_t)esp_random();
+    r->have_rx_seq = false;
+    r->gap = false;
+    r->last_tx_ms = 0;
+}
+
+int ntrip_rtp_send(ntrip_rtp_t *r, int sock, uint8_t payload_type,
+                   const void *data, size_t len, int64_t now_ms)
+{
+    uint8_t hdr[NTRIP_RTP_HEADER_LEN];
+    uint32_t ts = (uint32_t)now_ms;
+
+    hdr[0] = RTP_VERSION_BITS;
+    hdr[1] = payload_type & 0x7F;
+    hdr[2] = r->tx_seq >> 8;
+    hdr[3] = r->tx_seq & 0xFF;
+    hdr[4] = ts >> 24;
+    hdr[5] = ts >> 16;
+    hdr[6] = ts >> 8;
+    hdr[7] = ts;
+    hdr[8] = r->ssrc >> 24;
+    hdr[9] = r->ssrc >> 16;
+    hdr[10] = r->ssrc >> 8;
+    hdr[11] = r->ssrc;
+
+    struct iovec iov[2] = {
+        { .iov_base = hdr, .iov_len = sizeof(hdr) },
+        { .iov_base = (void *)data, .iov_len = len },
+    };
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = len > 0 ? 2 : 1,
+    };
+
+    int sent = sendmsg(sock, &msg, 0);
+    if (sent < 0) {
+        return -1;
+    }
+    r->tx_seq++;
+    r->last_tx_ms = now_ms;
+    r->stats.packets_tx++;
+    if (len == 0 && payload_type == NTRIP_RTP_PT_DATA) {
+        r->stats.keepalives++;
+    }
+    return sent - NTRIP_RTP_HEADER_LEN;
+}
+
+int ntrip_rtp_recv(ntrip_rtp_t *r, int sock, void *data, size_t max_len)
+{
+    for (;;) {
+        uint8_t hdr[NTRIP_RTP_HEADER_LEN];
+        struct iovec iov[2] = {
+            { .iov_base = hdr, .iov_len = sizeof(hdr) },
+            { .iov_base = data, .iov_len = max_len },
+        };
+        struct msghdr msg = {
+            .msg_iov = iov,
+            .msg_iovlen = 2,
+        };
+
+        int n = recvmsg(sock, &msg, 0);
+        if (n < 0) {
+            return -1;
+        }
+        if (n < NTRIP_RTP_HEADER_LEN || (hdr[0] & 0xC0) != RTP_VERSION_BITS ||
+            (msg.msg_flags & MSG_TRUNC)) {
+            r->stats.foreign++;
+            continue;
+        }
+
+        uint8_t pt = hdr[1] & 0x7F;
+        uint16_t seq = ((uint16_t)hdr[2] << 8) | hdr[3];
+        uint32_t ssrc = ((uint32_t)hdr[8] << 24) | ((uint32_t)hdr[9] << 16) |
+                        ((uint32_t)hdr[10] << 8) | hdr[11];
+
+        if (pt == NTRIP_RTP_PT_HTTP && !r->ssrc_assigned) {
+            r->ssrc = ssrc;
+            r->ssrc_assigned = true;
+        } else if (ssrc != r->ssrc) {
+            r->stats.foreign++;
+            continue;
+        }
+
+        if (pt == NTRIP_RTP_PT_CLOSE) {
+            return 0;
+        }
+        if (pt != NTRIP_RTP_PT_DATA && pt != NTRIP_RTP_PT_HTTP) {
+            r->stats.foreign++;
+            continue;
+        }
+
+        if (r->have_rx_seq) {
+            int16_t diff = (int16_t)(seq - r->rx_seq);
+            if (diff < 0) {
+                r->stats.late++;
+                continue;
+            }
+            if (diff > 0) {
+                r->stats.lost += diff;
+                r->stats.gaps++;
+                r->gap = true;
+            }
+        }
+        r->have_rx_seq = true;
+        r->rx_seq = seq + 1;
+
+        int len = n - NTRIP_RTP_HEADER_LEN;
+        if (len == 0) {
+            continue;  // Keepalive from the caster
+        }
+        if (pt == NTRIP_RTP_PT_DATA) {
+            r->stats.packets_rx++;
+        }
+        return len;
+    }
+}
+
+bool ntrip_rtp_take_gap(ntrip_rtp_t *r)
+{
+    bool gap = r->gap;
+    r->gap = false;
+    return gap;
+}
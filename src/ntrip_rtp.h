@@ -0,0 +1,82 @@
+/**
+ * NTRIP RTP - NTRIP 2.0 RTP-over-UDP packet layer
+ *
+ * Every datagram carries a 12-byte RTP header. The payload type says what
+ * is inside: HTTP request/response during setup, RTCM (or client NMEA)
+ * while streaming, and an end-of-session marker.
+ */
+
+#ifndef NTRIP_RTP_H
+#define NTRIP_RTP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NTRIP_RTP_HEADER_LEN 12
+#define NTRIP_RTP_MAX_PAYLOAD 1460  // Ethernet MTU minus IP, UDP and RTP headers
+
+// Payload types defined by NTRIP 2.0
+#define NTRIP_RTP_PT_DATA  96       // RTCM from caster, NMEA/keepalive from client
+#define NTRIP_RTP_PT_HTTP  97       // HTTP request/response (session setup)
+#define NTRIP_RTP_PT_CLOSE 98       // End of session
+
+/**
+ * Packet statistics
+ */
+typedef struct {
+    uint32_t packets_rx;        // Data packets accepted
+    uint32_t packets_tx;
+    uint32_t lost;              // Sequence numbers never seen
+    uint32_t late;              // Reordered or duplicated packets, dropped
+    uint32_t foreign;           // Wrong SSRC or not RTP
+    uint32_t gaps;              // Loss events (one per jump in sequence)
+    uint32_t keepalives;        // Empty packets sent to hold the session open
+} ntrip_rtp_stats_t;
+
+/**
+ * Session state
+ */
+typedef struct {
+    uint32_t ssrc;              // Session ID, assigned by the caster's response
+    bool ssrc_assigned;
+    uint16_t tx_seq;
+    uint16_t rx_seq;            // Next expected sequence number
+    bool have_rx_seq;
+    bool gap;                   // Packets lost since the last take_gap()
+    int64_t last_tx_ms;
+    ntrip_rtp_stats_t stats;
+} ntrip_rtp_t;
+
+/**
+ * Reset state for a new session (statistics are kept)
+ */
+void ntrip_rtp_start(ntrip_rtp_t *r);
+
+/**
+ * Reset everything including statistics
+ */
+void ntrip_rtp_init(ntrip_rtp_t *r);
+
+/**
+ * Send one packet on a connected UDP socket
+ * @return Payload bytes sent, or -1 with errno set
+ */
+int ntrip_rtp_send(ntrip_rtp_t *r, int sock, uint8_t payload_type,
+                   const void *data, size_t len, int64_t now_ms);
+
+/**
+ * Receive the next in-order HTTP or data packet without blocking
+ * Late, duplicate and foreign packets are skipped; empty packets too.
+ * @return Payload length, 0 if the caster ended the session, or -1 with
+ *         errno set (EAGAIN when nothing is waiting)
+ */
+int ntrip_rtp_recv(ntrip_rtp_t *r, int sock, void *data, size_t max_len);
+
+/**
+ * Check and clear the loss flag
+ * A frame spanning the gap is incomplete, so the caller resets its framer.
+ */
+bool ntrip_rtp_take_gap(ntrip_rtp_t *r);
+
+#endif // NTRIP_RTP_H
@@ -0,0 +1,595 @@
+/**
+ * NTRIP Sourcetable - Nearest mountpoint selection
+ *
+ * The sourcetable is downloaded with an NTRIP v1 request (plain, never
+ * chunked) and parsed line by line as it streams in, so a caster with
+ * hundreds of STR records needs no more than one line of buffer. Only the
+ * NTRIP_SOURCETABLE_MAX RTCM 3 mountpoints closest to the rover are kept.
+ *
+ * Ranking score is baseline distance. When the link budget is tight,
+ * heavier MSM streams are penalised, trading some baseline for fewer
+ * bytes. A configured VRS/network mountpoint (nmea=1) is never switched
+ * away from automatically.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <errno.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "ntrip_sourcetable.h"
+#include "ntrip_client.h"
+#include "dns_resolver.h"
+#include "ntrip_tls.h"
+#include "wifi.h"
+#include "link_budget.h"
+#include "config.h"
+
+static const char *TAG = "sourcetable";
+
+#ifndef NTRIP_AUTO_MOUNTPOINT
+#define NTRIP_AUTO_MOUNTPOINT 0
+#endif
+#ifndef NTRIP_SWITCH_GAIN_M
+#define NTRIP_SWITCH_GAIN_M 5000
+#endif
+#ifndef NTRIP_TLS
+#define NTRIP_TLS 0
+#endif
+#ifndef NTRIP_SOURCETABLE_REFRESH_MS
+#define NTRIP_SOURCETABLE_REFRESH_MS (6 * 60 * 60 * 1000)
+#endif
+
+#define NTRIP_SELECT_INTERVAL_MS   30000            // How often to re-rank
+#define NTRIP_SWITCH_HOLDOFF_MS    (10 * 60 * 1000) // Minimum time between switches
+#define NTRIP_MSM_PENALTY_M        10000.0f         // Per MSM level above 4, on a tight budget
+#define NTRIP_FETCH_RETRY_MS       (5 * 60 * 1000)
+#define NTRIP_FETCH_TIMEOUT_S      10
+#define NTRIP_FETCH_STACK          (NTRIP_TLS ? 8192 : 4096)  // TLS handshake needs the room
+
+#define NVS_NAMESPACE "ntrip_st"
+#define NVS_KEY_TABLE "mounts_v2"
+
+#define EARTH_RADIUS_M 6371000.0f
+
+// Table used for selection, and the one being filled by a fetch
+static ntrip_mount_t s_table[NTRIP_SOURCETABLE_MAX];
+static int s_count = 0;
+static ntrip_mount_t s_fetch_table[NTRIP_SOURCETABLE_MAX];
+static int s_fetch_count = 0;
+
+static SemaphoreHandle_t s_mutex = NULL;
+static ntrip_sourcetable_stats_t s_stats = { .baseline_km = -1.0f };
+
+#if NTRIP_TLS
+// Keeps its own cached session, so hourly refreshes resume too
+static ntrip_tls_t s_tls;
+#endif
+
+// Latest rover position, used to keep the nearest records while parsing
+static float s_ref_lat = 0.0f;
+static float s_ref_lon = 0.0f;
+static bool s_have_ref = false;
+
+// Streaming line parser
+static char s_line[512];
+static size_t s_line_len = 0;
+static bool s_line_overflow = false;
+static bool s_end_seen = false;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * Great-circle distance (haversine), metres
+ */
+static float distance_m(float lat1, float lon1, float lat2, float lon2)
+{
+    const float deg = (float)M_PI / 180.0f;
+    float dlat = (lat2 - lat1) * deg;
+    float dlon = (lon2 - lon1) * deg;
+    float s_dlat = sinf(dlat / 2.0f);
+    float s_dlon = sinf(dlon / 2.0f);
+    float a = s_dlat * s_dlat + cosf(lat1 * deg) * cosf(lat2 * deg) * s_dlon * s_dlon;
+    return 2.0f * EARTH_RADIUS_M * asinf(sqrtf(a));
+}
+
+/**
+ * Highest MSM level (4, 5, 6, 7) listed in the format-details field,
+ * e.g. "1005(10),1074(1),1084(1),1094(1)" -> 4
+ */
+static uint8_t parse_msm_level(const char *details)
+{
+    uint8_t level = 0;
+    const char *p = details;
+    while (*p) {
+        if (*p >= '0' && *p <= '9') {
+            int type = strtol(p, (char **)&p, 10);
+            if (type >= 1071 && type <= 1137 && (type % 10) >= 1 && (type % 10) <= 7) {
+                if (type % 10 > level) {
+                    level = type % 10;
+                }
+            }
+        } else {
+            p++;
+        }
+    }
+    return level;
+}
+
+/**
+ * Keep a parsed record if it is among the nearest seen so far
+ */
+static void add_candidate(const ntrip_mount_t *m)
+{
+    if (s_fetch_count < NTRIP_SOURCETABLE_MAX) {
+        s_fetch_table[s_fetch_count++] = *m;
+        return;
+    }
+    if (!s_have_ref) {
+        return;  // No position yet - first come, first kept
+    }
+
+    int farthest = 0;
+    float farthest_d = 0.0f;
+    for (int i = 0; i < s_fetch_count; i++) {
+        float d = distance_m(s_ref_lat, s_ref_lon,
+                             s_fetch_table[i].latitude, s_fetch_table[i].longitude);
+        if (d > farthest_d) {
+            farthest_d = d;
+            farthest = i;
+        }
+    }
+    if (distance_m(s_ref_lat, s_ref_lon, m->latitude, m->longitude) < farthest_d) {
+        s_fetch_table[farthest] = *m;
+    }
+}
+
+/**
+ * Parse one sourcetable line
+ * STR;mountpoint;identifier;format;format-details;carrier;nav-system;network;
+ *     country;latitude;longitude;nmea;solution;generator;compr;auth;fee;bitrate;misc
+ */
+static void parse_line(char *line)
+{
+    if (strncmp(line, "ENDSOURCETABLE", 14) == 0) {
+        s_end_seen = true;
+        return;
+    }
+    if (strncmp(line, "STR;", 4) != 0) {
+        return;  // Response header, CAS/NET records
+    }
+    s_stats.str_records++;
+
+    char *fields[19] = {0};
+    int n = 0;
+    char *p = line;
+    while (n < 19) {
+        fields[n++] = p;
+        char *sep = strchr(p, ';');
+        if (sep == NULL) break;
+        *sep = '\0';
+        p = sep + 1;
+    }
+    if (n < 12) {
+        return;
+    }
+
+    // Only RTCM 3.x streams are usable by the receiver
+    const char *format = fields[3];
+    if (strncmp(format, "RTCM 3", 6) != 0 && strncmp(format, "RTCM3", 5) != 0) {
+        return;
+    }
+    if (strlen(fields[1]) == 0 || strlen(fields[1]) >= NTRIP_MOUNTPOINT_MAX) {
+        return;
+    }
+
+    ntrip_mount_t m = {0};
+    strncpy(m.mountpoint, fields[1], sizeof(m.mountpoint) - 1);
+    m.msm_level = parse_msm_level(fields[4]);
+    m.latitude = strtof(fields[9], NULL);
+    m.longitude = strtof(fields[10], NULL);
+    m.nmea = (uint8_t)atoi(fields[11]);
+    if (n > 17) {
+        m.bitrate = (uint16_t)atoi(fields[17]);
+    }
+    add_candidate(&m);
+}
+
+/**
+ * Feed raw sourcetable bytes to the line parser
+ */
+static void parser_feed(const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            if (!s_line_overflow) {
+                if (s_line_len > 0 && s_line[s_line_len - 1] == '\r') {
+                    s_line_len--;
+                }
+                s_line[s_line_len] = '\0';
+                parse_line(s_line);
+            }
+            s_line_len = 0;
+            s_line_overflow = false;
+        } else if (s_line_len < sizeof(s_line) - 1) {
+            s_line[s_line_len++] = c;
+        } else {
+            s_line_overflow = true;  // Drop over-long lines entirely
+        }
+    }
+}
+
+/**
+ * Socket I/O for the fetch, over TLS when the caster needs it
+ */
+static int fetch_send(int sock, const char *data, size_t len)
+{
+#if NTRIP_TLS
+    return ntrip_tls_send(&s_tls, data, len);
+#else
+    return send(sock, data, len, 0);
+#endif
+}
+
+static int fetch_recv(int sock, char *data, size_t len)
+{
+#if NTRIP_TLS
+    return ntrip_tls_recv(&s_tls, data, len);
+#else
+    return recv(sock, data, len, 0);
+#endif
+}
+
+static void fetch_close(int sock)
+{
+#if NTRIP_TLS
+    ntrip_tls_close(&s_tls);
+#endif
+    close(sock);
+}
+
+/**
+ * Download and parse the sourcetable (blocking - runs in its own task)
+ */
+static esp_err_t fetch_sourcetable(void)
+{
+    struct in_addr host_addr;
+    if (dns_resolver_lookup(NTRIP_HOST, &host_addr, 5000) != ESP_OK) {
+        ESP_LOGW(TAG, "DNS lookup failed for %s", NTRIP_HOST);
+        return ESP_FAIL;
+    }
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        ESP_LOGW(TAG, "Failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    struct timeval timeout = {
+        .tv_sec = NTRIP_FETCH_TIMEOUT_S,
+        .tv_usec = 0
+    };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in server_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(NTRIP_PORT),
+        .sin_addr = host_addr,
+    };
+
+    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) != 0) {
+        ESP_LOGW(TAG, "Sourcetable connect failed: errno %d", errno);
+        close(sock);
+        return ESP_FAIL;
+    }
+
+#if NTRIP_TLS
+    // Blocking socket: the handshake either finishes or times out here
+    if (ntrip_tls_start(&s_tls, sock, NTRIP_HOST) != ESP_OK ||
+        ntrip_tls_handshake(&s_tls) != ESP_OK) {
+        ESP_LOGW(TAG, "Sourcetable TLS handshake failed");
+        ntrip_tls_close(&s_tls);
+        close(sock);
+        return ESP_FAIL;
+    }
+#endif
+
+    char request[192];
+    int req_len = snprintf(request, sizeof(request),
+        "GET / HTTP/1.0\r\n"
+        "User-Agent: NTRIP TestClient/1.0\r\n"
+        "\r\n");
+
+    if (fetch_send(sock, request, req_len) < 0) {
+        ESP_LOGW(TAG, "Failed to send sourcetable request: errno %d", errno);
+        fetch_close(sock);
+        return ESP_FAIL;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_fetch_count = 0;
+    s_stats.str_records = 0;
+    xSemaphoreGive(s_mutex);
+    s_line_len = 0;
+    s_line_overflow = false;
+    s_end_seen = false;
+
+    char buf[256];
+    while (!s_end_seen) {
+        int len = fetch_recv(sock, buf, sizeof(buf));
+        if (len <= 0) {
+            break;
+        }
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        parser_feed(buf, len);
+        xSemaphoreGive(s_mutex);
+    }
+    fetch_close(sock);
+
+    // A cut-off download would drop whatever bases came after the cut
+    if (!s_end_seen) {
+        ESP_LOGW(TAG, "Sourcetable truncated, keeping the previous one");
+        return ESP_FAIL;
+    }
+    if (s_fetch_count == 0) {
+        ESP_LOGW(TAG, "No RTCM 3 mountpoints in sourcetable");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Sourcetable: %lu STR records, kept %d RTCM 3 mountpoints",
+             (unsigned long)s_stats.str_records, s_fetch_count);
+    return ESP_OK;
+}
+
+/**
+ * Replace the live table with the fetched one
+ */
+static void commit_fetch(void)
+{
+    memcpy(s_table, s_fetch_table, sizeof(ntrip_mount_t) * s_fetch_count);
+    s_count = s_fetch_count;
+    s_stats.candidates = s_count;
+}
+
+static void save_table(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    esp_err_t err = nvs_set_blob(nvs, NVS_KEY_TABLE, s_table, sizeof(ntrip_mount_t) * s_count);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to cache sourcetable: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs);
+}
+
+static void load_table(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    size_t size = sizeof(s_table);
+    if (nvs_get_blob(nvs, NVS_KEY_TABLE, s_table, &size) == ESP_OK) {
+        s_count = size / sizeof(ntrip_mount_t);
+        s_stats.candidates = s_count;
+        ESP_LOGI(TAG, "Loaded %d cached mountpoints", s_count);
+    }
+    nvs_close(nvs);
+}
+
+static void sourcetable_task(void *pvParameters)
+{
+    // Let WiFi and the first NTRIP connection settle
+    vTaskDelay(pdMS_TO_TICKS(15000));
+
+    while (1) {
+        if (!wifi_is_connected()) {
+            vTaskDelay(pdMS_TO_TICKS(30000));
+            continue;
+        }
+
+        if (fetch_sourcetable() == ESP_OK) {
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            commit_fetch();
+            s_stats.fetches++;
+            xSemaphoreGive(s_mutex);
+            save_table();
+            vTaskDelay(pdMS_TO_TICKS(NTRIP_SOURCETABLE_REFRESH_MS));
+        } else {
+            s_stats.fetch_failures++;
+            vTaskDelay(pdMS_TO_TICKS(NTRIP_FETCH_RETRY_MS));
+        }
+    }
+}
+
+esp_err_t ntrip_sourcetable_init(void)
+{
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    load_table();
+#if NTRIP_TLS
+    ntrip_tls_init(&s_tls);
+#endif
+
+    if (xTaskCreate(sourcetable_task, "sourcetable", NTRIP_FETCH_STACK, NULL, 2, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start sourcetable task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static int find_index(const char *mountpoint)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (strcmp(s_table[i].mountpoint, mountpoint) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool ntrip_sourcetable_find(const char *mountpoint, ntrip_mount_t *mount)
+{
+    if (s_mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int idx = find_index(mountpoint);
+    if (idx >= 0 && mount != NULL) {
+        *mount = s_table[idx];
+    }
+    xSemaphoreGive(s_mutex);
+    return idx >= 0;
+}
+
+/**
+ * Track time-to-fixed for the current primary connection
+ */
+static void track_time_to_fix(const zed_position_t *pos, int64_t now)
+{
+    static bool was_connected = false;
+    static int64_t connected_at = 0;
+    static bool ttf_pending = false;
+
+    bool connected = ntrip_client_session_is_connected(0);
+    if (connected && !was_connected) {
+        connected_at = now;
+        ttf_pending = true;
+    }
+    was_connected = connected;
+
+    if (ttf_pending && pos->carr_soln == 2) {
+        uint32_t ttf = (uint32_t)(now - connected_at);
+        ttf_pending = false;
+        if (s_stats.switches > 0 && s_stats.ttf_after_ms == 0) {
+            s_stats.ttf_after_ms = ttf;
+            ESP_LOGI(TAG, "Time-to-fixed on %s: %lu ms (was %lu ms before switch)",
+                     ntrip_client_get_mountpoint(0), (unsigned long)ttf,
+                     (unsigned long)s_stats.ttf_before_ms);
+        } else {
+            s_stats.ttf_before_ms = ttf;  // Becomes "before" at the next switch
+        }
+    }
+}
+
+/**
+ * Ranking score in metres - lower is better
+ */
+static float mount_score(const ntrip_mount_t *m, float dist_m, bool light)
+{
+    float score = dist_m;
+    if (light && m->msm_level > 4) {
+        score += (m->msm_level - 4) * NTRIP_MSM_PENALTY_M;
+    }
+    return score;
+}
+
+void ntrip_sourcetable_update(const zed_position_t *pos)
+{
+    static int64_t last_rank = 0;
+    static int64_t last_switch = 0;
+
+    if (s_mutex == NULL || pos == NULL || !pos->valid) {
+        return;
+    }
+
+    int64_t now = now_ms();
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_ref_lat = pos->lat_e7 * 1e-7f;
+    s_ref_lon = pos->lon_e7 * 1e-7f;
+    s_have_ref = true;
+    track_time_to_fix(pos, now);
+
+    if (now - last_rank < NTRIP_SELECT_INTERVAL_MS || s_count == 0) {
+        xSemaphoreGive(s_mutex);
+        return;
+    }
+    last_rank = now;
+
+    const char *current = ntrip_client_get_mountpoint(0);
+    int cur = find_index(current);
+
+    // Rank physical bases only - VRS/network mounts (nmea=1) have no fixed location
+    bool light = link_budget_prefer_light_corrections();
+    int best = -1;
+    float best_score = 0.0f;
+    float best_dist = 0.0f;
+    for (int i = 0; i < s_count; i++) {
+        if (s_table[i].nmea) {
+            continue;
+        }
+        float d = distance_m(s_ref_lat, s_ref_lon, s_table[i].latitude, s_table[i].longitude);
+        float score = mount_score(&s_table[i], d, light);
+        if (best < 0 || score < best_score) {
+            best = i;
+            best_score = score;
+            best_dist = d;
+        }
+    }
+
+    float cur_dist = -1.0f;
+    float cur_score = 0.0f;
+    if (cur >= 0 && !s_table[cur].nmea) {
+        cur_dist = distance_m(s_ref_lat, s_ref_lon, s_table[cur].latitude, s_table[cur].longitude);
+        cur_score = mount_score(&s_table[cur], cur_dist, light);
+    }
+    s_stats.baseline_km = cur_dist >= 0.0f ? cur_dist / 1000.0f : -1.0f;
+
+    char target[NTRIP_MOUNTPOINT_MAX] = {0};
+#if NTRIP_AUTO_MOUNTPOINT
+    // A mountpoint missing from the (nearest-N) table is treated as far away;
+    // a VRS one was chosen on purpose and already follows the rover
+    bool worth_it = best >= 0 && best != cur &&
+                    (cur < 0 || (!s_table[cur].nmea &&
+                                 cur_score - best_score >= NTRIP_SWITCH_GAIN_M));
+    if (worth_it && (last_switch == 0 || now - last_switch >= NTRIP_SWITCH_HOLDOFF_MS)) {
+        ESP_LOGI(TAG, "Better base %s (MSM%d) at %.1f km (current %s at %.1f km)",
+                 s_table[best].mountpoint, s_table[best].msm_level, best_dist / 1000.0f,
+                 current, cur_dist / 1000.0f);
+        strncpy(target, s_table[best].mountpoint, sizeof(target) - 1);
+        s_stats.switches++;
+        s_stats.ttf_after_ms = 0;
+        last_switch = now;
+    }
+#else
+    (void)best_dist;
+    (void)cur_score;
+    (void)last_switch;
+#endif
+    xSemaphoreGive(s_mutex);
+
+    if (target[0] != '\0') {
+        ntrip_client_set_mountpoint(0, target);
+    }
+}
+
+void ntrip_sourcetable_get_stats(ntrip_sourcetable_stats_t *stats)
+{
+    if (stats == NULL || s_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_mutex);
+}
@@ -0,0 +1,69 @@
+/**
+ * NTRIP Sourcetable - Nearest mountpoint selection
+ *
+ * Fetches the caster's sourcetable in the background, keeps the closest
+ * RTCM 3 mountpoints (cached in NVS so selection works before the first
+ * fetch), and moves the primary session to a closer base station once the
+ * baseline gain is worth a reconnect.
+ */
+
+#ifndef NTRIP_SOURCETABLE_H
+#define NTRIP_SOURCETABLE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "zed_rover.h"
+#include "ntrip_client.h"
+
+#define NTRIP_SOURCETABLE_MAX 32
+
+/**
+ * One STR record, reduced to what selection needs
+ */
+typedef struct {
+    char mountpoint[NTRIP_MOUNTPOINT_MAX];
+    float latitude;         // degrees
+    float longitude;        // degrees
+    uint16_t bitrate;       // bits/s advertised by the caster, 0 if unknown
+    uint8_t msm_level;      // Highest MSM type advertised (4, 5, 7), 0 if none
+    uint8_t nmea;           // Caster expects GGA from the client (VRS/network)
+} ntrip_mount_t;
+
+/**
+ * Selection statistics
+ */
+typedef struct {
+    uint32_t fetches;           // Successful sourcetable downloads
+    uint32_t fetch_failures;
+    uint32_t str_records;       // STR lines seen in the last fetch
+    uint32_t candidates;        // Mountpoints kept
+    uint32_t switches;          // Automatic mountpoint changes
+    uint32_t ttf_before_ms;     // Time-to-fixed on the mountpoint we left
+    uint32_t ttf_after_ms;      // Time-to-fixed after the last switch, 0 if pending
+    float baseline_km;          // Distance to the current mountpoint, <0 if unknown
+} ntrip_sourcetable_stats_t;
+
+/**
+ * Load the cached table from NVS and start the fetch task
+ */
+esp_err_t ntrip_sourcetable_init(void);
+
+/**
+ * Feed the latest position; re-ranks mountpoints and switches if worthwhile
+ * Cheap - ranking runs at most every NTRIP_SELECT_INTERVAL_MS
+ */
+void ntrip_sourcetable_update(const zed_position_t *pos);
+
+/**
+ * Look up a mountpoint in the cached table
+ * @return true and fills *mount if known
+ */
+bool ntrip_sourcetable_find(const char *mountpoint, ntrip_mount_t *mount);
+
+/**
+ * Get selection statistics
+ */
+void ntrip_sourcetable_get_stats(ntrip_sourcetable_stats_t *stats);
+
+#endif // NTRIP_SOURCETABLE_H
@@ -0,0 +1,287 @@
+/**
+ * NTRIP TLS - Non-blocking mbedTLS transport for a caster session
+ *
+ * The handshake is stepped from the NTRIP poll loop like every other
+ * connection state, so the rover loop never waits on the network.
+ *
+ * Resumption: after each successful handshake the session (session ID, and
+ * ticket if the caster issues one) is exported and offered on the next
+ * connect. A resumed handshake goes straight from ServerHello to
+ * ChangeCipherSpec; seeing the server's Certificate state means the caster
+ * declined and we paid for a full handshake. That distinction is what the
+ * full/resumed timings are split on.
+ *
+ * TLS is capped at 1.2: 1.3 tickets arrive after the handshake and its
+ * PSK resumption is not what NTRIP casters deploy today.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+
+#include "ntrip_tls.h"
+#include "config.h"
+
+static const char *TAG = "ntrip_tls";
+
+#ifndef NTRIP_TLS_VERIFY
+#define NTRIP_TLS_VERIFY 1  // Verify the caster certificate against the CA bundle
+#endif
+
+// Shared by all sessions
+static mbedtls_entropy_context s_entropy;
+static mbedtls_ctr_drbg_context s_ctr_drbg;
+static bool s_rng_ready = false;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static esp_err_t rng_init(void)
+{
+    if (s_rng_ready) {
+        return ESP_OK;
+    }
+    mbedtls_entropy_init(&s_entropy);
+    mbedtls_ctr_drbg_init(&s_ctr_drbg);
+    int ret = mbedtls_ctr_drbg_seed(&s_ctr_drbg, mbedtls_entropy_func, &s_entropy,
+                                    (const unsigned char *)TAG, strlen(TAG));
+    if (ret != 0) {
+        ESP_LOGE(TAG, "RNG seed failed: -0x%04x", -ret);
+        return ESP_FAIL;
+    }
+    s_rng_ready = true;
+    return ESP_OK;
+}
+
+/**
+ * BIO callbacks - map non-blocking socket results to mbedTLS codes
+ */
+static int bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    ntrip_tls_t *t = ctx;
+    int ret = send(t->sock, buf, len, 0);
+    if (ret >= 0) {
+        return ret;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    return errno == ECONNRESET ? MBEDTLS_ERR_NET_CONN_RESET : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    ntrip_tls_t *t = ctx;
+    int ret = recv(t->sock, buf, len, 0);
+    if (ret >= 0) {
+        return ret;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    return errno == ECONNRESET ? MBEDTLS_ERR_NET_CONN_RESET : MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+void ntrip_tls_init(ntrip_tls_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->sock = -1;
+    mbedtls_ssl_session_init(&t->session);
+}
+
+static void forget_session(ntrip_tls_t *t)
+{
+    mbedtls_ssl_session_free(&t->session);
+    mbedtls_ssl_session_init(&t->session);
+    t->have_session = false;
+}
+
+esp_err_t ntrip_tls_start(ntrip_tls_t *t, int sock, const char *host)
+{
+    if (rng_init() != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    mbedtls_ssl_init(&t->ssl);
+    mbedtls_ssl_config_init(&t->conf);
+    t->active = true;
+    t->sock = sock;
+    t->offered_session = false;
+    t->saw_certificate = false;
+    t->handshake_done = false;
+    t->handshake_start_ms = now_ms();
+
+    int ret = mbedtls_ssl_config_defaults(&t->conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "SSL config failed: -0x%04x", -ret);
+        ntrip_tls_close(t);
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_conf_rng(&t->conf, mbedtls_ctr_drbg_random, &s_ctr_drbg);
+    mbedtls_ssl_conf_max_tls_version(&t->conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&t->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+#if NTRIP_TLS_VERIFY
+    mbedtls_ssl_conf_authmode(&t->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    if (esp_crt_bundle_attach(&t->conf) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to attach CA bundle");
+        ntrip_tls_close(t);
+        return ESP_FAIL;
+    }
+#else
+    mbedtls_ssl_conf_authmode(&t->conf, MBEDTLS_SSL_VERIFY_NONE);
+#endif
+
+    ret = mbedtls_ssl_setup(&t->ssl, &t->conf);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&t->ssl, host);
+    }
+    if (ret != 0) {
+        ESP_LOGE(TAG, "SSL setup failed: -0x%04x", -ret);
+        ntrip_tls_close(t);
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_set_bio(&t->ssl, t, bio_send, bio_recv, NULL);
+
+    if (t->have_session) {
+        if (mbedtls_ssl_set_session(&t->ssl, &t->session) == 0) {
+            t->offered_session = true;
+        } else {
+            forget_session(t);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * Handshake finished - record timing and keep the session for next time
+ */
+static void handshake_complete(ntrip_tls_t *t)
+{
+    uint32_t elapsed = (uint32_t)(now_ms() - t->handshake_start_ms);
+    t->handshake_done = true;
+
+    if (ntrip_tls_resumed(t)) {
+        t->stats.resumed_handshakes++;
+        t->stats.last_resumed_ms = elapsed;
+        if (elapsed > t->stats.max_resumed_ms) {
+            t->stats.max_resumed_ms = elapsed;
+        }
+    } else {
+        t->stats.full_handshakes++;
+        t->stats.last_full_ms = elapsed;
+        if (elapsed > t->stats.max_full_ms) {
+            t->stats.max_full_ms = elapsed;
+        }
+    }
+    ESP_LOGI(TAG, "%s handshake in %lu ms (%s)",
+             ntrip_tls_resumed(t) ? "Resumed" : "Full", (unsigned long)elapsed,
+             mbedtls_ssl_get_ciphersuite(&t->ssl));
+
+    forget_session(t);
+    if (mbedtls_ssl_get_session(&t->ssl, &t->session) == 0) {
+        t->have_session = true;
+    }
+}
+
+esp_err_t ntrip_tls_handshake(ntrip_tls_t *t)
+{
+    if (!t->active) {
+        return ESP_FAIL;
+    }
+
+    while (!mbedtls_ssl_is_handshake_over(&t->ssl)) {
+        int ret = mbedtls_ssl_handshake_step(&t->ssl);
+
+        // Only a full handshake ever reaches the server Certificate state
+        if (t->ssl.MBEDTLS_PRIVATE(state) == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+            t->saw_certificate = true;
+        }
+
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Handshake failed: -0x%04x", -ret);
+            uint32_t flags = mbedtls_ssl_get_verify_result(&t->ssl);
+            if (flags != 0 && flags != (uint32_t)-1) {
+                ESP_LOGE(TAG, "Certificate verification failed: 0x%lx", (unsigned long)flags);
+            }
+            t->stats.handshake_failures++;
+            // Don't keep offering a session the caster may be choking on
+            if (t->offered_session) {
+                forget_session(t);
+            }
+            return ESP_FAIL;
+        }
+    }
+
+    if (!t->handshake_done) {
+        handshake_complete(t);
+    }
+    return ESP_OK;
+}
+
+bool ntrip_tls_resumed(const ntrip_tls_t *t)
+{
+    return t->offered_session && !t->saw_certificate;
+}
+
+int ntrip_tls_send(ntrip_tls_t *t, const void *data, size_t len)
+{
+    int ret = mbedtls_ssl_write(&t->ssl, data, len);
+    if (ret >= 0) {
+        return ret;
+    }
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        errno = EAGAIN;
+    } else {
+        ESP_LOGW(TAG, "TLS write failed: -0x%04x", -ret);
+        errno = EIO;
+    }
+    return -1;
+}
+
+int ntrip_tls_recv(ntrip_tls_t *t, void *data, size_t len)
+{
+    int ret = mbedtls_ssl_read(&t->ssl, data, len);
+    if (ret >= 0) {
+        return ret;
+    }
+    if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        return 0;
+    }
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        errno = EAGAIN;
+    } else {
+        ESP_LOGW(TAG, "TLS read failed: -0x%04x", -ret);
+        errno = EIO;
+    }
+    return -1;
+}
+
+void ntrip_tls_close(ntrip_tls_t *t)
+{
+    if (!t->active) {
+        return;
+    }
+    if (t->handshake_done) {
+        mbedtls_ssl_close_notify(&t->ssl);  // Best effort, socket is non-blocking
+    }
+    mbedtls_ssl_free(&t->ssl);
+    mbedtls_ssl_config_free(&t->conf);
+    t->active = false;
+    t->sock = -1;
+}
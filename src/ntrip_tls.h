@@ -0,0 +1,87 @@
+/**
+ * NTRIP TLS - Non-blocking mbedTLS transport for a caster session
+ *
+ * Wraps an already-connected TCP socket. The negotiated session is kept
+ * across reconnects and offered on the next handshake, so a reconnect
+ * after a WiFi roam skips the certificate exchange and key agreement.
+ */
+
+#ifndef NTRIP_TLS_H
+#define NTRIP_TLS_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "mbedtls/ssl.h"
+
+/**
+ * Handshake statistics
+ */
+typedef struct {
+    uint32_t full_handshakes;
+    uint32_t resumed_handshakes;    // Server accepted the cached session
+    uint32_t handshake_failures;
+    uint32_t last_full_ms;          // TCP connected to handshake done
+    uint32_t last_resumed_ms;
+    uint32_t max_full_ms;
+    uint32_t max_resumed_ms;
+} ntrip_tls_stats_t;
+
+/**
+ * One TLS connection plus the session cached from the previous one
+ */
+typedef struct {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    bool active;                // ssl/conf are set up
+    int sock;
+
+    mbedtls_ssl_session session;
+    bool have_session;          // session is worth offering
+    bool offered_session;       // Current handshake offered it
+    bool saw_certificate;       // Server sent a certificate: full handshake
+    bool handshake_done;
+    int64_t handshake_start_ms;
+
+    ntrip_tls_stats_t stats;
+} ntrip_tls_t;
+
+/**
+ * Reset state (call once per session; the session cache starts empty)
+ */
+void ntrip_tls_init(ntrip_tls_t *t);
+
+/**
+ * Start TLS on a connected non-blocking socket
+ * @param host Used for SNI and certificate verification
+ */
+esp_err_t ntrip_tls_start(ntrip_tls_t *t, int sock, const char *host);
+
+/**
+ * Advance the handshake without blocking
+ * @return ESP_OK when done, ESP_ERR_NOT_FINISHED while in progress,
+ *         ESP_FAIL if the handshake failed
+ */
+esp_err_t ntrip_tls_handshake(ntrip_tls_t *t);
+
+/**
+ * Was the last completed handshake a resumption?
+ */
+bool ntrip_tls_resumed(const ntrip_tls_t *t);
+
+/**
+ * send()/recv() equivalents on the TLS stream
+ * Return bytes transferred, 0 when the peer closed (recv only), or -1 with
+ * errno set (EAGAIN when the call would block).
+ */
+int ntrip_tls_send(ntrip_tls_t *t, const void *data, size_t len);
+int ntrip_tls_recv(ntrip_tls_t *t, void *data, size_t len);
+
+/**
+ * Tear down the connection; the cached session is kept
+ * Does not close the socket.
+ */
+void ntrip_tls_close(ntrip_tls_t *t);
+
+#endif // NTRIP_TLS_H
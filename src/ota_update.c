@@ -18,6 +18,8 @@
 
 static const char *TAG = "ota";
 
+static uint32_t s_bytes_received = 0;
+
 const char* ota_get_version(void)
 {
     return FIRMWARE_VERSION;
@@ -79,6 +81,9 @@ bool ota_check_for_update(char *new_version, size_t max_len)
     char version_buf[33] = {0};
     int read_len = esp_http_client_read(client, version_buf, sizeof(version_buf) - 1);
     esp_http_client_cleanup(client);
+    if (read_len > 0) {
+        s_bytes_received += read_len;
+    }
 
     if (read_len <= 0) {
         ESP_LOGW(TAG, "Failed to read version");
@@ -127,7 +132,31 @@ esp_err_t ota_perform_update(void)
         .http_config = &http_config,
     };
 
-    esp_err_t ret = esp_https_ota(&ota_config);
+    // Step through the download ourselves so the image bytes can be counted
+    esp_https_ota_handle_t handle = NULL;
+    esp_err_t ret = esp_https_ota_begin(&ota_config, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "OTA begin failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    do {
+        ret = esp_https_ota_perform(handle);
+    } while (ret == ESP_ERR_HTTPS_OTA_IN_PROGRESS);
+
+    int image_len = esp_https_ota_get_image_len_read(handle);
+    if (image_len > 0) {
+        s_bytes_received += image_len;
+    }
+
+    if (ret == ESP_OK && esp_https_ota_is_complete_data_received(handle)) {
+        ret = esp_https_ota_finish(handle);
+    } else {
+        if (ret == ESP_OK) {
+            ret = ESP_ERR_INVALID_SIZE;  // Connection closed before the whole image
+        }
+        esp_https_ota_abort(handle);
+    }
 
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "OTA update successful! Rebooting in 3 seconds...");
@@ -139,3 +168,8 @@ esp_err_t ota_perform_update(void)
 
     return ret;
 }
+
+uint32_t ota_get_bytes_received(void)
+{
+    return s_bytes_received;
+}
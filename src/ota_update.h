@@ -7,6 +7,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 /**
@@ -29,4 +30,9 @@ bool ota_check_for_update(char *new_version, size_t max_len);
  */
 esp_err_t ota_perform_update(void);
 
+/**
+ * Get bytes downloaded by version checks and firmware updates
+ */
+uint32_t ota_get_bytes_received(void);
+
 #endif // OTA_UPDATE_H
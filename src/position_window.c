@@ -0,0 +1,101 @@
+/**
+ * Position Window - Running summary of every epoch between two reports
+ *
+ * Sums are kept in int64 of the receiver's integers (1e-7 deg, mm), so
+ * the mean is exact and costs one add per epoch and field; no float at
+ * all. Dwell time is charged to the fix class of the previous epoch, up
+ * to the next epoch or the end of the window.
+ */
+
+#include <string.h>
+
+#include "position_window.h"
+
+static position_window_class_t fix_class(const zed_position_t *pos)
+{
+    if (!pos->valid) return POSITION_WINDOW_NO_FIX;
+    if (pos->carr_soln == 2) return POSITION_WINDOW_FIXED;
+    if (pos->carr_soln == 1) return POSITION_WINDOW_FLOAT;
+    return POSITION_WINDOW_GNSS;
+}
+
+/**
+ * Round-to-nearest division, halves away from zero
+ */
+static int32_t div_round(int64_t sum, uint32_t n)
+{
+    int64_t half = n / 2;
+    return (int32_t)(sum >= 0 ? (sum + half) / n : (sum - half) / n);
+}
+
+static void restart(position_window_t *w, int64_t now_ms)
+{
+    w->start_ms = now_ms;
+    w->last_ms = now_ms;
+    w->samples = 0;
+    w->valid = 0;
+    memset(w->sum, 0, sizeof(w->sum));
+    memset(w->dwell_ms, 0, sizeof(w->dwell_ms));
+}
+
+void position_window_init(position_window_t *w, int64_t now_ms)
+{
+    memset(w, 0, sizeof(*w));
+    restart(w, now_ms);
+}
+
+void position_window_add(position_window_t *w, const zed_position_t *pos, int64_t now_ms)
+{
+    if (w->have_class) {
+        w->dwell_ms[w->last_class] += (uint32_t)(now_ms - w->last_ms);
+    }
+    w->last_class = fix_class(pos);
+    w->have_class = true;
+    w->last_ms = now_ms;
+    w->samples++;
+
+    if (!pos->valid) {
+        return;
+    }
+
+    // Accuracies are 0xFFFFFFFF before the first fix; never valid, but clamp
+    const int32_t v[POSITION_WINDOW_FIELDS] = {
+        pos->lat_e7, pos->lon_e7, pos->alt_mm,
+        pos->h_acc_mm > INT32_MAX ? INT32_MAX : (int32_t)pos->h_acc_mm,
+        pos->v_acc_mm > INT32_MAX ? INT32_MAX : (int32_t)pos->v_acc_mm,
+    };
+    for (int i = 0; i < POSITION_WINDOW_FIELDS; i++) {
+        w->sum[i] += v[i];
+        if (w->valid == 0 || v[i] < w->min[i]) w->min[i] = v[i];
+        if (w->valid == 0 || v[i] > w->max[i]) w->max[i] = v[i];
+    }
+    w->valid++;
+}
+
+void position_window_close(position_window_t *w, int64_t now_ms,
+                           position_window_summary_t *summary)
+{
+    if (w->have_class) {
+        w->dwell_ms[w->last_class] += (uint32_t)(now_ms - w->last_ms);
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    summary->samples = w->samples;
+    summary->valid = w->valid;
+    summary->duration_ms = (uint32_t)(now_ms - w->start_ms);
+    memcpy(summary->dwell_ms, w->dwell_ms, sizeof(summary->dwell_ms));
+
+    if (w->valid > 0) {
+        position_window_range_t *r[POSITION_WINDOW_FIELDS] = {
+            &summary->lat_e7, &summary->lon_e7, &summary->alt_mm,
+            &summary->h_acc_mm, &summary->v_acc_mm,
+        };
+        for (int i = 0; i < POSITION_WINDOW_FIELDS; i++) {
+            r[i]->mean = div_round(w->sum[i], w->valid);
+            r[i]->min = w->min[i];
+            r[i]->max = w->max[i];
+        }
+    }
+
+    restart(w, now_ms);
+}
@@ -0,0 +1,89 @@
+/**
+ * Position Window - Running summary of every epoch between two reports
+ *
+ * The receiver may produce several epochs per report interval. Instead of
+ * reporting whichever one happens to arrive last, each epoch is folded
+ * into O(1) running aggregates: mean/min/max of position and accuracy,
+ * and how long each kind of fix lasted.
+ */
+
+#ifndef POSITION_WINDOW_H
+#define POSITION_WINDOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "zed_rover.h"
+
+/**
+ * Fix classes for dwell times
+ */
+typedef enum {
+    POSITION_WINDOW_NO_FIX = 0,     // No valid fix
+    POSITION_WINDOW_GNSS,           // Valid fix, no carrier solution
+    POSITION_WINDOW_FLOAT,          // RTK float
+    POSITION_WINDOW_FIXED,          // RTK fixed
+    POSITION_WINDOW_CLASSES
+} position_window_class_t;
+
+/**
+ * Mean, minimum and maximum of one quantity
+ */
+typedef struct {
+    int32_t mean;
+    int32_t min;
+    int32_t max;
+} position_window_range_t;
+
+/**
+ * Summary of one closed window
+ * Position and accuracy cover the epochs with a valid fix only; all zero
+ * if there were none.
+ */
+typedef struct {
+    uint32_t samples;               // Epochs in the window
+    uint32_t valid;                 // Of which with a valid fix
+    uint32_t duration_ms;
+    position_window_range_t lat_e7;     // 1e-7 degrees
+    position_window_range_t lon_e7;
+    position_window_range_t alt_mm;
+    position_window_range_t h_acc_mm;
+    position_window_range_t v_acc_mm;
+    uint32_t dwell_ms[POSITION_WINDOW_CLASSES];
+} position_window_summary_t;
+
+#define POSITION_WINDOW_FIELDS 5     // lat, lon, alt, hAcc, vAcc
+
+/**
+ * Aggregator state
+ */
+typedef struct {
+    int64_t start_ms;
+    int64_t last_ms;                // Latest epoch (or window start)
+    bool have_class;
+    uint8_t last_class;             // Fix class since last_ms
+    uint32_t samples;
+    uint32_t valid;
+    int64_t sum[POSITION_WINDOW_FIELDS];
+    int32_t min[POSITION_WINDOW_FIELDS];
+    int32_t max[POSITION_WINDOW_FIELDS];
+    uint32_t dwell_ms[POSITION_WINDOW_CLASSES];
+} position_window_t;
+
+/**
+ * Start the first window
+ */
+void position_window_init(position_window_t *w, int64_t now_ms);
+
+/**
+ * Fold one epoch into the window
+ */
+void position_window_add(position_window_t *w, const zed_position_t *pos, int64_t now_ms);
+
+/**
+ * Summarize the window and start the next one
+ * The fix class of the latest epoch carries over into the new window.
+ */
+void position_window_close(position_window_t *w, int64_t now_ms,
+                           position_window_summary_t *summary);
+
+#endif // POSITION_WINDOW_H
@@ -0,0 +1,176 @@
+/**
+ * RTCM 3 Framer
+ *
+ * Frame layout: 0xD3 | 6 reserved bits + 10-bit length | payload | CRC-24Q
+ * A false preamble inside payload data is rejected by the CRC, after which
+ * the framer rescans the bytes it already holds for the next 0xD3.
+ */
+
+#include <string.h>
+
+#include "rtcm3.h"
+
+#define RTCM3_CRC24Q_POLY 0x1864CFB
+
+uint32_t rtcm3_crc24q(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint32_t)data[i] << 16;
+        for (int b = 0; b < 8; b++) {
+            crc <<= 1;
+            if (crc & 0x1000000) {
+                crc ^= RTCM3_CRC24Q_POLY;
+            }
+        }
+    }
+    return crc & 0xFFFFFF;
+}
+
+uint32_t rtcm3_get_bits(const uint8_t *payload, size_t bit_pos, int bit_len)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < bit_len; i++) {
+        size_t pos = bit_pos + i;
+        value = (value << 1) | ((payload[pos / 8] >> (7 - pos % 8)) & 0x01);
+    }
+    return value;
+}
+
+void rtcm3_framer_init(rtcm3_framer_t *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+/**
+ * Drop the current (false) preamble and skip ahead to the next candidate
+ */
+static void resync(rtcm3_framer_t *f)
+{
+    size_t i = 1;
+    while (i < f->len && f->buf[i] != RTCM3_PREAMBLE) {
+        i++;
+    }
+    f->skipped_bytes += i;
+    memmove(f->buf, f->buf + i, f->len - i);
+    f->len -= i;
+}
+
+/**
+ * Fill in routing fields from a validated frame
+ */
+static void decode_header(const uint8_t *buf, size_t len, rtcm3_frame_t *frame)
+{
+    const uint8_t *payload = buf + RTCM3_HEADER_LEN;
+    size_t payload_bits = (len - RTCM3_HEADER_LEN - RTCM3_CRC_LEN) * 8;
+
+    memset(frame, 0, sizeof(*frame));
+    frame->data = buf;
+    frame->len = len;
+    frame->crc = ((uint32_t)buf[len - 3] << 16) | (buf[len - 2] << 8) | buf[len - 1];
+
+    if (payload_bits >= 12) {
+        frame->msg_type = rtcm3_get_bits(payload, 0, 12);
+    }
+
+    // Legacy observables, station ARP/antenna and MSM all start with DF003;
+    // in ephemeris messages the same bits are a satellite number
+    uint16_t t = frame->msg_type;
+    bool station_msg = (t >= 1001 && t <= 1012) || t == 1033 || t == 1230 ||
+                       (t >= 1071 && t <= 1137);
+    if (station_msg && payload_bits >= 24) {
+        frame->station_id = rtcm3_get_bits(payload, 12, 12);
+        frame->has_station = true;
+    }
+
+    // Legacy GPS (DF004 TOW) and GLONASS (DF034 time of day) observables;
+    // the DF005 synchronous flag says more observables of the epoch follow
+    if (t >= 1001 && t <= 1004 && payload_bits >= 55) {
+        frame->is_obs = true;
+        frame->epoch = rtcm3_get_bits(payload, 24, 30);
+        frame->last_of_epoch = rtcm3_get_bits(payload, 54, 1) == 0;
+    } else if (t >= 1009 && t <= 1012 && payload_bits >= 52) {
+        frame->is_obs = true;
+        frame->epoch = rtcm3_get_bits(payload, 24, 27);
+        frame->last_of_epoch = rtcm3_get_bits(payload, 51, 1) == 0;
+    }
+
+    // MSM1-7 for GPS, GLONASS, Galileo, SBAS, QZSS, BeiDou, NavIC
+    if (t >= 1071 && t <= 1137 && (t % 10) >= 1 && (t % 10) <= 7 && payload_bits >= 55) {
+        frame->is_msm = true;
+        frame->is_obs = true;
+        frame->epoch = rtcm3_get_bits(payload, 24, 30);
+        frame->last_of_epoch = rtcm3_get_bits(payload, 54, 1) == 0;
+        if (payload_bits >= 137) {
+            frame->sat_mask = ((uint64_t)rtcm3_get_bits(payload, 73, 32) << 32) |
+                              rtcm3_get_bits(payload, 105, 32);
+        }
+    }
+}
+
+/**
+ * Check whether the buffer starts with a complete, valid frame
+ */
+static bool scan(rtcm3_framer_t *f, rtcm3_frame_t *frame)
+{
+    while (f->len >= RTCM3_HEADER_LEN) {
+        if (f->buf[0] != RTCM3_PREAMBLE || (f->buf[1] & 0xFC) != 0) {
+            resync(f);
+            continue;
+        }
+
+        size_t payload_len = ((f->buf[1] & 0x03) << 8) | f->buf[2];
+        size_t total = RTCM3_HEADER_LEN + payload_len + RTCM3_CRC_LEN;
+        if (f->len < total) {
+            return false;
+        }
+
+        uint32_t crc = rtcm3_crc24q(f->buf, total - RTCM3_CRC_LEN);
+        uint32_t rx_crc = ((uint32_t)f->buf[total - 3] << 16) |
+                          (f->buf[total - 2] << 8) | f->buf[total - 1];
+        if (crc != rx_crc) {
+            f->crc_errors++;
+            resync(f);
+            continue;
+        }
+
+        f->frame_len = total;
+        f->frames++;
+        decode_header(f->buf, total, frame);
+        return true;
+    }
+    return false;
+}
+
+size_t rtcm3_framer_push(rtcm3_framer_t *f, const uint8_t *data, size_t len,
+                         rtcm3_frame_t *frame, bool *have_frame)
+{
+    *have_frame = false;
+
+    // Release the frame handed out last time, keeping anything buffered after it
+    if (f->frame_len > 0) {
+        size_t extra = f->len - f->frame_len;
+        memmove(f->buf, f->buf + f->frame_len, extra);
+        f->len = extra;
+        f->frame_len = 0;
+        if (scan(f, frame)) {
+            *have_frame = true;
+            return 0;
+        }
+    }
+
+    size_t used = 0;
+    while (used < len) {
+        uint8_t b = data[used++];
+        if (f->len == 0 && b != RTCM3_PREAMBLE) {
+            f->skipped_bytes++;
+            continue;
+        }
+        f->buf[f->len++] = b;
+        if (scan(f, frame)) {
+            *have_frame = true;
+            break;
+        }
+    }
+    return used;
+}
@@ -0,0 +1,75 @@
+/**
+ * RTCM 3 Framer
+ *
+ * Splits a raw correction byte stream into CRC-checked RTCM 3 frames and
+ * extracts the header fields needed for routing (type, station, epoch).
+ */
+
+#ifndef RTCM3_H
+#define RTCM3_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define RTCM3_PREAMBLE      0xD3
+#define RTCM3_HEADER_LEN    3
+#define RTCM3_CRC_LEN       3
+#define RTCM3_MAX_PAYLOAD   1023
+#define RTCM3_MAX_FRAME     (RTCM3_HEADER_LEN + RTCM3_MAX_PAYLOAD + RTCM3_CRC_LEN)
+
+/**
+ * A complete, CRC-valid frame
+ * data points into the framer and is valid until the next push
+ */
+typedef struct {
+    const uint8_t *data;    // Whole frame including preamble and CRC
+    size_t len;
+    uint16_t msg_type;      // DF002
+    uint16_t station_id;    // DF003 (0 if the message has none)
+    bool has_station;       // Message carries DF003 (observables, ARP, antenna)
+    bool is_msm;            // Multiple Signal Message (1071-1137)
+    bool is_obs;            // Observables with an epoch time: MSM or legacy 1001-1004/1009-1012
+    uint32_t epoch;         // Epoch time field (MSM, DF004 or DF034), 0 if not observables
+    bool last_of_epoch;     // MSM "multiple message" bit / legacy DF005 sync flag clear
+    uint64_t sat_mask;      // MSM DF394 satellite mask, tells the parts of a split epoch apart
+    uint32_t crc;           // CRC-24Q, doubles as a frame fingerprint
+} rtcm3_frame_t;
+
+/**
+ * Incremental framer state
+ */
+typedef struct {
+    uint8_t buf[RTCM3_MAX_FRAME];
+    size_t len;             // Bytes collected so far
+    size_t frame_len;       // Length of the frame returned by the last push
+    uint32_t frames;        // Valid frames found
+    uint32_t crc_errors;    // Candidate frames rejected on CRC
+    uint32_t skipped_bytes; // Bytes discarded while hunting for a preamble
+} rtcm3_framer_t;
+
+/**
+ * Reset framer state
+ */
+void rtcm3_framer_init(rtcm3_framer_t *f);
+
+/**
+ * Feed bytes into the framer
+ * Stops as soon as a frame is complete, so a call returns at most one frame.
+ * @param frame Set when a frame is complete
+ * @return Number of input bytes consumed
+ */
+size_t rtcm3_framer_push(rtcm3_framer_t *f, const uint8_t *data, size_t len,
+                         rtcm3_frame_t *frame, bool *have_frame);
+
+/**
+ * Compute CRC-24Q over a buffer
+ */
+uint32_t rtcm3_crc24q(const uint8_t *data, size_t len);
+
+/**
+ * Read an unsigned bit field (MSB first) from a frame payload
+ */
+uint32_t rtcm3_get_bits(const uint8_t *payload, size_t bit_pos, int bit_len);
+
+#endif // RTCM3_H
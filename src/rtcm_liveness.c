@@ -0,0 +1,146 @@
+/**
+ * RTCM Liveness - Epoch-cadence health of a correction stream
+ *
+ * An epoch is one observables message per constellation (MSM, or legacy
+ * 1001-1004/1009-1012); the last one has the multiple-message bit (DF005
+ * for legacy) clear, so the next observables after it start a new epoch.
+ * If that last message is lost, a message type already seen in the epoch
+ * coming back with another epoch time starts the new one instead.
+ * The cadence is an average of the gaps between epoch starts. Jitter is
+ * the RFC 3550 running mean of how far each gap strays from the gap in
+ * the epoch time fields, which is what separates a bursty transport from
+ * a smooth one at the same rate; an epoch lost on the way is not jitter.
+ */
+
+#include <string.h>
+
+#include "rtcm_liveness.h"
+
+#define DEFAULT_EPOCH_INTERVAL_MS 1000
+#define MIN_EPOCH_INTERVAL_MS     50
+#define MAX_EPOCH_INTERVAL_MS     30000
+
+// Degraded after 2.5 missed epochs, but never faster than this
+#define MISSED_EPOCHS_X2          5
+#define MIN_DEGRADED_MS           1000
+
+// A new stream must deliver its first epoch within this time
+#define FIRST_EPOCH_TIMEOUT_MS    5000
+
+void rtcm_liveness_init(rtcm_liveness_t *l)
+{
+    memset(l, 0, sizeof(*l));
+    l->stats.epoch_interval_ms = DEFAULT_EPOCH_INTERVAL_MS;
+}
+
+void rtcm_liveness_start(rtcm_liveness_t *l, int64_t now_ms)
+{
+    l->have_epoch = false;
+    l->epoch_closed = false;
+    l->num_epoch_msgs = 0;
+    l->degraded = false;
+    l->start_ms = now_ms;
+    l->last_frame_ms = now_ms;
+    l->last_epoch_ms = now_ms;
+}
+
+uint32_t rtcm_liveness_interval_ms(const rtcm_liveness_t *l)
+{
+    return l->stats.epoch_interval_ms;
+}
+
+/**
+ * Has this message type already been seen in the latest epoch with
+ * another epoch time? (Time fields only compare within a type.)
+ */
+static bool epoch_time_changed(const rtcm_liveness_t *l, const rtcm3_frame_t *frame)
+{
+    for (int i = 0; i < l->num_epoch_msgs; i++) {
+        if (l->epoch_msgs[i].msg_type == frame->msg_type) {
+            return l->epoch_msgs[i].epoch != frame->epoch;
+        }
+    }
+    return false;
+}
+
+static void remember_epoch_msg(rtcm_liveness_t *l, const rtcm3_frame_t *frame)
+{
+    for (int i = 0; i < l->num_epoch_msgs; i++) {
+        if (l->epoch_msgs[i].msg_type == frame->msg_type) {
+            return;
+        }
+    }
+    if (l->num_epoch_msgs < RTCM_LIVENESS_MAX_EPOCH_MSGS) {
+        l->epoch_msgs[l->num_epoch_msgs].msg_type = frame->msg_type;
+        l->epoch_msgs[l->num_epoch_msgs].epoch = frame->epoch;
+        l->num_epoch_msgs++;
+    }
+}
+
+bool rtcm_liveness_on_frame(rtcm_liveness_t *l, const rtcm3_frame_t *frame, int64_t now_ms)
+{
+    l->last_frame_ms = now_ms;
+    if (!frame->is_obs) {
+        return false;  // Station/ephemeris records say nothing about epoch flow
+    }
+
+    bool new_epoch = !l->have_epoch || l->epoch_closed || epoch_time_changed(l, frame);
+    if (new_epoch) {
+        if (l->have_epoch) {
+            int64_t dt = now_ms - l->last_epoch_ms;
+            // Time fields only compare within a message type (constellations
+            // count time differently)
+            uint32_t sent_dt = frame->epoch - l->epoch;
+            if (frame->msg_type == l->epoch_type &&
+                sent_dt > 0 && sent_dt <= MAX_EPOCH_INTERVAL_MS) {
+                int64_t d = dt - (int64_t)sent_dt;
+                uint32_t dev = (uint32_t)(d < 0 ? -d : d);
+                l->jitter_x16 += dev - ((l->jitter_x16 + 8) >> 4);
+                l->stats.jitter_ms = l->jitter_x16 >> 4;
+            }
+            if (dt >= MIN_EPOCH_INTERVAL_MS && dt <= MAX_EPOCH_INTERVAL_MS) {
+                l->stats.epoch_interval_ms = (l->stats.epoch_interval_ms * 3 + (uint32_t)dt) / 4;
+            }
+        }
+        l->have_epoch = true;
+        l->epoch = frame->epoch;
+        l->epoch_type = frame->msg_type;
+        l->last_epoch_ms = now_ms;
+        l->num_epoch_msgs = 0;
+        l->stats.epochs++;
+        l->degraded = false;
+    }
+    remember_epoch_msg(l, frame);
+    l->epoch_closed = frame->last_of_epoch;
+    return new_epoch;
+}
+
+bool rtcm_liveness_check(rtcm_liveness_t *l, int64_t now_ms)
+{
+    uint32_t interval = l->stats.epoch_interval_ms;
+    int64_t due_ms;
+    int64_t limit_ms;
+
+    if (!l->have_epoch) {
+        due_ms = l->start_ms;
+        limit_ms = FIRST_EPOCH_TIMEOUT_MS;
+    } else {
+        due_ms = l->last_epoch_ms + interval;
+        limit_ms = (int64_t)interval * MISSED_EPOCHS_X2 / 2;
+        if (limit_ms < MIN_DEGRADED_MS) {
+            limit_ms = MIN_DEGRADED_MS;
+        }
+    }
+
+    bool overdue = (now_ms - (l->have_epoch ? l->last_epoch_ms : l->start_ms)) > limit_ms;
+    if (overdue && !l->degraded) {
+        l->degraded = true;
+        l->stats.degraded_events++;
+        uint32_t latency = (uint32_t)(now_ms - due_ms);
+        l->stats.last_detection_ms = latency;
+        if (latency > l->stats.max_detection_ms) {
+            l->stats.max_detection_ms = latency;
+        }
+    }
+    return l->degraded;
+}
@@ -0,0 +1,79 @@
+/**
+ * RTCM Liveness - Epoch-cadence health of a correction stream
+ *
+ * Learns how often observation epochs (MSM or legacy 1001-1004/1009-1012)
+ * arrive and flags the stream as degraded after 2.5 missed epochs, no
+ * matter how many other bytes (keepalives, 1005 station records) keep
+ * trickling in.
+ */
+
+#ifndef RTCM_LIVENESS_H
+#define RTCM_LIVENESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rtcm3.h"
+
+#define RTCM_LIVENESS_MAX_EPOCH_MSGS 8  // Message types remembered per epoch
+
+/**
+ * Detection statistics
+ */
+typedef struct {
+    uint32_t epochs;                // Observation epochs seen
+    uint32_t degraded_events;       // Healthy -> degraded transitions
+    uint32_t last_detection_ms;     // Time from missed epoch due to detection
+    uint32_t max_detection_ms;
+    uint32_t epoch_interval_ms;     // Learned cadence
+    uint32_t jitter_ms;             // Smoothed epoch arrival jitter (RFC 3550 style)
+} rtcm_liveness_stats_t;
+
+/**
+ * Tracker state for one stream
+ */
+typedef struct {
+    bool have_epoch;
+    bool epoch_closed;          // Last observables said no more follow for the epoch
+    bool degraded;
+    uint32_t epoch;             // Epoch time field of the latest epoch's first message
+    uint16_t epoch_type;        // Message type that started the latest epoch
+    struct {
+        uint16_t msg_type;
+        uint32_t epoch;
+    } epoch_msgs[RTCM_LIVENESS_MAX_EPOCH_MSGS];  // Observables of the latest epoch
+    uint8_t num_epoch_msgs;
+    int64_t start_ms;           // Stream start
+    int64_t last_frame_ms;
+    int64_t last_epoch_ms;      // Arrival of the first frame of the latest epoch
+    uint32_t jitter_x16;        // Jitter estimate, 1/16 ms
+    rtcm_liveness_stats_t stats;
+} rtcm_liveness_t;
+
+/**
+ * Reset tracker at stream start (keeps learned cadence and statistics)
+ */
+void rtcm_liveness_start(rtcm_liveness_t *l, int64_t now_ms);
+
+/**
+ * Reset everything including statistics
+ */
+void rtcm_liveness_init(rtcm_liveness_t *l);
+
+/**
+ * Account for a received frame
+ * @return true if the frame starts a new observation epoch
+ */
+bool rtcm_liveness_on_frame(rtcm_liveness_t *l, const rtcm3_frame_t *frame, int64_t now_ms);
+
+/**
+ * Re-evaluate health
+ * @return true if the stream is degraded (epochs overdue or none at all)
+ */
+bool rtcm_liveness_check(rtcm_liveness_t *l, int64_t now_ms);
+
+/**
+ * Nominal time between epochs (learned, 1000 ms until known)
+ */
+uint32_t rtcm_liveness_interval_ms(const rtcm_liveness_t *l);
+
+#endif // RTCM_LIVENESS_H
@@ -0,0 +1,248 @@
+/**
+ * RTCM Merge - Frame-level selector for redundant correction streams
+ *
+ * Inputs are grouped by the reference station they carry. Within the
+ * forwarded station every input races: whichever delivers a frame first
+ * forwards it, so a stalled path costs nothing while another path of the
+ * same station is alive. MSM frames count as duplicates when type,
+ * station, epoch and satellite mask match, so two casters that re-encode
+ * the same base don't feed the receiver the same epoch twice, while the
+ * parts of an epoch split over several messages all get through. Other
+ * frames are matched on CRC and length, but only against a copy from
+ * another input within RTCM_MERGE_DUP_WINDOW_MS: station position, antenna
+ * and bias messages repeat byte for byte on every input, and each repeat
+ * must get through.
+ *
+ * Changing station is decided per frame rather than on a timer: a frame
+ * from another station that starts a new epoch takes over when the active
+ * station has delivered no epoch for 1.5 epoch intervals on any input, so
+ * a lost station costs at most one epoch. A higher-priority input takes
+ * the lead back after RTCM_MERGE_FAILBACK_MS of unbroken epochs - station
+ * records alone prove nothing - within the active station's group too, so
+ * the leader the arbiter reports and benches is the path actually feeding
+ * the receiver. Switching only at the start of an observation epoch keeps
+ * the receiver from seeing a half epoch from each station.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+
+#include "rtcm_merge.h"
+#include "config.h"
+
+static const char *TAG = "rtcm_merge";
+
+#ifndef RTCM_MERGE_FAILBACK_MS
+#define RTCM_MERGE_FAILBACK_MS 10000  // Primary must stream this long before we return
+#endif
+
+void rtcm_merge_init(rtcm_merge_t *m, int num_inputs)
+{
+    memset(m, 0, sizeof(*m));
+    m->num_inputs = num_inputs < RTCM_MERGE_MAX_INPUTS ? num_inputs : RTCM_MERGE_MAX_INPUTS;
+    m->active = -1;
+    m->last_forward_input = -1;
+    m->stats.active_input = -1;
+    m->stats.active_station = -1;
+    for (int i = 0; i < m->num_inputs; i++) {
+        rtcm_liveness_init(&m->inputs[i].liveness);
+    }
+}
+
+void rtcm_merge_set_input_up(rtcm_merge_t *m, int input, bool up, int64_t now_ms)
+{
+    if (input < 0 || input >= m->num_inputs) {
+        return;
+    }
+    rtcm_merge_input_t *in = &m->inputs[input];
+    if (up && !in->up) {
+        in->up_since_ms = now_ms;
+        in->epochs_since_ms = 0;
+        in->have_station = false;
+        rtcm_liveness_start(&in->liveness, now_ms);
+    }
+    in->up = up;
+
+    if (!up && m->active == input) {
+        // Next frame from any other input takes over immediately
+        m->active = -1;
+        m->stats.active_input = -1;
+    }
+}
+
+static bool already_forwarded(const rtcm_merge_t *m, int input, const rtcm3_frame_t *frame,
+                              int64_t now_ms)
+{
+    for (int i = 0; i < RTCM_MERGE_DEDUP_DEPTH; i++) {
+        if (frame->is_msm) {
+            if (m->seen[i].is_msm && m->seen[i].msg_type == frame->msg_type &&
+                m->seen[i].station == frame->station_id && m->seen[i].epoch == frame->epoch &&
+                m->seen[i].sat_mask == frame->sat_mask) {
+                return true;
+            }
+        } else if (m->seen[i].len == frame->len && m->seen[i].crc == frame->crc &&
+                   m->seen[i].input != input && now_ms - m->seen[i].ms <= RTCM_MERGE_DUP_WINDOW_MS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void remember(rtcm_merge_t *m, int input, const rtcm3_frame_t *frame, int64_t now_ms)
+{
+    m->seen[m->seen_pos].crc = frame->crc;
+    m->seen[m->seen_pos].len = frame->len;
+    m->seen[m->seen_pos].msg_type = frame->msg_type;
+    m->seen[m->seen_pos].station = frame->station_id;
+    m->seen[m->seen_pos].epoch = frame->epoch;
+    m->seen[m->seen_pos].sat_mask = frame->sat_mask;
+    m->seen[m->seen_pos].is_msm = frame->is_msm;
+    m->seen[m->seen_pos].input = (int8_t)input;
+    m->seen[m->seen_pos].ms = now_ms;
+    m->seen_pos = (m->seen_pos + 1) % RTCM_MERGE_DEDUP_DEPTH;
+}
+
+/**
+ * Does this input carry the station being forwarded?
+ */
+static bool in_active_group(const rtcm_merge_t *m, int input)
+{
+    if (input == m->active) {
+        return true;
+    }
+    const rtcm_merge_input_t *in = &m->inputs[input];
+    return m->active >= 0 && m->have_station && in->up && in->have_station &&
+           in->station == m->station;
+}
+
+/**
+ * Has the input not delivered an epoch for 1.5 epoch intervals?
+ * (keepalives and station records don't count)
+ */
+static bool input_quiet(const rtcm_merge_input_t *in, int64_t now_ms)
+{
+    return now_ms - in->liveness.last_epoch_ms >
+           (int64_t)rtcm_liveness_interval_ms(&in->liveness) * 3 / 2;
+}
+
+/**
+ * Has a higher-priority input delivered epochs without a break for long
+ * enough to take the lead back?
+ */
+static bool fails_back(const rtcm_merge_t *m, int candidate, int64_t now_ms)
+{
+    const rtcm_merge_input_t *cand = &m->inputs[candidate];
+    return candidate < m->active && cand->epochs_since_ms != 0 && !input_quiet(cand, now_ms) &&
+           now_ms - cand->epochs_since_ms >= RTCM_MERGE_FAILBACK_MS;
+}
+
+/**
+ * Should a frame from another station take over from the active one?
+ */
+static bool should_switch(const rtcm_merge_t *m, int candidate, bool new_epoch, int64_t now_ms)
+{
+    if (m->active < 0) {
+        return true;
+    }
+
+    // Only switch where the receiver sees a clean epoch boundary; station and
+    // ephemeris records are not one, they can land mid-epoch
+    if (!new_epoch) {
+        return false;
+    }
+
+    // Active station is quiet on every input that carries it
+    bool quiet = true;
+    for (int i = 0; i < m->num_inputs; i++) {
+        if (in_active_group(m, i) && !input_quiet(&m->inputs[i], now_ms)) {
+            quiet = false;
+            break;
+        }
+    }
+    if (quiet) {
+        return true;
+    }
+
+    return fails_back(m, candidate, now_ms);
+}
+
+static void switch_to(rtcm_merge_t *m, int input, int64_t now_ms)
+{
+    const rtcm_merge_input_t *in = &m->inputs[input];
+    bool station_change = in->have_station && (!m->have_station || in->station != m->station);
+
+    if (m->last_forward_input >= 0 && m->last_forward_input != input) {
+        uint32_t gap = (uint32_t)(now_ms - m->last_forward_ms);
+        m->stats.switches++;
+        m->stats.last_switch_latency_ms = gap;
+        if (gap > m->stats.max_switch_latency_ms) {
+            m->stats.max_switch_latency_ms = gap;
+        }
+        if (station_change && m->have_station) {
+            m->stats.station_switches++;
+            ESP_LOGW(TAG, "Corrections switched from station %u (input %d) to %u (input %d), %lu ms gap",
+                     m->station, m->last_forward_input, in->station, input, (unsigned long)gap);
+        } else {
+            ESP_LOGI(TAG, "Corrections now led by input %d (%lu ms gap)", input, (unsigned long)gap);
+        }
+    }
+    m->active = input;
+    m->stats.active_input = input;
+    if (in->have_station) {
+        m->have_station = true;
+        m->station = in->station;
+        m->stats.active_station = in->station;
+    }
+}
+
+bool rtcm_merge_offer(rtcm_merge_t *m, int input, const rtcm3_frame_t *frame, int64_t now_ms)
+{
+    if (input < 0 || input >= m->num_inputs) {
+        return false;
+    }
+    rtcm_merge_input_t *in = &m->inputs[input];
+
+    bool was_quiet = in->epochs_since_ms == 0 || input_quiet(in, now_ms);
+    bool new_epoch = rtcm_liveness_on_frame(&in->liveness, frame, now_ms);
+    if (new_epoch && was_quiet) {
+        in->epochs_since_ms = now_ms;
+    }
+    in->last_frame_ms = now_ms;
+    if (frame->has_station) {
+        in->have_station = true;
+        in->station = frame->station_id;
+    }
+
+    if (already_forwarded(m, input, frame, now_ms)) {
+        m->stats.duplicates_suppressed++;
+        return false;
+    }
+
+    if (in_active_group(m, input)) {
+        // Same station: take the lead if the leading path has stalled, or
+        // back once a higher-priority path has been steady for a while
+        if (input != m->active && new_epoch &&
+            (input_quiet(&m->inputs[m->active], now_ms) || fails_back(m, input, now_ms))) {
+            switch_to(m, input, now_ms);
+        }
+    } else if (should_switch(m, input, new_epoch, now_ms)) {
+        switch_to(m, input, now_ms);
+    } else {
+        m->stats.standby_frames_dropped++;
+        return false;
+    }
+
+    // The leading input defines the station (a base can be renumbered)
+    if (input == m->active && frame->has_station && m->station != frame->station_id) {
+        m->have_station = true;
+        m->station = frame->station_id;
+        m->stats.active_station = frame->station_id;
+    }
+
+    remember(m, input, frame, now_ms);
+    in->frames_forwarded++;
+    m->last_forward_input = input;
+    m->last_forward_ms = now_ms;
+    m->stats.frames_forwarded++;
+    return true;
+}
@@ -0,0 +1,94 @@
+/**
+ * RTCM Merge - Frame-level selector for redundant correction streams
+ *
+ * Several inputs (casters, a local radio) offer frames. The receiver is fed
+ * one reference station at a time: every input currently carrying that
+ * station forwards, first copy wins, and later copies of the same frame are
+ * suppressed. Inputs carrying another station are held back until the
+ * active station goes quiet, and the change happens at an epoch boundary.
+ */
+
+#ifndef RTCM_MERGE_H
+#define RTCM_MERGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rtcm3.h"
+#include "rtcm_liveness.h"
+
+#define RTCM_MERGE_MAX_INPUTS   4
+#define RTCM_MERGE_DEDUP_DEPTH  64
+#define RTCM_MERGE_DUP_WINDOW_MS 1000   // Non-MSM copies from another input this soon are duplicates
+
+/**
+ * Selector statistics
+ */
+typedef struct {
+    uint32_t frames_forwarded;
+    uint32_t duplicates_suppressed;   // Frames already forwarded from another input
+    uint32_t standby_frames_dropped;  // Frames from inputs carrying another station
+    uint32_t switches;                // Changes of leading input
+    uint32_t station_switches;        // Changes of forwarded station
+    uint32_t last_switch_latency_ms;  // Gap in forwarded stream at last switch
+    uint32_t max_switch_latency_ms;
+    int active_input;                 // -1 if nothing is being forwarded
+    int active_station;               // -1 until known
+} rtcm_merge_stats_t;
+
+/**
+ * Per-input tracking
+ */
+typedef struct {
+    bool up;                    // Input connected and streaming
+    int64_t up_since_ms;
+    int64_t epochs_since_ms;    // Start of the current unbroken run of epochs, 0 if none
+    int64_t last_frame_ms;
+    bool have_station;
+    uint16_t station;           // Station of this input's latest observables
+    uint32_t frames_forwarded;  // Frames this input delivered first
+    rtcm_liveness_t liveness;   // Epoch cadence of this input
+} rtcm_merge_input_t;
+
+/**
+ * Selector state
+ */
+typedef struct {
+    rtcm_merge_input_t inputs[RTCM_MERGE_MAX_INPUTS];
+    int num_inputs;
+    int active;                 // Leading input, -1 if none
+    bool have_station;
+    uint16_t station;           // Station being forwarded
+    int last_forward_input;
+    int64_t last_forward_ms;
+    struct {
+        uint32_t crc;
+        uint32_t epoch;
+        uint64_t sat_mask;
+        uint16_t len;
+        uint16_t msg_type;
+        uint16_t station;
+        bool is_msm;
+        int8_t input;
+        int64_t ms;
+    } seen[RTCM_MERGE_DEDUP_DEPTH];
+    int seen_pos;
+    rtcm_merge_stats_t stats;
+} rtcm_merge_t;
+
+/**
+ * Reset selector; input 0 has the highest priority
+ */
+void rtcm_merge_init(rtcm_merge_t *m, int num_inputs);
+
+/**
+ * Mark an input as connected or disconnected
+ */
+void rtcm_merge_set_input_up(rtcm_merge_t *m, int input, bool up, int64_t now_ms);
+
+/**
+ * Offer a frame from an input
+ * @return true if the frame should be forwarded to the receiver
+ */
+bool rtcm_merge_offer(rtcm_merge_t *m, int input, const rtcm3_frame_t *frame, int64_t now_ms);
+
+#endif // RTCM_MERGE_H
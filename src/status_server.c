@@ -0,0 +1,459 @@
+/**
+ * Status Server - Live position on the LAN, no dashboard needed
+ *
+ * One task, one select() loop over the listening socket and a handful of
+ * client slots, all non-blocking. The rover loop only ever touches a
+ * one-slot overwrite queue, so a browser on a poor WiFi link can never
+ * hold it up.
+ *
+ * Each epoch is serialized once into a shared event buffer and written
+ * to every subscriber from there. A subscriber that hasn't taken the
+ * previous event yet holds the next one back (newer epochs just replace
+ * it in the queue); one that stays stuck for STATUS_STALL_MS is dropped
+ * so it can't hold back the others for long.
+ *
+ * A /metrics scrape goes out through the same client buffer, refilled
+ * from metrics_render() each time it drains, until the cursor runs out.
+ */
+
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "status_server.h"
+#include "fixed_format.h"
+#include "metrics.h"
+#include "config.h"
+
+static const char *TAG = "status_srv";
+
+#ifndef STATUS_SERVER_PORT
+#define STATUS_SERVER_PORT 80
+#endif
+#ifndef STATUS_SERVER_MAX_CLIENTS
+#define STATUS_SERVER_MAX_CLIENTS 4
+#endif
+
+#define STATUS_TASK_STACK     4096
+#define STATUS_REQ_MAX        512     // Request head; reused for the response header
+#define STATUS_EVENT_MAX      256
+#define STATUS_POLL_MS        50      // select() timeout, bounds event latency
+#define STATUS_REQ_TIMEOUT_MS 5000    // Whole request head must arrive in this time
+#define STATUS_STALL_MS       3000    // Longest a client may sit on unsent output
+
+typedef struct {
+    int sock;                       // -1 = free slot
+    bool sse;                       // Subscribed to /events
+    bool metrics;                   // Sending a /metrics scrape
+    bool responded;                 // Request handled, further input ignored
+    bool close_after;               // Close once the response is out
+    char req[STATUS_REQ_MAX];
+    size_t req_len;
+    const char *seg[2];             // Output still to send, in order
+    size_t seg_len[2];
+    int64_t since_ms;               // Connected, or output pending since
+    metrics_cursor_t cursor;        // Scrape progress
+} client_t;
+
+static int s_listen = -1;
+static client_t s_clients[STATUS_SERVER_MAX_CLIENTS];
+static QueueHandle_t s_mailbox = NULL;      // Latest epoch, overwritten
+static char s_event[STATUS_EVENT_MAX];
+static status_server_stats_t s_stats;       // Rover task writes superseded only
+
+static const char s_page[] =
+    "<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+    "<meta name=\"viewport\" content=\"width=device-width\"><title>RTK Rover</title>"
+    "<style>body{font:16px monospace;margin:1em}td{padding:2px 1em 2px 0}"
+    "#fix{font-weight:bold}</style></head><body><h3>RTK Rover</h3><table>"
+    "<tr><td>Time</td><td id=\"time\">-</td></tr>"
+    "<tr><td>Fix</td><td id=\"fix\">-</td></tr>"
+    "<tr><td>Lat</td><td id=\"lat\">-</td></tr>"
+    "<tr><td>Lon</td><td id=\"lon\">-</td></tr>"
+    "<tr><td>Alt (m)</td><td id=\"alt\">-</td></tr>"
+    "<tr><td>hAcc/vAcc (m)</td><td id=\"acc\">-</td></tr>"
+    "<tr><td>Sats</td><td id=\"sats\">-</td></tr>"
+    "<tr><td>Corr age (s)</td><td id=\"age\">-</td></tr>"
+    "</table><p id=\"st\">connecting...</p><script>"
+    "var $=function(i){return document.getElementById(i)},es=new EventSource('/events');"
+    "es.onopen=function(){$('st').textContent='live'};"
+    "es.onerror=function(){$('st').textContent='reconnecting...'};"
+    "es.onmessage=function(e){var d=JSON.parse(e.data);"
+    "$('time').textContent=d.time+' UTC';$('fix').textContent=d.fix;"
+    "$('lat').textContent=d.lat;$('lon').textContent=d.lon;$('alt').textContent=d.alt;"
+    "$('acc').textContent=d.h_acc+' / '+d.v_acc;$('sats').textContent=d.sats;"
+    "$('age').textContent=d.corr_age===null?'none':d.corr_age};"
+    "</script></body></html>";
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static bool pending(const client_t *c)
+{
+    return c->seg_len[0] > 0 || c->seg_len[1] > 0;
+}
+
+static void close_client(client_t *c)
+{
+    if (c->sse) {
+        s_stats.subscribers--;
+    }
+    close(c->sock);
+    c->sock = -1;
+    c->sse = false;
+}
+
+static void start_output(client_t *c, const char *a, size_t a_len,
+                         const char *b, size_t b_len, int64_t now)
+{
+    c->seg[0] = a;
+    c->seg_len[0] = a_len;
+    c->seg[1] = b;
+    c->seg_len[1] = b_len;
+    c->since_ms = now;
+}
+
+/**
+ * Send as much pending output as the socket takes
+ */
+static void flush_client(client_t *c, int64_t now)
+{
+    while (pending(c)) {
+        int i = c->seg_len[0] > 0 ? 0 : 1;
+        int sent = send(c->sock, c->seg[i], c->seg_len[i], MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_client(c);
+            }
+            return;
+        }
+        s_stats.bytes_sent += sent;
+        c->seg[i] += sent;
+        c->seg_len[i] -= sent;
+
+        if (!pending(c) && c->metrics) {
+            // Drained - render the next lines into the same buffer
+            size_t len = metrics_render(&c->cursor, c->req, sizeof(c->req));
+            if (len > 0) {
+                start_output(c, c->req, len, NULL, 0, now);
+            }
+        }
+    }
+    if (c->close_after) {
+        close_client(c);
+    }
+}
+
+/**
+ * Build a response header in the client's request buffer
+ * Without a content_len the body runs until the connection closes
+ * (or forever, for /events).
+ */
+static size_t header(client_t *c, const char *status, const char *type, size_t content_len)
+{
+    fmt_writer_t w;
+    fmt_init(&w, c->req, sizeof(c->req));
+    fmt_str(&w, "HTTP/1.1 ");
+    fmt_str(&w, status);
+    fmt_str(&w, "\r\nContent-Type: ");
+    fmt_str(&w, type);
+    if (content_len > 0) {
+        fmt_str(&w, "\r\nContent-Length: ");
+        fmt_uint(&w, (uint32_t)content_len, 1);
+        fmt_str(&w, "\r\nConnection: close\r\n\r\n");
+    } else if (!c->sse) {
+        fmt_str(&w, "\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n");
+    } else {
+        fmt_str(&w, "\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\nretry: 2000\n\n");
+    }
+    int len = fmt_finish(&w);
+    return len < 0 ? 0 : (size_t)len;
+}
+
+static void handle_request(client_t *c, int64_t now)
+{
+    s_stats.requests++;
+    c->responded = true;
+
+    const char *path = c->req + 4;
+    size_t path_len = strcspn(path, " \r\n");
+    bool get = strncmp(c->req, "GET ", 4) == 0;
+
+    if (get && path_len == 7 && strncmp(path, "/events", 7) == 0) {
+        c->sse = true;
+        s_stats.subscribers++;
+        if (s_stats.subscribers > s_stats.max_subscribers) {
+            s_stats.max_subscribers = s_stats.subscribers;
+        }
+        start_output(c, c->req, header(c, "200 OK", "text/event-stream", 0), NULL, 0, now);
+    } else if (get && path_len == 8 && strncmp(path, "/metrics", 8) == 0) {
+        c->metrics = true;
+        c->close_after = true;
+        s_stats.scrapes++;
+        metrics_cursor_init(&c->cursor);
+        start_output(c, c->req, header(c, "200 OK", "text/plain; version=0.0.4", 0), NULL, 0, now);
+    } else if (get && ((path_len == 1 && path[0] == '/') ||
+                       (path_len == 11 && strncmp(path, "/index.html", 11) == 0))) {
+        c->close_after = true;
+        size_t len = header(c, "200 OK", "text/html", sizeof(s_page) - 1);
+        start_output(c, c->req, len, s_page, sizeof(s_page) - 1, now);
+    } else {
+        static const char not_found[] = "Not found\n";
+        c->close_after = true;
+        size_t len = header(c, get ? "404 Not Found" : "405 Method Not Allowed",
+                            "text/plain", sizeof(not_found) - 1);
+        start_output(c, c->req, len, not_found, sizeof(not_found) - 1, now);
+    }
+    flush_client(c, now);
+}
+
+static void read_client(client_t *c, int64_t now)
+{
+    if (c->responded) {
+        // Nothing more is expected; this only notices the peer closing
+        char scratch[64];
+        int r = recv(c->sock, scratch, sizeof(scratch), MSG_DONTWAIT);
+        if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close_client(c);
+        }
+        return;
+    }
+
+    int r = recv(c->sock, c->req + c->req_len, sizeof(c->req) - 1 - c->req_len, MSG_DONTWAIT);
+    if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        close_client(c);
+        return;
+    }
+    if (r < 0) {
+        return;
+    }
+    c->req_len += r;
+    c->req[c->req_len] = '\0';
+    if (strstr(c->req, "\r\n\r\n") != NULL) {
+        handle_request(c, now);
+    } else if (c->req_len >= sizeof(c->req) - 1) {
+        close_client(c);    // Head too large for anything this server serves
+    }
+}
+
+static void accept_client(int64_t now)
+{
+    int sock = accept(s_listen, NULL, NULL);
+    if (sock < 0) {
+        return;
+    }
+
+    client_t *c = NULL;
+    for (int i = 0; i < STATUS_SERVER_MAX_CLIENTS; i++) {
+        if (s_clients[i].sock < 0) {
+            c = &s_clients[i];
+            break;
+        }
+    }
+    if (c == NULL) {
+        s_stats.rejected++;
+        close(sock);
+        return;
+    }
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    memset(c, 0, sizeof(*c));
+    c->sock = sock;
+    c->since_ms = now;
+}
+
+/**
+ * Serialize the latest epoch once and start it on every subscriber
+ */
+static void publish_event(int64_t now)
+{
+    for (int i = 0; i < STATUS_SERVER_MAX_CLIENTS; i++) {
+        if (s_clients[i].sock >= 0 && s_clients[i].sse && pending(&s_clients[i])) {
+            return;     // Still on the previous event; newer epochs wait in the mailbox
+        }
+    }
+
+    zed_position_t pos;
+    if (xQueueReceive(s_mailbox, &pos, 0) != pdTRUE) {
+        return;
+    }
+
+    fmt_writer_t w;
+    fmt_init(&w, s_event, sizeof(s_event));
+    fmt_str(&w, "data: {\"time\":\"");
+    fmt_uint(&w, pos.hour, 2);
+    fmt_char(&w, ':');
+    fmt_uint(&w, pos.min, 2);
+    fmt_char(&w, ':');
+    fmt_uint(&w, pos.sec, 2);
+    fmt_str(&w, "\",\"fix\":\"");
+    fmt_str(&w, zed_rover_fix_type_str(pos.fix_type, pos.carr_soln));
+    fmt_str(&w, "\",\"lat\":");
+    fmt_fixed64(&w, (int64_t)pos.lat_e7 * 100 + pos.lat_hp, 9);
+    fmt_str(&w, ",\"lon\":");
+    fmt_fixed64(&w, (int64_t)pos.lon_e7 * 100 + pos.lon_hp, 9);
+    fmt_str(&w, ",\"alt\":");
+    fmt_fixed64(&w, (int64_t)pos.alt_mm * 10 + pos.alt_hp, 4);
+    fmt_str(&w, ",\"h_acc\":");
+    fmt_fixed64(&w, pos.h_acc_mm, 3);
+    fmt_str(&w, ",\"v_acc\":");
+    fmt_fixed64(&w, pos.v_acc_mm, 3);
+    fmt_str(&w, ",\"sats\":");
+    fmt_uint(&w, pos.num_sv, 1);
+    fmt_str(&w, ",\"corr_age\":");
+    if (pos.corr_age_s == ZED_CORR_AGE_UNKNOWN) {
+        fmt_str(&w, "null");
+    } else {
+        fmt_uint(&w, pos.corr_age_s == ZED_CORR_AGE_OVER_120S ? 120 : pos.corr_age_s, 1);
+    }
+    fmt_str(&w, "}\n\n");
+    int len = fmt_finish(&w);
+    if (len < 0) {
+        return;
+    }
+    s_stats.events++;
+
+    for (int i = 0; i < STATUS_SERVER_MAX_CLIENTS; i++) {
+        client_t *c = &s_clients[i];
+        if (c->sock >= 0 && c->sse) {
+            start_output(c, s_event, len, NULL, 0, now);
+            flush_client(c, now);
+        }
+    }
+}
+
+static void status_server_task(void *arg)
+{
+    while (1) {
+        fd_set rfds, wfds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        FD_SET(s_listen, &rfds);
+        int max_fd = s_listen;
+        for (int i = 0; i < STATUS_SERVER_MAX_CLIENTS; i++) {
+            client_t *c = &s_clients[i];
+            if (c->sock < 0) {
+                continue;
+            }
+            FD_SET(c->sock, &rfds);
+            if (pending(c)) {
+                FD_SET(c->sock, &wfds);
+            }
+            if (c->sock > max_fd) {
+                max_fd = c->sock;
+            }
+        }
+
+        struct timeval tv = { .tv_sec = 0, .tv_usec = STATUS_POLL_MS * 1000 };
+        int ready = select(max_fd + 1, &rfds, &wfds, NULL, &tv);
+        int64_t now = now_ms();
+
+        for (int i = 0; i < STATUS_SERVER_MAX_CLIENTS; i++) {
+            client_t *c = &s_clients[i];
+            if (c->sock < 0) {
+                continue;
+            }
+            if (ready > 0 && FD_ISSET(c->sock, &rfds)) {
+                read_client(c, now);
+            }
+            if (c->sock >= 0 && ready > 0 && FD_ISSET(c->sock, &wfds)) {
+                flush_client(c, now);
+            }
+            if (c->sock < 0) {
+                continue;
+            }
+            if (pending(c) && now - c->since_ms > STATUS_STALL_MS) {
+                if (c->sse) {
+                    s_stats.slow_closed++;
+                }
+                close_client(c);
+            } else if (!c->responded && now - c->since_ms > STATUS_REQ_TIMEOUT_MS) {
+                close_client(c);
+            }
+        }
+
+        // After the client loop, so a new socket is never checked against this round's sets
+        if (ready > 0 && FD_ISSET(s_listen, &rfds)) {
+            accept_client(now);
+        }
+
+        publish_event(now);
+    }
+}
+
+esp_err_t status_server_init(void)
+{
+    for (int i = 0; i < STATUS_SERVER_MAX_CLIENTS; i++) {
+        s_clients[i].sock = -1;
+    }
+
+    s_mailbox = xQueueCreate(1, sizeof(zed_position_t));
+    if (s_mailbox == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s_listen < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    int reuse = 1;
+    setsockopt(s_listen, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(STATUS_SERVER_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(s_listen, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(s_listen, 2) != 0) {
+        ESP_LOGE(TAG, "Failed to listen on port %d: errno %d", STATUS_SERVER_PORT, errno);
+        close(s_listen);
+        s_listen = -1;
+        return ESP_FAIL;
+    }
+    int flags = fcntl(s_listen, F_GETFL, 0);
+    fcntl(s_listen, F_SETFL, flags | O_NONBLOCK);
+
+    if (xTaskCreate(status_server_task, "status_srv", STATUS_TASK_STACK, NULL, 3, NULL) != pdPASS) {
+        close(s_listen);
+        s_listen = -1;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Status page on port %d (%d clients)", STATUS_SERVER_PORT, STATUS_SERVER_MAX_CLIENTS);
+    return ESP_OK;
+}
+
+void status_server_publish(const zed_position_t *pos)
+{
+    if (s_mailbox == NULL || pos == NULL || s_stats.subscribers == 0) {
+        return;
+    }
+    if (uxQueueMessagesWaiting(s_mailbox) > 0) {
+        s_stats.superseded++;
+    }
+    xQueueOverwrite(s_mailbox, pos);
+}
+
+void status_server_get_stats(status_server_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+}
@@ -0,0 +1,50 @@
+/**
+ * Status Server - Live position on the LAN, no dashboard needed
+ *
+ * A small HTTP server on its own task:
+ *   GET /        Status page (from flash) that shows the live position
+ *   GET /events  Server-Sent Events stream, one "data:" event per epoch
+ *   GET /metrics Performance counters in Prometheus text format
+ */
+
+#ifndef STATUS_SERVER_H
+#define STATUS_SERVER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "zed_rover.h"
+
+/**
+ * Server statistics
+ */
+typedef struct {
+    uint32_t subscribers;           // Connected /events streams
+    uint32_t max_subscribers;
+    uint32_t requests;
+    uint32_t scrapes;               // /metrics responses started
+    uint32_t rejected;              // Connections refused, all slots busy
+    uint32_t events;                // Epochs serialized (once each, for all subscribers)
+    uint32_t superseded;            // Epochs replaced by a newer one before they were sent
+    uint32_t slow_closed;           // Subscribers dropped for not keeping up
+    uint32_t bytes_sent;
+} status_server_stats_t;
+
+/**
+ * Start listening on STATUS_SERVER_PORT
+ */
+esp_err_t status_server_init(void);
+
+/**
+ * Hand over the latest epoch - O(1) and never blocks
+ * Only the newest epoch is kept; if the server hasn't sent the previous
+ * one yet it is replaced.
+ */
+void status_server_publish(const zed_position_t *pos);
+
+/**
+ * Get server statistics
+ */
+void status_server_get_stats(status_server_stats_t *stats);
+
+#endif // STATUS_SERVER_H
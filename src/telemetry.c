@@ -0,0 +1,384 @@
+/**
+ * Telemetry - Dashboard uplink on its own task
+ *
+ * The queue is a single-producer/single-consumer ring (rover loop in,
+ * telemetry task out). To drop the oldest snapshot when full, the producer
+ * also advances the tail, so both sides move the tail with compare-and-
+ * swap. The consumer copies a slot first and then claims it; if the
+ * producer dropped (and possibly rewrote) that slot in the meantime the
+ * claim fails and the copy is discarded, so a torn snapshot is never used.
+ *
+ * Every snapshot goes into the dashboard batch, which is sent once its
+ * oldest sample has waited DASHBOARD_REPORT_INTERVAL_MS (longer when the
+ * link budget spaces samples out), or earlier when it fills up. Uploads
+ * are pipelined (see dashboard_client.c); between snapshots the task
+ * collects the responses.
+ *
+ * Batches that aren't delivered - not sent, refused with an error status,
+ * or lost with the connection - are kept in flash (telemetry_store.c).
+ * Once the server accepts live batches again, the backlog is sent in
+ * requests of up to TELEMETRY_BACKFILL_MAX_BYTES, one at a time and only
+ * while no live batch is waiting for its response, so the live stream is
+ * never queued behind more than one of them. Backfill waits for an
+ * unmetered network.
+ *
+ * With MQTT_ENABLED the same snapshots are published one by one over MQTT
+ * instead (see mqtt_uplink.c), with fix changes and a periodic status as
+ * QoS 1 events; the store and backfill work the same way.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "telemetry.h"
+#include "dashboard_client.h"
+#include "mqtt_uplink.h"
+#include "telemetry_store.h"
+#include "link_budget.h"
+#include "wifi.h"
+#include "ota_update.h"
+#include "esp_system.h"
+#include "config.h"
+
+static const char *TAG = "telemetry";
+
+#define TELEMETRY_TASK_STACK    6144  // JSON + request buffers and float printf
+#define TELEMETRY_TASK_PRIORITY 3     // Below the rover loop
+#define TELEMETRY_POLL_MS       100   // Response wait while new snapshots may arrive
+#define TELEMETRY_BACKFILL_GAP_MS    200   // Pause between backfill requests
+#define TELEMETRY_BACKFILL_RETRY_MS  10000 // Pause after a failed backfill request
+#define TELEMETRY_BACKFILL_MAX_BYTES 4096  // ~16 stored pages, ~200 samples
+#define TELEMETRY_STATUS_INTERVAL_MS 60000 // MQTT status event
+#define TELEMETRY_EVENT_MAX          192
+
+#ifndef DASHBOARD_REPORT_INTERVAL_MS
+#define DASHBOARD_REPORT_INTERVAL_MS 1000
+#endif
+
+typedef struct {
+    zed_position_t pos;
+    uint32_t rtcm_bytes;
+    uint32_t fixed_count;
+    uint32_t float_count;
+    int battery_percentage;
+    int64_t enqueued_us;
+} telemetry_sample_t;
+
+static telemetry_sample_t s_ring[TELEMETRY_QUEUE_LEN];
+static uint32_t s_head = 0;     // Written by the producer only
+static uint32_t s_tail = 0;     // Advanced by both, always with CAS
+
+static TaskHandle_t s_task = NULL;
+static telemetry_stats_t s_stats;  // Each field has a single writer
+
+static bool s_uplink_ok = false;          // Last live batch was sent
+static int64_t s_next_backfill_us = 0;
+static uint8_t s_backfill_buf[TELEMETRY_BACKFILL_MAX_BYTES];
+#if MQTT_ENABLED
+static uint8_t s_last_carr_soln = 0xFF;   // For fix change events
+static int64_t s_next_status_us = 0;
+#endif
+
+/**
+ * Take the oldest snapshot (consumer side)
+ */
+static bool queue_pop(telemetry_sample_t *out)
+{
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    while (true) {
+        uint32_t head = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+        if (tail == head) {
+            return false;
+        }
+        memcpy(out, &s_ring[tail & (TELEMETRY_QUEUE_LEN - 1)], sizeof(*out));
+        // On failure tail is reloaded and the copy is retried
+        if (__atomic_compare_exchange_n(&s_tail, &tail, tail + 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+    }
+}
+
+bool telemetry_enqueue(const zed_position_t *pos,
+                       uint32_t rtcm_bytes,
+                       uint32_t fixed_count,
+                       uint32_t float_count,
+                       int battery_percentage)
+{
+    if (pos == NULL) {
+        return false;
+    }
+
+    bool dropped = false;
+    uint32_t head = s_head;
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= TELEMETRY_QUEUE_LEN) {
+        // Full: drop the oldest. If the CAS fails the consumer just took it.
+        if (__atomic_compare_exchange_n(&s_tail, &tail, tail + 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            s_stats.dropped++;
+            dropped = true;
+        }
+    }
+
+    telemetry_sample_t *slot = &s_ring[head & (TELEMETRY_QUEUE_LEN - 1)];
+    slot->pos = *pos;
+    slot->rtcm_bytes = rtcm_bytes;
+    slot->fixed_count = fixed_count;
+    slot->float_count = float_count;
+    slot->battery_percentage = battery_percentage;
+    slot->enqueued_us = esp_timer_get_time();
+    __atomic_store_n(&s_head, head + 1, __ATOMIC_RELEASE);
+
+    s_stats.enqueued++;
+    uint32_t depth = head + 1 - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    if (depth > s_stats.max_depth) {
+        s_stats.max_depth = depth;
+    }
+
+    if (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+    return !dropped;
+}
+
+void telemetry_make_record(telemetry_record_t *rec, const zed_position_t *pos,
+                           uint32_t rtcm_bytes, uint32_t fixed_count,
+                           uint32_t float_count, int battery_percentage)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->lat_e7 = pos->lat_e7;
+    rec->lon_e7 = pos->lon_e7;
+    rec->alt_mm = pos->alt_mm;
+    rec->h_acc_mm = pos->h_acc_mm > INT32_MAX ? INT32_MAX : (int32_t)pos->h_acc_mm;  // 0xFFFFFFFF before a fix
+    rec->v_acc_mm = pos->v_acc_mm > INT32_MAX ? INT32_MAX : (int32_t)pos->v_acc_mm;
+    rec->tod_s = pos->hour * 3600 + pos->min * 60 + pos->sec;
+    rec->rtcm_bytes = rtcm_bytes;
+    rec->fixed_count = fixed_count;
+    rec->float_count = float_count;
+    rec->battery_pct = (int8_t)battery_percentage;
+    rec->fix_type = pos->fix_type;
+    rec->carr_soln = pos->carr_soln;
+    rec->num_sv = pos->num_sv;
+    strncpy(rec->firmware_version, ota_get_version(), sizeof(rec->firmware_version) - 1);
+}
+
+/**
+ * How long the oldest batched sample may wait before the batch is sent
+ */
+static uint32_t flush_deadline_ms(void)
+{
+    uint32_t spacing = link_budget_telemetry_spacing_ms();
+    return spacing > DASHBOARD_REPORT_INTERVAL_MS ? spacing : DASHBOARD_REPORT_INTERVAL_MS;
+}
+
+#if !MQTT_ENABLED
+static void flush_batch(int64_t oldest_us)
+{
+    s_uplink_ok = dashboard_flush() == ESP_OK;
+    if (!s_uplink_ok) {
+        s_stats.failed++;
+        return;
+    }
+    telemetry_store_sync();  // Commit a partly filled page so it can be backfilled
+    uint32_t latency = (uint32_t)((esp_timer_get_time() - oldest_us) / 1000);
+    s_stats.batches++;
+    s_stats.last_latency_ms = latency;
+    if (latency > s_stats.max_latency_ms) {
+        s_stats.max_latency_ms = latency;
+    }
+}
+#endif
+
+#if MQTT_ENABLED
+/**
+ * Publish a snapshot, with an event if the fix quality changed
+ */
+static void publish_sample(const telemetry_sample_t *sample)
+{
+    telemetry_record_t rec;
+    telemetry_make_record(&rec, &sample->pos, sample->rtcm_bytes, sample->fixed_count,
+                          sample->float_count, sample->battery_percentage);
+
+    char event[TELEMETRY_EVENT_MAX];
+    if (rec.carr_soln != s_last_carr_soln) {
+        snprintf(event, sizeof(event),
+                 "{\"event\":\"carr_soln\",\"from\":%d,\"to\":%d,\"num_sv\":%d,\"tod\":%ld}",
+                 s_last_carr_soln == 0xFF ? -1 : s_last_carr_soln, rec.carr_soln, rec.num_sv,
+                 (long)rec.tod_s);
+        mqtt_uplink_publish_event(event);
+        s_last_carr_soln = rec.carr_soln;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now >= s_next_status_us) {
+        telemetry_store_stats_t store;
+        telemetry_store_get_stats(&store);
+        snprintf(event, sizeof(event),
+                 "{\"event\":\"status\",\"uptime_s\":%lu,\"free_heap\":%lu,"
+                 "\"battery_pct\":%d,\"queue_dropped\":%lu,\"stored_pages\":%lu,"
+                 "\"firmware_version\":\"%s\"}",
+                 (unsigned long)(now / 1000000), (unsigned long)esp_get_free_heap_size(),
+                 rec.battery_pct, (unsigned long)s_stats.dropped,
+                 (unsigned long)store.pages_pending, rec.firmware_version);
+        mqtt_uplink_publish_event(event);
+        s_next_status_us = now + (int64_t)TELEMETRY_STATUS_INTERVAL_MS * 1000;
+    }
+
+    s_uplink_ok = mqtt_uplink_publish_position(&rec) == ESP_OK;
+    if (!s_uplink_ok) {
+        s_stats.failed++;
+        telemetry_store_append(&rec, 1);
+        return;
+    }
+    telemetry_store_sync();
+    uint32_t latency = (uint32_t)((now - sample->enqueued_us) / 1000);
+    s_stats.batches++;
+    s_stats.last_latency_ms = latency;
+    if (latency > s_stats.max_latency_ms) {
+        s_stats.max_latency_ms = latency;
+    }
+}
+#endif
+
+static telemetry_backfill_t backfill_result(void)
+{
+#if MQTT_ENABLED
+    return mqtt_uplink_backfill_result();
+#else
+    return dashboard_backfill_result();
+#endif
+}
+
+static esp_err_t send_backfill(const uint8_t *body, size_t len)
+{
+#if MQTT_ENABLED
+    return mqtt_uplink_send_backfill(body, len);
+#else
+    return dashboard_send_backfill(body, len);
+#endif
+}
+
+static bool backfill_wanted(void)
+{
+#if !MQTT_ENABLED
+    // Sent isn't enough - the server must have accepted the last batch
+    if (!dashboard_uplink_ok()) {
+        return false;
+    }
+#endif
+    return s_uplink_ok && telemetry_store_pending() && !wifi_is_metered();
+}
+
+/**
+ * Collect the outcome of the last backfill request and send the next one
+ */
+static void backfill(void)
+{
+    int64_t now = esp_timer_get_time();
+    switch (backfill_result()) {
+    case TELEMETRY_BACKFILL_IN_FLIGHT:
+        return;
+    case TELEMETRY_BACKFILL_DONE:
+        telemetry_store_ack();
+        break;
+    case TELEMETRY_BACKFILL_FAILED:
+        s_stats.backfill_failed++;
+        s_next_backfill_us = now + (int64_t)TELEMETRY_BACKFILL_RETRY_MS * 1000;
+        return;
+    default:
+        break;
+    }
+
+    if (!backfill_wanted() || now < s_next_backfill_us || dashboard_poll(0) > 0) {
+        return;
+    }
+    size_t len = telemetry_store_peek(s_backfill_buf, sizeof(s_backfill_buf));
+    if (len > 0 && send_backfill(s_backfill_buf, len) == ESP_OK) {
+        s_stats.backfilled++;
+        s_next_backfill_us = now + (int64_t)TELEMETRY_BACKFILL_GAP_MS * 1000;
+    }
+}
+
+static void telemetry_task(void *pvParameters)
+{
+    telemetry_sample_t sample;
+    int64_t oldest_us = 0;     // Enqueue time of the first sample in the batch
+
+    while (1) {
+        // Sleep until a snapshot arrives or the batch is due, collecting
+        // responses meanwhile if any are outstanding
+        uint32_t wait_ms = UINT32_MAX;
+        if (dashboard_batch_count() > 0) {
+            int64_t due_us = oldest_us + (int64_t)flush_deadline_ms() * 1000;
+            int64_t left_us = due_us - esp_timer_get_time();
+            wait_ms = left_us > 0 ? (uint32_t)(left_us / 1000) : 0;
+        }
+        if (backfill_wanted() && wait_ms > TELEMETRY_BACKFILL_GAP_MS) {
+            wait_ms = TELEMETRY_BACKFILL_GAP_MS;
+        }
+        if (dashboard_poll(0) > 0) {
+            dashboard_poll(wait_ms < TELEMETRY_POLL_MS ? wait_ms : TELEMETRY_POLL_MS);
+            ulTaskNotifyTake(pdTRUE, 0);
+        } else {
+            ulTaskNotifyTake(pdTRUE, wait_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+        }
+
+#if MQTT_ENABLED
+        mqtt_uplink_poll();
+        while (queue_pop(&sample)) {
+            publish_sample(&sample);
+        }
+#else
+        while (queue_pop(&sample)) {
+            if (dashboard_batch_count() == 0) {
+                oldest_us = sample.enqueued_us;
+            }
+            if (dashboard_batch_count() >= DASHBOARD_BATCH_MAX_SAMPLES) {
+                flush_batch(oldest_us);  // Full - dashboard_add_position would flush anyway
+                oldest_us = sample.enqueued_us;
+            }
+            dashboard_add_position(&sample.pos, sample.rtcm_bytes,
+                                   sample.fixed_count, sample.float_count,
+                                   sample.battery_percentage);
+        }
+
+        if (dashboard_batch_count() > 0 &&
+            esp_timer_get_time() - oldest_us >= (int64_t)flush_deadline_ms() * 1000) {
+            flush_batch(oldest_us);
+        }
+#endif
+        backfill();
+    }
+}
+
+esp_err_t telemetry_init(void)
+{
+    telemetry_store_init();  // Without it, batches that can't be sent are dropped
+#if MQTT_ENABLED
+    if (mqtt_uplink_init() != ESP_OK) {
+        return ESP_FAIL;
+    }
+#endif
+
+    if (xTaskCreate(telemetry_task, "telemetry", TELEMETRY_TASK_STACK, NULL,
+                    TELEMETRY_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create telemetry task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void telemetry_get_stats(telemetry_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);  // Tail first: never past head
+    stats->depth = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE) - tail;
+}
@@ -0,0 +1,65 @@
+/**
+ * Telemetry - Dashboard uplink on its own task
+ *
+ * The rover loop hands every position epoch to a lock-free queue and
+ * carries on; a background task batches them and does the connect and POST.
+ * A slow or unreachable dashboard can then never hold up RTCM forwarding,
+ * and what couldn't be sent is stored in flash and backfilled later.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "zed_rover.h"
+#include "telemetry_codec.h"
+
+#define TELEMETRY_QUEUE_LEN 64  // Snapshots held while the uplink is busy (power of two)
+
+/**
+ * Uplink statistics
+ */
+typedef struct {
+    uint32_t enqueued;          // Snapshots handed over by the rover loop
+    uint32_t dropped;           // Oldest snapshots overwritten on a full queue
+    uint32_t batches;           // Batches sent
+    uint32_t failed;            // Batches that couldn't be sent
+    uint32_t depth;             // Snapshots waiting now
+    uint32_t max_depth;
+    uint32_t last_latency_ms;   // Oldest sample's enqueue to batch sent
+    uint32_t max_latency_ms;
+    uint32_t backfilled;        // Backfill requests sent
+    uint32_t backfill_failed;   // Backfill requests to be retried
+} telemetry_stats_t;
+
+/**
+ * Start the telemetry task
+ */
+esp_err_t telemetry_init(void);
+
+/**
+ * Queue a position snapshot for the dashboard
+ * O(1) and never blocks: on a full queue the oldest snapshot is dropped.
+ * @return false if a snapshot had to be dropped to make room
+ */
+bool telemetry_enqueue(const zed_position_t *pos,
+                       uint32_t rtcm_bytes,
+                       uint32_t fixed_count,
+                       uint32_t float_count,
+                       int battery_percentage);
+
+/**
+ * Convert a position snapshot to the record every transport sends
+ */
+void telemetry_make_record(telemetry_record_t *rec, const zed_position_t *pos,
+                           uint32_t rtcm_bytes, uint32_t fixed_count,
+                           uint32_t float_count, int battery_percentage);
+
+/**
+ * Get uplink statistics
+ */
+void telemetry_get_stats(telemetry_stats_t *stats);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,234 @@
+/**
+ * Telemetry Codec - Compact binary encoding of position samples
+ *
+ * Between two 1 Hz samples a rover moves centimetres, so deltas in the
+ * receiver's own units (1e-7 deg ~ 1 cm, mm) mostly fit one or two varint
+ * bytes; zigzag keeps small negative deltas small. Deltas are taken with
+ * unsigned wrap-around so any int32 pair round-trips exactly.
+ */
+
+#include <string.h>
+
+#include "telemetry_codec.h"
+#include "fixed_format.h"
+
+#define HDR_VERSION_MASK 0x0F
+#define HDR_KEYFRAME     0x10
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)((v >> 1) ^ (0u - (v & 1)));
+}
+
+static size_t put_varint(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * @return false if the varint is truncated or longer than 5 bytes
+ */
+static bool get_varint(const uint8_t *data, size_t len, size_t *pos, uint32_t *v)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t b = data[(*pos)++];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Signed fields in wire order, as offsets into telemetry_record_t
+static const size_t k_fields[] = {
+    offsetof(telemetry_record_t, lat_e7),
+    offsetof(telemetry_record_t, lon_e7),
+    offsetof(telemetry_record_t, alt_mm),
+    offsetof(telemetry_record_t, h_acc_mm),
+    offsetof(telemetry_record_t, v_acc_mm),
+    offsetof(telemetry_record_t, tod_s),
+    offsetof(telemetry_record_t, rtcm_bytes),
+    offsetof(telemetry_record_t, fixed_count),
+    offsetof(telemetry_record_t, float_count),
+};
+#define NUM_FIELDS (sizeof(k_fields) / sizeof(k_fields[0]))
+
+static uint32_t field(const telemetry_record_t *rec, size_t i)
+{
+    uint32_t v;
+    memcpy(&v, (const uint8_t *)rec + k_fields[i], sizeof(v));
+    return v;
+}
+
+static void set_field(telemetry_record_t *rec, size_t i, uint32_t v)
+{
+    memcpy((uint8_t *)rec + k_fields[i], &v, sizeof(v));
+}
+
+void telemetry_codec_reset(telemetry_codec_t *codec)
+{
+    memset(codec, 0, sizeof(*codec));
+}
+
+size_t telemetry_codec_encode(telemetry_codec_t *codec, const telemetry_record_t *rec, uint8_t *out)
+{
+    bool keyframe = !codec->have_prev ||
+                    codec->since_keyframe >= TELEMETRY_CODEC_KEYFRAME_INTERVAL;
+    const telemetry_record_t *base = &codec->prev;
+    size_t n = 0;
+
+    out[n++] = TELEMETRY_CODEC_VERSION | (keyframe ? HDR_KEYFRAME : 0);
+    n += put_varint(out + n, codec->seq);
+
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        uint32_t v = field(rec, i);
+        n += put_varint(out + n, zigzag((int32_t)(keyframe ? v : v - field(base, i))));
+    }
+    int32_t battery = keyframe ? rec->battery_pct : rec->battery_pct - base->battery_pct;
+    n += put_varint(out + n, zigzag(battery));
+
+    n += put_varint(out + n, (uint32_t)(rec->fix_type & 0x07) |
+                             (uint32_t)(rec->carr_soln & 0x03) << 3 |
+                             (uint32_t)rec->num_sv << 5);
+
+    if (keyframe) {
+        size_t vlen = strnlen(rec->firmware_version, TELEMETRY_CODEC_VERSION_MAX - 1);
+        out[n++] = (uint8_t)vlen;
+        memcpy(out + n, rec->firmware_version, vlen);
+        n += vlen;
+        codec->since_keyframe = 0;
+    }
+
+    codec->prev = *rec;
+    if (!keyframe) {
+        // Only sent with keyframes - carry it over for the decoder's benefit
+        memcpy(codec->prev.firmware_version, base->firmware_version,
+               sizeof(codec->prev.firmware_version));
+    }
+    codec->have_prev = true;
+    codec->seq++;
+    codec->since_keyframe++;
+    return n;
+}
+
+int telemetry_codec_format_json(const telemetry_record_t *rec, char *out, size_t size)
+{
+    // Same bytes as printf of the values in degrees/metres ("%.9f" of
+    // lat_e7 * 1e-7 is the 7 decimals plus "00"), without soft-float
+    fmt_writer_t w;
+    fmt_init(&w, out, size);
+    fmt_str(&w, "{\"latitude\":");
+    fmt_fixed(&w, rec->lat_e7, 7);
+    fmt_str(&w, "00,\"longitude\":");
+    fmt_fixed(&w, rec->lon_e7, 7);
+    fmt_str(&w, "00,\"altitude\":");
+    fmt_fixed(&w, rec->alt_mm, 3);
+    fmt_str(&w, ",\"h_acc\":");
+    fmt_fixed(&w, rec->h_acc_mm, 3);
+    fmt_str(&w, "0,\"v_acc\":");
+    fmt_fixed(&w, rec->v_acc_mm, 3);
+    fmt_str(&w, "0,\"fix_type\":");
+    fmt_uint(&w, rec->fix_type, 1);
+    fmt_str(&w, ",\"carr_soln\":");
+    fmt_uint(&w, rec->carr_soln, 1);
+    fmt_str(&w, ",\"num_sv\":");
+    fmt_uint(&w, rec->num_sv, 1);
+    fmt_str(&w, ",\"rtcm_bytes\":");
+    fmt_uint(&w, rec->rtcm_bytes, 1);
+    fmt_str(&w, ",\"fixed_count\":");
+    fmt_uint(&w, rec->fixed_count, 1);
+    fmt_str(&w, ",\"float_count\":");
+    fmt_uint(&w, rec->float_count, 1);
+    fmt_str(&w, ",\"hour\":");
+    fmt_int(&w, rec->tod_s / 3600);
+    fmt_str(&w, ",\"min\":");
+    fmt_int(&w, rec->tod_s / 60 % 60);
+    fmt_str(&w, ",\"sec\":");
+    fmt_int(&w, rec->tod_s % 60);
+    fmt_str(&w, ",\"battery_pct\":");
+    fmt_int(&w, rec->battery_pct);
+    fmt_str(&w, ",\"firmware_version\":\"");
+    fmt_str(&w, rec->firmware_version);
+    fmt_str(&w, "\"}");
+
+    int len = fmt_finish(&w);
+    return len >= 0 ? len : (int)size;
+}
+
+int telemetry_codec_decode(telemetry_codec_t *codec, const uint8_t *data, size_t len,
+                           telemetry_record_t *rec, size_t *consumed)
+{
+    if (len < 1 || (data[0] & HDR_VERSION_MASK) != TELEMETRY_CODEC_VERSION) {
+        return TELEMETRY_CODEC_ERR_MALFORMED;
+    }
+    bool keyframe = (data[0] & HDR_KEYFRAME) != 0;
+    size_t pos = 1;
+
+    uint32_t seq;
+    uint32_t raw[NUM_FIELDS + 2];
+    if (!get_varint(data, len, &pos, &seq)) {
+        return TELEMETRY_CODEC_ERR_MALFORMED;
+    }
+    for (size_t i = 0; i < NUM_FIELDS + 2; i++) {
+        if (!get_varint(data, len, &pos, &raw[i])) {
+            return TELEMETRY_CODEC_ERR_MALFORMED;
+        }
+    }
+
+    char version[TELEMETRY_CODEC_VERSION_MAX] = {0};
+    if (keyframe) {
+        if (pos >= len || data[pos] >= TELEMETRY_CODEC_VERSION_MAX || len - pos - 1 < data[pos]) {
+            return TELEMETRY_CODEC_ERR_MALFORMED;
+        }
+        memcpy(version, data + pos + 1, data[pos]);
+        pos += 1 + data[pos];
+    }
+    if (consumed != NULL) {
+        *consumed = pos;
+    }
+
+    if (!keyframe && (!codec->have_prev || seq != codec->seq)) {
+        codec->have_prev = false;  // Stay out of sync until the next keyframe
+        return TELEMETRY_CODEC_ERR_NEED_KEYFRAME;
+    }
+
+    telemetry_record_t out = keyframe ? (telemetry_record_t){0} : codec->prev;
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        uint32_t v = (uint32_t)unzigzag(raw[i]);
+        set_field(&out, i, keyframe ? v : field(&out, i) + v);
+    }
+    out.battery_pct = (int8_t)(keyframe ? unzigzag(raw[NUM_FIELDS])
+                                        : out.battery_pct + unzigzag(raw[NUM_FIELDS]));
+    uint32_t fix = raw[NUM_FIELDS + 1];
+    out.fix_type = fix & 0x07;
+    out.carr_soln = (fix >> 3) & 0x03;
+    out.num_sv = (uint8_t)(fix >> 5);
+    if (keyframe) {
+        memcpy(out.firmware_version, version, sizeof(out.firmware_version));
+    }
+
+    codec->prev = out;
+    codec->have_prev = true;
+    codec->seq = seq + 1;
+    if (rec != NULL) {
+        *rec = out;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * Telemetry Codec - Compact binary encoding of position samples
+ *
+ * Plain C with no ESP-IDF dependencies, so the same file serves as the
+ * reference decoder on the dashboard server (with fixed_format.c, for
+ * the JSON form of a sample - kept here so every transport sends the same
+ * fields).
+ *
+ * Sample layout (all integers are LEB128 varints, "s" = zigzag signed):
+ *
+ *   header   1 byte: bits 0-3 schema version, bit 4 keyframe
+ *   seq      Sample sequence number (wraps at 2^32)
+ *   lat      s  1e-7 deg      \
+ *   lon      s  1e-7 deg       |
+ *   alt      s  mm (MSL)       |  Keyframe: absolute value
+ *   h_acc    s  mm             |  Otherwise: difference from the
+ *   v_acc    s  mm             |  previous sample
+ *   tod      s  s of UTC day   |
+ *   rtcm     s  bytes          |
+ *   fixed    s  count          |
+ *   float    s  count          |
+ *   battery  s  %, -1 if none /
+ *   fix      fix_type | carr_soln << 3 | num_sv << 5  (absolute)
+ *   version  Keyframe only: length byte + firmware version string
+ *
+ * A delta sample can only be decoded right after its predecessor. The
+ * decoder rejects deltas after a sequence gap until the next keyframe;
+ * the encoder sends one every TELEMETRY_CODEC_KEYFRAME_INTERVAL samples
+ * and whenever it is reset.
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define TELEMETRY_CODEC_VERSION           1
+#define TELEMETRY_CODEC_KEYFRAME_INTERVAL 60
+#define TELEMETRY_CODEC_VERSION_MAX       16
+#define TELEMETRY_CODEC_MAX_SAMPLE        (1 + 5 + 10 * 5 + 3 + 1 + TELEMETRY_CODEC_VERSION_MAX)
+
+#define TELEMETRY_CODEC_ERR_MALFORMED     -1   // Truncated, bad varint or unknown schema
+#define TELEMETRY_CODEC_ERR_NEED_KEYFRAME -2   // Delta without its predecessor
+
+/**
+ * One sample in the units NAV-PVT reports
+ */
+typedef struct {
+    int32_t lat_e7;
+    int32_t lon_e7;
+    int32_t alt_mm;
+    int32_t h_acc_mm;
+    int32_t v_acc_mm;
+    int32_t tod_s;              // Seconds since 00:00 UTC
+    uint32_t rtcm_bytes;
+    uint32_t fixed_count;
+    uint32_t float_count;
+    int8_t battery_pct;         // -1 if unavailable
+    uint8_t fix_type;
+    uint8_t carr_soln;
+    uint8_t num_sv;
+    char firmware_version[TELEMETRY_CODEC_VERSION_MAX];
+} telemetry_record_t;
+
+/**
+ * Encoder/decoder state: the previous sample
+ */
+typedef struct {
+    telemetry_record_t prev;
+    uint32_t seq;
+    uint32_t since_keyframe;
+    bool have_prev;
+} telemetry_codec_t;
+
+/**
+ * Reset state; the next sample encoded is a keyframe
+ */
+void telemetry_codec_reset(telemetry_codec_t *codec);
+
+/**
+ * Encode a sample
+ * @param out Buffer of at least TELEMETRY_CODEC_MAX_SAMPLE bytes
+ * @return Bytes written
+ */
+size_t telemetry_codec_encode(telemetry_codec_t *codec, const telemetry_record_t *rec, uint8_t *out);
+
+/**
+ * Format a sample as the dashboard's JSON object
+ * Integer arithmetic only (see fixed_format.h).
+ * @return Length written, or size if the output was truncated
+ */
+int telemetry_codec_format_json(const telemetry_record_t *rec, char *out, size_t size);
+
+/**
+ * Decode one sample
+ * @param consumed Set to the sample's length whenever it is well-formed,
+ *                 including an unusable delta, so a stream can skip it
+ * @return 0 with rec filled, or TELEMETRY_CODEC_ERR_*
+ */
+int telemetry_codec_decode(telemetry_codec_t *codec, const uint8_t *data, size_t len,
+                           telemetry_record_t *rec, size_t *consumed);
+
+#endif // TELEMETRY_CODEC_H
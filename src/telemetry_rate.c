@@ -0,0 +1,162 @@
+/**
+ * Telemetry Rate - Change-driven cadence for the dashboard/MQTT uplink
+ *
+ * Movement is measured from the last epoch that was sent, so slow drift
+ * still gets reported once it adds up. The deadband never drops below the
+ * receiver's own accuracy estimate; otherwise a float or autonomous fix
+ * would report its noise as movement. Moving/static comes from NAV-PVT's
+ * gSpeed, with some hysteresis.
+ *
+ * Bytes per hour are measured from the uplink's byte counter, charged to
+ * whichever state the rover was in when they were sent. Uploads trail
+ * the epochs by up to a batch interval, which doesn't matter over an hour.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "esp_timer.h"
+
+#include "telemetry_rate.h"
+#include "link_budget.h"
+#include "config.h"
+
+#ifndef TELEMETRY_DEADBAND_MM
+#define TELEMETRY_DEADBAND_MM 50
+#endif
+#ifndef TELEMETRY_HEARTBEAT_MS
+#define TELEMETRY_HEARTBEAT_MS 30000
+#endif
+#ifndef TELEMETRY_MOVING_MM_S
+#define TELEMETRY_MOVING_MM_S 300
+#endif
+#ifndef TELEMETRY_MOVING_INTERVAL_MS
+#define TELEMETRY_MOVING_INTERVAL_MS 1000
+#endif
+#ifndef TELEMETRY_TURN_DEG
+#define TELEMETRY_TURN_DEG 10
+#endif
+
+#define MM_PER_E7_DEG       11.1319f    // 1e-7 degrees of latitude
+#define ACCOUNT_INTERVAL_MS 1000
+
+static bool s_have_sent = false;
+static zed_position_t s_sent;           // Last epoch queued
+static int64_t s_sent_ms = 0;
+static float s_east_scale = MM_PER_E7_DEG;  // mm per 1e-7 deg of longitude at s_sent
+
+static int64_t s_account_ms = 0;
+static uint32_t s_account_bytes = 0;
+static uint64_t s_ms[2];                // Static, moving
+static uint64_t s_bytes[2];
+
+static telemetry_rate_stats_t s_stats;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static uint8_t fix_state(const zed_position_t *pos)
+{
+    return pos->valid ? (uint8_t)(1 + pos->carr_soln) : 0;
+}
+
+/**
+ * Check if the position moved past the deadband since the last upload
+ */
+static bool moved(const zed_position_t *pos)
+{
+    if (!pos->valid || !s_sent.valid) {
+        return false;
+    }
+
+    float h_band = pos->h_acc_mm > TELEMETRY_DEADBAND_MM ? (float)pos->h_acc_mm : TELEMETRY_DEADBAND_MM;
+    float v_band = pos->v_acc_mm > TELEMETRY_DEADBAND_MM ? (float)pos->v_acc_mm : TELEMETRY_DEADBAND_MM;
+    float dn = (float)(pos->lat_e7 - s_sent.lat_e7) * MM_PER_E7_DEG;
+    float de = (float)(pos->lon_e7 - s_sent.lon_e7) * s_east_scale;
+    float du = (float)(pos->alt_mm - s_sent.alt_mm);
+    return dn * dn + de * de > h_band * h_band || fabsf(du) > v_band;
+}
+
+/**
+ * Check if the heading of motion turned past TELEMETRY_TURN_DEG
+ */
+static bool turned(const zed_position_t *pos)
+{
+    if (s_sent.g_speed_mm_s < TELEMETRY_MOVING_MM_S) {
+        return false;   // No meaningful heading to compare with
+    }
+    int32_t d = (pos->head_mot_e5 - s_sent.head_mot_e5) % 36000000;
+    if (d > 18000000) d -= 36000000;
+    if (d < -18000000) d += 36000000;
+    return (d < 0 ? -d : d) > TELEMETRY_TURN_DEG * 100000;
+}
+
+/**
+ * Charge elapsed time and uplink bytes to the current motion state
+ */
+static void account(int64_t now)
+{
+    uint32_t bytes = link_budget_telemetry_bytes();
+    if (s_account_ms != 0) {
+        int state = s_stats.moving ? 1 : 0;
+        s_ms[state] += (uint64_t)(now - s_account_ms);
+        s_bytes[state] += bytes - s_account_bytes;
+    }
+    s_account_ms = now;
+    s_account_bytes = bytes;
+}
+
+telemetry_rate_reason_t telemetry_rate_check(const zed_position_t *pos)
+{
+    int64_t now = now_ms();
+    s_stats.epochs++;
+
+    if (now - s_account_ms >= ACCOUNT_INTERVAL_MS) {
+        account(now);
+    }
+
+    // Hysteresis: moving above the threshold, static again below half of it
+    if (pos->valid && pos->g_speed_mm_s >= TELEMETRY_MOVING_MM_S) {
+        s_stats.moving = true;
+    } else if (!pos->valid || pos->g_speed_mm_s < TELEMETRY_MOVING_MM_S / 2) {
+        s_stats.moving = false;
+    }
+
+    telemetry_rate_reason_t reason;
+    if (!s_have_sent || fix_state(pos) != fix_state(&s_sent)) {
+        reason = TELEMETRY_RATE_FIX_CHANGE;
+        s_stats.fix_changes++;
+    } else if (moved(pos)) {
+        reason = TELEMETRY_RATE_MOVED;
+        s_stats.moved++;
+    } else if (s_stats.moving && turned(pos)) {
+        reason = TELEMETRY_RATE_TURN;
+        s_stats.turns++;
+    } else if (now - s_sent_ms >= (s_stats.moving ? TELEMETRY_MOVING_INTERVAL_MS : TELEMETRY_HEARTBEAT_MS)) {
+        reason = TELEMETRY_RATE_HEARTBEAT;
+        s_stats.heartbeats++;
+    } else {
+        reason = TELEMETRY_RATE_SKIP;
+    }
+
+    if (reason != TELEMETRY_RATE_SKIP) {
+        if (!s_have_sent || pos->lat_e7 != s_sent.lat_e7) {
+            s_east_scale = MM_PER_E7_DEG * cosf(pos->lat_e7 * 1e-7f * ((float)M_PI / 180.0f));
+        }
+        s_sent = *pos;
+        s_sent_ms = now;
+        s_have_sent = true;
+        s_stats.sent++;
+    }
+    return reason;
+}
+
+void telemetry_rate_get_stats(telemetry_rate_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->static_s = (uint32_t)(s_ms[0] / 1000);
+    stats->moving_s = (uint32_t)(s_ms[1] / 1000);
+    stats->static_bytes_per_hour = s_ms[0] > 0 ? (uint32_t)(s_bytes[0] * 3600000 / s_ms[0]) : 0;
+    stats->moving_bytes_per_hour = s_ms[1] > 0 ? (uint32_t)(s_bytes[1] * 3600000 / s_ms[1]) : 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * Telemetry Rate - Change-driven cadence for the dashboard/MQTT uplink
+ *
+ * A rover on a tripod produces the same position every epoch. Epochs are
+ * only queued for upload when something changed: the position moved past
+ * a deadband, the fix changed, or the heading turned while moving - plus
+ * a heartbeat that comes sooner while the rover is moving.
+ */
+
+#ifndef TELEMETRY_RATE_H
+#define TELEMETRY_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "zed_rover.h"
+
+/**
+ * Why an epoch is sent
+ */
+typedef enum {
+    TELEMETRY_RATE_SKIP = 0,        // Nothing changed - don't send
+    TELEMETRY_RATE_MOVED,
+    TELEMETRY_RATE_TURN,
+    TELEMETRY_RATE_FIX_CHANGE,
+    TELEMETRY_RATE_HEARTBEAT,
+} telemetry_rate_reason_t;
+
+/**
+ * Reporter statistics
+ */
+typedef struct {
+    uint32_t epochs;                // Epochs offered
+    uint32_t sent;                  // Of which passed on for upload
+    uint32_t moved;                 // Sent: moved past the deadband
+    uint32_t fix_changes;           // Sent: fix type/carrier solution changed
+    uint32_t turns;                 // Sent: heading changed while moving
+    uint32_t heartbeats;            // Sent: nothing changed, interval expired
+    bool moving;
+    uint32_t static_s;              // Time spent static / moving
+    uint32_t moving_s;
+    uint32_t static_bytes_per_hour; // Uplink bytes per hour in each state
+    uint32_t moving_bytes_per_hour;
+} telemetry_rate_stats_t;
+
+/**
+ * Decide whether to upload an epoch (call for every epoch)
+ * @return Reason to queue the epoch, or TELEMETRY_RATE_SKIP
+ */
+telemetry_rate_reason_t telemetry_rate_check(const zed_position_t *pos);
+
+/**
+ * Get reporter statistics
+ */
+void telemetry_rate_get_stats(telemetry_rate_stats_t *stats);
+
+#endif // TELEMETRY_RATE_H
@@ -0,0 +1,336 @@
+/**
+ * Telemetry Store - Flash-backed store-and-forward for dashboard samples
+ *
+ * The partition is an append-only ring of 256-byte pages, one flash page
+ * each, written in sequence order. A page holds a header and a
+ * telemetry_codec stream that starts with a keyframe, so every page
+ * decodes on its own:
+ *
+ *   magic     2 bytes
+ *   len       2 bytes  Payload length
+ *   seq       4 bytes  Page sequence number, +1 per page written
+ *   crc       4 bytes  CRC-32 of magic, len, seq and the payload
+ *   consumed  4 bytes  0xFFFFFFFF until uploaded, then cleared to 0 in place
+ *
+ * Nothing is ever rewritten except the consumed word, which NOR flash can
+ * clear without an erase. After a reset the log is recovered by scanning
+ * the page headers: the newest sequence number gives the write position,
+ * and a page torn by a power cut fails its CRC and is skipped. If power
+ * is lost between an upload and its acknowledgement, the pages are sent
+ * again rather than lost.
+ *
+ * When the write position enters a sector it is erased first, dropping
+ * the oldest pages if they were never uploaded. Writing round the ring
+ * erases every sector equally often, so wear is spread over the whole
+ * partition: each sector is erased once per ~15 h of 1 Hz samples stored,
+ * and only while the dashboard is unreachable.
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "telemetry_store.h"
+
+static const char *TAG = "telem_store";
+
+#define STORE_PARTITION_LABEL "spiffs"
+#define STORE_SECTOR_SIZE     4096
+#define STORE_PAGE_MAGIC      0x5354   // "TS"
+#define STORE_UNCONSUMED      0xFFFFFFFF
+
+typedef struct {
+    uint16_t magic;
+    uint16_t len;
+    uint32_t seq;
+    uint32_t crc;
+    uint32_t consumed;
+} page_hdr_t;
+
+#define STORE_PAGE_PAYLOAD     (TELEMETRY_STORE_PAGE_SIZE - sizeof(page_hdr_t))
+#define STORE_PAGES_PER_SECTOR (STORE_SECTOR_SIZE / TELEMETRY_STORE_PAGE_SIZE)
+
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_pages = 0;        // Pages in the partition
+static uint32_t s_head = 0;         // Next page to write
+static uint32_t s_seq = 0;          // Sequence number of the next page
+static uint32_t s_cursor = 0;       // Oldest page that may still be waiting
+static uint32_t s_erase_gen = 0;    // Bumped whenever waiting pages are erased
+
+// Pages returned by the last telemetry_store_peek()
+static uint32_t s_peek_pages = 0;
+static uint32_t s_peek_gen = 0;
+
+// Page being filled
+static uint8_t s_page[TELEMETRY_STORE_PAGE_SIZE];
+static size_t s_page_len = 0;
+static telemetry_codec_t s_codec;
+
+static telemetry_store_stats_t s_stats;
+
+static uint32_t next_page(uint32_t page)
+{
+    return (page + 1) % s_pages;
+}
+
+/**
+ * Pages from the cursor up to the write position
+ * When the ring is full the oldest waiting page is at the write position.
+ */
+static uint32_t waiting_span(void)
+{
+    uint32_t span = (s_head + s_pages - s_cursor) % s_pages;
+    return span == 0 && s_stats.pages_pending > 0 ? s_pages : span;
+}
+
+static uint32_t page_crc(const page_hdr_t *hdr, const uint8_t *payload)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)hdr, offsetof(page_hdr_t, crc));
+    return esp_rom_crc32_le(crc, payload, hdr->len);
+}
+
+static bool read_hdr(uint32_t page, page_hdr_t *hdr)
+{
+    return esp_partition_read(s_part, page * TELEMETRY_STORE_PAGE_SIZE, hdr, sizeof(*hdr)) == ESP_OK;
+}
+
+static bool is_waiting(const page_hdr_t *hdr)
+{
+    return hdr->magic == STORE_PAGE_MAGIC && hdr->consumed == STORE_UNCONSUMED &&
+           hdr->len <= STORE_PAGE_PAYLOAD;
+}
+
+static void mark_consumed(uint32_t page)
+{
+    uint32_t zero = 0;
+    esp_partition_write(s_part, page * TELEMETRY_STORE_PAGE_SIZE + offsetof(page_hdr_t, consumed),
+                        &zero, sizeof(zero));
+}
+
+/**
+ * Erase the sector the write position has just entered
+ */
+static void erase_sector(uint32_t page)
+{
+    uint32_t first = page - page % STORE_PAGES_PER_SECTOR;
+    uint32_t dropped = 0;
+    page_hdr_t hdr;
+    for (uint32_t p = first; p < first + STORE_PAGES_PER_SECTOR; p++) {
+        if (read_hdr(p, &hdr) && is_waiting(&hdr)) {
+            dropped++;
+        }
+    }
+
+    if (esp_partition_erase_range(s_part, first * TELEMETRY_STORE_PAGE_SIZE, STORE_SECTOR_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase sector at page %lu", (unsigned long)first);
+        return;
+    }
+    s_stats.sector_erases++;
+
+    if (dropped > 0) {
+        ESP_LOGW(TAG, "Store full - %lu pages dropped before upload", (unsigned long)dropped);
+        s_stats.pages_dropped += dropped;
+        s_stats.pages_pending -= dropped < s_stats.pages_pending ? dropped : s_stats.pages_pending;
+        s_erase_gen++;
+    }
+    if (s_cursor >= first && s_cursor < first + STORE_PAGES_PER_SECTOR) {
+        s_cursor = (first + STORE_PAGES_PER_SECTOR) % s_pages;
+    }
+}
+
+/**
+ * Write the page being filled and start a new one
+ */
+static void commit_page(void)
+{
+    if (s_page_len == 0 || s_part == NULL) {
+        return;
+    }
+    if (s_head % STORE_PAGES_PER_SECTOR == 0) {
+        erase_sector(s_head);
+    }
+
+    page_hdr_t hdr = {
+        .magic = STORE_PAGE_MAGIC,
+        .len = (uint16_t)s_page_len,
+        .seq = s_seq,
+        .consumed = STORE_UNCONSUMED,
+    };
+    uint8_t *payload = s_page + sizeof(hdr);
+    hdr.crc = page_crc(&hdr, payload);
+    memcpy(s_page, &hdr, sizeof(hdr));
+    memset(payload + s_page_len, 0xFF, STORE_PAGE_PAYLOAD - s_page_len);
+
+    if (esp_partition_write(s_part, s_head * TELEMETRY_STORE_PAGE_SIZE, s_page, sizeof(s_page)) == ESP_OK) {
+        if (s_stats.pages_pending == 0) {
+            s_cursor = s_head;
+        }
+        s_stats.pages_written++;
+        s_stats.pages_pending++;
+    } else {
+        ESP_LOGE(TAG, "Failed to write page %lu", (unsigned long)s_head);
+    }
+
+    // Skip the page even if the write failed - it may be partly programmed
+    s_head = next_page(s_head);
+    s_seq++;
+    s_page_len = 0;
+    telemetry_codec_reset(&s_codec);
+}
+
+esp_err_t telemetry_store_init(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                      STORE_PARTITION_LABEL);
+    if (s_part == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition - samples that can't be sent are dropped",
+                 STORE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_pages = s_part->size / STORE_SECTOR_SIZE * STORE_PAGES_PER_SECTOR;
+    telemetry_codec_reset(&s_codec);
+
+    // Find the newest page and count those still waiting
+    bool found = false;
+    uint32_t newest = 0;
+    page_hdr_t hdr;
+    for (uint32_t p = 0; p < s_pages; p++) {
+        if (!read_hdr(p, &hdr) || hdr.magic != STORE_PAGE_MAGIC) {
+            continue;
+        }
+        if (!found || (int32_t)(hdr.seq - s_seq) >= 0) {
+            newest = p;
+            s_seq = hdr.seq + 1;
+            found = true;
+        }
+        if (is_waiting(&hdr)) {
+            s_stats.pages_pending++;
+        }
+    }
+    s_head = found ? next_page(newest) : 0;
+
+    // Anything already at the write position (a torn write) can't be
+    // programmed over - continue from the next sector, which gets erased
+    static const uint8_t erased[sizeof(page_hdr_t)] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    };
+    if (s_head % STORE_PAGES_PER_SECTOR != 0 && read_hdr(s_head, &hdr) &&
+        memcmp(&hdr, erased, sizeof(hdr)) != 0) {
+        ESP_LOGW(TAG, "Damaged page at %lu, skipping to the next sector", (unsigned long)s_head);
+        s_head = (s_head - s_head % STORE_PAGES_PER_SECTOR + STORE_PAGES_PER_SECTOR) % s_pages;
+    }
+
+    // The oldest waiting page is the first one after the write position
+    s_cursor = s_head;
+    if (s_stats.pages_pending > 0) {
+        for (uint32_t i = 0, p = s_head; i < s_pages; i++, p = next_page(p)) {
+            if (read_hdr(p, &hdr) && is_waiting(&hdr)) {
+                s_cursor = p;
+                break;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "%lu KB store, %lu pages waiting for upload",
+             (unsigned long)(s_part->size / 1024), (unsigned long)s_stats.pages_pending);
+    return ESP_OK;
+}
+
+void telemetry_store_append(const telemetry_record_t *records, size_t count)
+{
+    if (s_part == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (s_page_len + TELEMETRY_CODEC_MAX_SAMPLE > STORE_PAGE_PAYLOAD) {
+            commit_page();
+        }
+        s_page_len += telemetry_codec_encode(&s_codec, &records[i],
+                                             s_page + sizeof(page_hdr_t) + s_page_len);
+        s_stats.samples_stored++;
+    }
+}
+
+void telemetry_store_sync(void)
+{
+    commit_page();
+}
+
+bool telemetry_store_pending(void)
+{
+    return s_stats.pages_pending > 0;
+}
+
+size_t telemetry_store_peek(uint8_t *buf, size_t max_len)
+{
+    size_t len = 0;
+    uint32_t p = s_cursor;
+    uint32_t pages = 0;
+    uint32_t span = s_part != NULL ? waiting_span() : 0;
+    uint8_t page[TELEMETRY_STORE_PAGE_SIZE];
+
+    while (pages < span) {
+        if (esp_partition_read(s_part, p * TELEMETRY_STORE_PAGE_SIZE, page, sizeof(page)) != ESP_OK) {
+            break;
+        }
+        page_hdr_t hdr;
+        memcpy(&hdr, page, sizeof(hdr));
+        if (is_waiting(&hdr)) {
+            if (hdr.crc != page_crc(&hdr, page + sizeof(hdr))) {
+                ESP_LOGW(TAG, "CRC error in page %lu, skipped", (unsigned long)p);
+                s_stats.crc_errors++;
+                mark_consumed(p);
+                s_stats.pages_pending--;
+            } else if (len + hdr.len > max_len) {
+                break;
+            } else {
+                memcpy(buf + len, page + sizeof(hdr), hdr.len);
+                len += hdr.len;
+            }
+        }
+        p = next_page(p);
+        pages++;
+    }
+
+    if (len == 0 && pages == span) {
+        s_stats.pages_pending = 0;   // Nothing left before the write position
+        s_cursor = s_head;
+    }
+    s_peek_pages = pages;
+    s_peek_gen = s_erase_gen;
+    return len;
+}
+
+void telemetry_store_ack(void)
+{
+    // If waiting pages were erased since the peek the cursor has moved on;
+    // whatever was sent and survived is just sent again
+    if (s_part == NULL || s_peek_gen != s_erase_gen) {
+        s_peek_pages = 0;
+        return;
+    }
+
+    page_hdr_t hdr;
+    for (uint32_t i = 0; i < s_peek_pages; i++) {
+        if (read_hdr(s_cursor, &hdr) && is_waiting(&hdr)) {
+            mark_consumed(s_cursor);
+            s_stats.pages_sent++;
+            if (s_stats.pages_pending > 0) {
+                s_stats.pages_pending--;
+            }
+        }
+        s_cursor = next_page(s_cursor);
+    }
+    s_peek_pages = 0;
+}
+
+void telemetry_store_get_stats(telemetry_store_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+}
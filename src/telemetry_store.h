@@ -0,0 +1,83 @@
+/**
+ * Telemetry Store - Flash-backed store-and-forward for dashboard samples
+ *
+ * Samples that can't be uploaded (WiFi or dashboard down) are appended to
+ * a log in the "spiffs" data partition, used raw, and uploaded later
+ * without holding up the live stream.
+ */
+
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "telemetry_codec.h"
+
+#define TELEMETRY_STORE_PAGE_SIZE 256   // One flash page per record
+
+/**
+ * Store statistics
+ */
+typedef struct {
+    uint32_t samples_stored;
+    uint32_t pages_written;
+    uint32_t pages_pending;     // Written, not yet uploaded
+    uint32_t pages_sent;        // Uploaded and acknowledged
+    uint32_t pages_dropped;     // Overwritten before they could be uploaded
+    uint32_t crc_errors;        // Damaged pages skipped
+    uint32_t sector_erases;
+} telemetry_store_stats_t;
+
+/**
+ * State of a backfill upload (see telemetry.c)
+ */
+typedef enum {
+    TELEMETRY_BACKFILL_IDLE = 0,
+    TELEMETRY_BACKFILL_IN_FLIGHT,   // Sent, acknowledgement outstanding
+    TELEMETRY_BACKFILL_DONE,        // Acknowledged - telemetry_store_ack()
+    TELEMETRY_BACKFILL_FAILED,      // Rejected, or the connection dropped
+} telemetry_backfill_t;
+
+/**
+ * Find the partition and recover the log position
+ * @return ESP_ERR_NOT_FOUND if there is no "spiffs" partition
+ */
+esp_err_t telemetry_store_init(void);
+
+/**
+ * Append samples that couldn't be uploaded
+ * Buffered in RAM until a page fills or telemetry_store_sync() is called.
+ */
+void telemetry_store_append(const telemetry_record_t *records, size_t count);
+
+/**
+ * Write out a partially filled page (call once uploads work again)
+ */
+void telemetry_store_sync(void);
+
+/**
+ * Check if there are pages waiting to be uploaded
+ */
+bool telemetry_store_pending(void);
+
+/**
+ * Read the oldest waiting pages for upload, without consuming them
+ * Each page's samples start with a keyframe, so the result is a valid
+ * telemetry_codec stream.
+ * @return Bytes written to buf (0 if nothing is waiting)
+ */
+size_t telemetry_store_peek(uint8_t *buf, size_t max_len);
+
+/**
+ * Mark the pages returned by the last telemetry_store_peek() as uploaded
+ */
+void telemetry_store_ack(void);
+
+/**
+ * Get store statistics
+ */
+void telemetry_store_get_stats(telemetry_store_stats_t *stats);
+
+#endif // TELEMETRY_STORE_H
@@ -0,0 +1,121 @@
+/**
+ * Track Simplify - Streaming line simplification of the uploaded track
+ *
+ * Opening window: from the last point kept (the anchor), candidates pile
+ * up as long as every one of them lies within the tolerance of the
+ * segment from the anchor to the newest point. When a new point breaks
+ * that, the newest candidate is kept and becomes the next anchor. Each
+ * dropped point is therefore within the tolerance of the track that was
+ * sent - unlike a fixed-rate decimation, the error is bounded.
+ *
+ * Distances are 3D, in a local east/north/up frame in mm around the
+ * anchor; at TRACK_SIMPLIFY_MAX_POINTS candidates that flat-earth frame is
+ * far more accurate than any tolerance worth setting.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "track_simplify.h"
+
+#define MM_PER_E7_DEG 11.1319f  // 1e-7 degrees of latitude
+
+static void set_anchor(track_simplify_t *t, const zed_position_t *pos)
+{
+    t->anchor = *pos;
+    t->east_scale = MM_PER_E7_DEG * cosf(pos->lat_e7 * 1e-7f * ((float)M_PI / 180.0f));
+    t->have_anchor = true;
+    t->count = 0;
+    t->span_error = 0.0f;
+}
+
+static void to_enu(const track_simplify_t *t, const zed_position_t *pos, float enu[3])
+{
+    enu[0] = (float)((int64_t)pos->lon_e7 - t->anchor.lon_e7) * t->east_scale;
+    enu[1] = (float)((int64_t)pos->lat_e7 - t->anchor.lat_e7) * MM_PER_E7_DEG;
+    enu[2] = (float)((int64_t)pos->alt_mm - t->anchor.alt_mm);
+}
+
+/**
+ * Squared distance of x from the segment from the anchor (origin) to p
+ */
+static float segment_dist2(const float x[3], const float p[3])
+{
+    float pp = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+    float u = 0.0f;
+    if (pp > 0.0f) {
+        u = (x[0] * p[0] + x[1] * p[1] + x[2] * p[2]) / pp;
+        u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+    }
+    float d[3] = { x[0] - u * p[0], x[1] - u * p[1], x[2] - u * p[2] };
+    return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+}
+
+/**
+ * Account for the candidates dropped between the anchor and a kept point
+ */
+static void drop_candidates(track_simplify_t *t)
+{
+    uint32_t err = (uint32_t)(t->span_error + 0.5f);
+    if (err > t->stats.max_error_mm) {
+        t->stats.max_error_mm = err;
+    }
+}
+
+void track_simplify_init(track_simplify_t *t, uint32_t tolerance_mm)
+{
+    memset(t, 0, sizeof(*t));
+    t->tolerance_mm = tolerance_mm;
+}
+
+int track_simplify_add(track_simplify_t *t, const zed_position_t *pos, bool keep,
+                       zed_position_t out[2])
+{
+    int n = 0;
+    t->stats.points_in++;
+
+    // Without a fix there's no track to simplify; close the one so far
+    if (!t->have_anchor || t->tolerance_mm == 0 || !pos->valid || !t->anchor.valid) {
+        if (t->count > 0) {
+            out[n++] = t->last;
+            drop_candidates(t);
+            set_anchor(t, &t->last);
+        }
+        keep = true;
+    } else {
+        float p[3];
+        to_enu(t, pos, p);
+        float max2 = 0.0f;
+        for (uint32_t i = 0; i < t->count; i++) {
+            float d2 = segment_dist2(t->enu[i], p);
+            if (d2 > max2) max2 = d2;
+        }
+
+        float tol = (float)t->tolerance_mm;
+        if (t->count > 0 && (max2 > tol * tol || t->count == TRACK_SIMPLIFY_MAX_POINTS)) {
+            // The newest candidate is needed - keep it and start over from there
+            out[n++] = t->last;
+            drop_candidates(t);
+            set_anchor(t, &t->last);
+            to_enu(t, pos, p);
+            max2 = 0.0f;
+        }
+        t->span_error = sqrtf(max2);
+
+        if (!keep) {
+            memcpy(t->enu[t->count], p, sizeof(p));
+            t->count++;
+            t->last = *pos;
+            t->stats.points_out += n;
+            return n;
+        }
+    }
+
+    if (t->have_anchor && t->count > 0) {
+        drop_candidates(t);
+    }
+    out[n++] = *pos;
+    set_anchor(t, pos);
+    t->stats.points_out += n;
+    return n;
+}
@@ -0,0 +1,58 @@
+/**
+ * Track Simplify - Streaming line simplification of the uploaded track
+ *
+ * Drops points that lie within a tolerance of the straight line between
+ * the points kept on either side of them, so a straight run uploads as
+ * its two ends. Works on a bounded window (opening-window algorithm), one
+ * point of delay: a point is only known to be needed once the next one
+ * leaves the corridor.
+ */
+
+#ifndef TRACK_SIMPLIFY_H
+#define TRACK_SIMPLIFY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "zed_rover.h"
+
+#define TRACK_SIMPLIFY_MAX_POINTS 32    // Candidates held; a full window is cut there
+
+/**
+ * Simplification statistics
+ */
+typedef struct {
+    uint32_t points_in;
+    uint32_t points_out;
+    uint32_t max_error_mm;          // Largest distance of a dropped point from the track kept
+} track_simplify_stats_t;
+
+/**
+ * Simplifier state
+ */
+typedef struct {
+    uint32_t tolerance_mm;
+    bool have_anchor;
+    zed_position_t anchor;          // Last point kept
+    float east_scale;               // mm per 1e-7 deg of longitude at the anchor
+    zed_position_t last;            // Newest candidate
+    uint32_t count;                 // Candidates since the anchor (the newest included)
+    float enu[TRACK_SIMPLIFY_MAX_POINTS][3];    // Their offsets from the anchor (mm)
+    float span_error;               // Max distance of the candidates from anchor -> newest
+    track_simplify_stats_t stats;
+} track_simplify_t;
+
+/**
+ * Reset with a tolerance (0 keeps every point)
+ */
+void track_simplify_init(track_simplify_t *t, uint32_t tolerance_mm);
+
+/**
+ * Offer the next point
+ * @param keep  Keep this point regardless (fix change, heartbeat)
+ * @param out   Receives the points to send, in order (up to 2)
+ * @return Number of points written to out
+ */
+int track_simplify_add(track_simplify_t *t, const zed_position_t *pos, bool keep,
+                       zed_position_t out[2]);
+
+#endif // TRACK_SIMPLIFY_H
@@ -0,0 +1,99 @@
+/**
+ * UDP Telemetry - One datagram per epoch for displays on the same LAN
+ *
+ * Machine guidance wants the position on screen within milliseconds, so
+ * this bypasses the telemetry task, its batching and TCP altogether: the
+ * rover loop sends each epoch straight away as one telemetry_codec
+ * keyframe (~45 bytes). Every datagram decodes on its own, and the
+ * codec's sequence number increments by one per datagram so the receiver
+ * can count losses from the gaps.
+ *
+ * The destination is a unicast or broadcast IPv4 literal - there is no
+ * DNS on the send path. sendto() is non-blocking; when WiFi is down or
+ * lwIP is out of buffers the datagram is dropped and counted, never
+ * queued, since a late position is no use to a display.
+ */
+
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "udp_telemetry.h"
+#include "config.h"
+
+static const char *TAG = "udp_telem";
+
+#ifndef UDP_TELEMETRY_ADDR
+#define UDP_TELEMETRY_ADDR "255.255.255.255"
+#endif
+#ifndef UDP_TELEMETRY_PORT
+#define UDP_TELEMETRY_PORT 5005
+#endif
+
+static int s_sock = -1;
+static struct sockaddr_in s_dest;
+static uint32_t s_seq = 0;
+static udp_telemetry_stats_t s_stats;
+
+esp_err_t udp_telemetry_init(void)
+{
+    memset(&s_dest, 0, sizeof(s_dest));
+    s_dest.sin_family = AF_INET;
+    s_dest.sin_port = htons(UDP_TELEMETRY_PORT);
+    if (inet_aton(UDP_TELEMETRY_ADDR, &s_dest.sin_addr) == 0) {
+        ESP_LOGE(TAG, "UDP_TELEMETRY_ADDR %s is not an IPv4 address", UDP_TELEMETRY_ADDR);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    int broadcast = 1;
+    setsockopt(s_sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    ESP_LOGI(TAG, "Streaming epochs to %s:%d", UDP_TELEMETRY_ADDR, UDP_TELEMETRY_PORT);
+    return ESP_OK;
+}
+
+esp_err_t udp_telemetry_send(const telemetry_record_t *rec)
+{
+    if (s_sock < 0 || rec == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // A fresh codec makes a keyframe; only the sequence number carries over
+    telemetry_codec_t codec;
+    telemetry_codec_reset(&codec);
+    codec.seq = s_seq++;
+    uint8_t buf[TELEMETRY_CODEC_MAX_SAMPLE];
+    size_t len = telemetry_codec_encode(&codec, rec, buf);
+
+    int64_t start = esp_timer_get_time();
+    int sent = sendto(s_sock, buf, len, MSG_DONTWAIT, (struct sockaddr *)&s_dest, sizeof(s_dest));
+    uint32_t took = (uint32_t)(esp_timer_get_time() - start);
+    if (took > s_stats.max_send_us) {
+        s_stats.max_send_us = took;
+    }
+
+    s_stats.sent++;
+    if (sent != (int)len) {
+        s_stats.errors++;
+        return ESP_FAIL;
+    }
+    s_stats.bytes += len;
+    return ESP_OK;
+}
+
+void udp_telemetry_get_stats(udp_telemetry_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+}
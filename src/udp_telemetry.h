@@ -0,0 +1,39 @@
+/**
+ * UDP Telemetry - One datagram per epoch for displays on the same LAN
+ */
+
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include "telemetry_codec.h"
+
+/**
+ * Stream statistics
+ */
+typedef struct {
+    uint32_t sent;              // Datagrams attempted (= next sequence number)
+    uint32_t errors;            // sendto() failures (no WiFi, buffers full)
+    uint32_t bytes;
+    uint32_t max_send_us;       // Longest sendto() call
+} udp_telemetry_stats_t;
+
+/**
+ * Open the socket for UDP_TELEMETRY_ADDR:UDP_TELEMETRY_PORT
+ * @return ESP_ERR_INVALID_ARG if the address is not an IPv4 literal
+ */
+esp_err_t udp_telemetry_init(void);
+
+/**
+ * Send one sample as a single datagram
+ * Never blocks; a datagram that can't be sent right away is dropped.
+ */
+esp_err_t udp_telemetry_send(const telemetry_record_t *rec);
+
+/**
+ * Get stream statistics
+ */
+void udp_telemetry_get_stats(udp_telemetry_stats_t *stats);
+
+#endif // UDP_TELEMETRY_H
@@ -27,11 +27,12 @@ static const char *TAG = "wifi_multi";
 typedef struct {
     const char *ssid;
     const char *password;
+    bool metered;               // Data costs money (phone hotspot) - see link_budget.c
 } wifi_network_t;
 
 static const wifi_network_t wifi_networks[] = {
-    { "RudyTheCanadian", "BIG22slick" },  // iPhone hotspot (portable)
-    { "Glasshouse2.4", "BIG22slick" },    // Home network
+    { "RudyTheCanadian", "BIG22slick", true },   // iPhone hotspot (portable)
+    { "Glasshouse2.4", "BIG22slick", false },    // Home network
     // Add more networks here as needed
 };
 
@@ -354,3 +355,19 @@ const char* wifi_get_ssid(void)
 {
     return s_connected_ssid;
 }
+
+bool wifi_is_metered(void)
+{
+    return s_connected && s_current_network_idx >= 0 &&
+           wifi_networks[s_current_network_idx].metered;
+}
+
+bool wifi_get_rssi(int8_t *rssi)
+{
+    wifi_ap_record_t ap;
+    if (!s_connected || esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return false;
+    }
+    *rssi = ap.rssi;
+    return true;
+}
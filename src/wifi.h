@@ -7,6 +7,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * Initialize WiFi in station mode and connect to configured AP
@@ -25,4 +26,15 @@ bool wifi_is_connected(void);
  */
 const char* wifi_get_ssid(void);
 
+/**
+ * Check if the connected network is marked metered (e.g. a phone hotspot)
+ */
+bool wifi_is_metered(void);
+
+/**
+ * Get the signal strength of the connected AP in dBm
+ * Returns false if not connected
+ */
+bool wifi_get_rssi(int8_t *rssi);
+
 #endif // WIFI_H
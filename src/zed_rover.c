@@ -7,6 +7,7 @@
 #include "freertos/task.h"
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "zed_rover.h"
 #include "config.h"
@@ -28,14 +29,76 @@ static const char *TAG = "zed_rover";
 
 // UBX message IDs
 #define UBX_NAV_PVT 0x07
+#define UBX_NAV_HPPOSLLH 0x14
 
 // I2C timeout
 #define I2C_TIMEOUT_MS 100
 
+// How long a NAV-PVT waits for the NAV-HPPOSLLH of its epoch
+#define HPPOS_WAIT_MS 50
+
 // Buffer for parsing UBX messages
 static uint8_t ubx_buffer[256];
 static int ubx_buffer_len = 0;
 
+// Last NAV-HPPOSLLH, applied to the NAV-PVT of the same epoch
+static struct {
+    uint32_t itow;
+    int8_t lat_hp;
+    int8_t lon_hp;
+    int8_t alt_hp;
+    bool valid;
+    bool expected;              // Receiver sends it - hold NAV-PVT for it
+} s_hp;
+
+// NAV-PVT held until its NAV-HPPOSLLH arrives or HPPOS_WAIT_MS passes
+static struct {
+    zed_position_t pos;
+    uint32_t itow;
+    int64_t since_us;
+    bool pending;
+} s_held;
+
+// Bus timing: a 2-byte length poll is ~0.1 ms, a full 2 KB read ~50 ms at 400 kHz
+static const uint32_t k_i2c_bounds_us[] = { 250, 500, 1000, 2500, 5000, 10000, 25000, 100000 };
+static zed_i2c_stats_t s_i2c = {
+    .latency_us = { .bounds = k_i2c_bounds_us,
+                    .num_bounds = sizeof(k_i2c_bounds_us) / sizeof(k_i2c_bounds_us[0]) },
+};
+
+/**
+ * Read a little-endian 32-bit field
+ */
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Account for one transaction with the receiver
+ */
+static void i2c_done(int64_t start_us, esp_err_t ret)
+{
+    s_i2c.transactions++;
+    if (ret != ESP_OK) {
+        s_i2c.errors++;
+    }
+    metrics_histogram_observe(&s_i2c.latency_us, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+/**
+ * Map NAV-PVT flags3 lastCorrectionAge to seconds (bin upper bound)
+ */
+static uint16_t corr_age_from_bin(uint8_t bin)
+{
+    static const uint16_t upper_s[] = { ZED_CORR_AGE_UNKNOWN, 1, 2, 5, 10, 15, 20, 30,
+                                        45, 60, 90, 120, ZED_CORR_AGE_OVER_120S };
+    if (bin >= sizeof(upper_s) / sizeof(upper_s[0])) {
+        return ZED_CORR_AGE_UNKNOWN;
+    }
+    return upper_s[bin];
+}
+
 /**
  * Calculate UBX checksum
  */
@@ -109,9 +172,11 @@ int zed_rover_available(void)
 {
     uint8_t len_bytes[2];
 
+    int64_t start_us = esp_timer_get_time();
     esp_err_t ret = i2c_master_write_read_device(I2C_MASTER_NUM, ZED_I2C_ADDR,
         (uint8_t[]){UBX_REG_DATA_LEN_H}, 1, len_bytes, 2,
         pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+    i2c_done(start_us, ret);
 
     if (ret != ESP_OK) {
         return -1;
@@ -137,15 +202,18 @@ int zed_rover_read(uint8_t *buffer, size_t max_len)
     size_t to_read = (available < max_len) ? available : max_len;
 
     uint8_t reg = UBX_REG_DATA;
+    int64_t start_us = esp_timer_get_time();
     esp_err_t ret = i2c_master_write_read_device(I2C_MASTER_NUM, ZED_I2C_ADDR,
         &reg, 1, buffer, to_read,
         pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+    i2c_done(start_us, ret);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read data: %s", esp_err_to_name(ret));
         return -1;
     }
 
+    s_i2c.bytes_read += to_read;
     return to_read;
 }
 
@@ -155,24 +223,101 @@ int zed_rover_write_rtcm(const uint8_t *data, size_t len)
 
     // Write directly to the data register (0xFF)
     // u-blox receivers accept raw RTCM data written to I2C
+    int64_t start_us = esp_timer_get_time();
     esp_err_t ret = i2c_master_write_to_device(I2C_MASTER_NUM, ZED_I2C_ADDR,
         data, len,
         pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+    i2c_done(start_us, ret);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to write RTCM: %s", esp_err_to_name(ret));
         return -1;
     }
 
+    s_i2c.rtcm_bytes_written += len;
     return len;
 }
 
+/**
+ * Keep the high precision digits if frame is a complete NAV-HPPOSLLH
+ * The receiver may send it before or after NAV-PVT within an epoch.
+ * @return true if it was one
+ */
+static bool take_hppos(const uint8_t *frame, int avail)
+{
+    if (avail < 8 + 36 || frame[0] != UBX_SYNC1 || frame[1] != UBX_SYNC2 ||
+        frame[2] != UBX_CLASS_NAV || frame[3] != UBX_NAV_HPPOSLLH ||
+        (frame[4] | (frame[5] << 8)) != 36) {
+        return false;
+    }
+    uint8_t ck_a, ck_b;
+    ubx_checksum(&frame[2], 4 + 36, &ck_a, &ck_b);
+    if (ck_a != frame[6 + 36] || ck_b != frame[7 + 36]) {
+        return false;
+    }
+
+    const uint8_t *p = &frame[6];
+    s_hp.itow = get_u32(&p[4]);
+    s_hp.lon_hp = (int8_t)p[24];
+    s_hp.lat_hp = (int8_t)p[25];
+    s_hp.alt_hp = (int8_t)p[27];
+    s_hp.valid = (p[3] & 0x01) == 0;    // flags: invalidLlh
+    s_hp.expected = true;
+    return true;
+}
+
+/**
+ * Add the high precision digits if the last NAV-HPPOSLLH is of this epoch
+ * @return true if it was (valid or not - nothing better will come)
+ */
+static bool apply_hppos(zed_position_t *pos, uint32_t itow)
+{
+    if (s_hp.itow != itow) {
+        return false;
+    }
+    if (s_hp.valid) {
+        pos->lat_hp = s_hp.lat_hp;
+        pos->lon_hp = s_hp.lon_hp;
+        pos->alt_hp = s_hp.alt_hp;
+    }
+    return true;
+}
+
+/**
+ * Hand out the held NAV-PVT
+ */
+static bool release_held(zed_position_t *pos)
+{
+    *pos = s_held.pos;
+    s_held.pending = false;
+    return true;
+}
+
+/**
+ * Drop a message from the front of the parse buffer
+ */
+static void consume(int end)
+{
+    int remaining = ubx_buffer_len - end;
+    if (remaining > 0) {
+        memmove(ubx_buffer, &ubx_buffer[end], remaining);
+    }
+    ubx_buffer_len = remaining;
+}
+
 bool zed_rover_get_position(zed_position_t *pos)
 {
     if (pos == NULL) return false;
 
     memset(pos, 0, sizeof(zed_position_t));
 
+    // No NAV-HPPOSLLH for the held epoch: send the position without it, and
+    // stop waiting until the receiver sends one again
+    if (s_held.pending && esp_timer_get_time() - s_held.since_us >= HPPOS_WAIT_MS * 1000) {
+        s_hp.expected = false;
+        return release_held(pos);
+    }
+
     // Read available data
     int avail = zed_rover_available();
     if (avail <= 0) {
@@ -217,10 +362,16 @@ bool zed_rover_get_position(zed_position_t *pos)
 
             // Check if it's NAV-PVT (class 0x01, id 0x07, length 92)
             if (msg_class == UBX_CLASS_NAV && msg_id == UBX_NAV_PVT && payload_len == 92) {
+                // The next epoch is here - its HPPOSLLH won't be the held one's.
+                // This PVT stays in the buffer for the next call.
+                if (s_held.pending) {
+                    return release_held(pos);
+                }
+
                 uint8_t *p = &ubx_buffer[i + 6];  // Start of payload
 
                 // Parse NAV-PVT payload
-                // Bytes 0-3: iTOW (ignored)
+                // Bytes 0-3: iTOW (see below)
                 pos->year = p[4] | (p[5] << 8);
                 pos->month = p[6];
                 pos->day = p[7];
@@ -235,49 +386,64 @@ bool zed_rover_get_position(zed_position_t *pos)
                 // Byte 21: flags (includes carrSoln in bits 6-7)
                 uint8_t flags = p[21];
                 pos->carr_soln = (flags >> 6) & 0x03;
+                pos->diff_soln = (flags & 0x02) != 0;
 
                 // Byte 23: numSV
                 pos->num_sv = p[23];
 
-                // Bytes 24-27: lon (1e-7 degrees)
-                int32_t lon_raw = p[24] | (p[25] << 8) | (p[26] << 16) | (p[27] << 24);
-                pos->longitude = lon_raw * 1e-7;
-
-                // Bytes 28-31: lat (1e-7 degrees)
-                int32_t lat_raw = p[28] | (p[29] << 8) | (p[30] << 16) | (p[31] << 24);
-                pos->latitude = lat_raw * 1e-7;
+                // Bytes 24-27: lon, 28-31: lat (1e-7 degrees)
+                pos->lon_e7 = (int32_t)get_u32(&p[24]);
+                pos->lat_e7 = (int32_t)get_u32(&p[28]);
 
                 // Bytes 36-39: hMSL (mm)
-                int32_t alt_raw = p[36] | (p[37] << 8) | (p[38] << 16) | (p[39] << 24);
-                pos->altitude_msl = alt_raw / 1000.0;
+                pos->alt_mm = (int32_t)get_u32(&p[36]);
 
-                // Bytes 40-43: hAcc (mm)
-                uint32_t h_acc_raw = p[40] | (p[41] << 8) | (p[42] << 16) | (p[43] << 24);
-                pos->h_acc = h_acc_raw / 1000.0f;
+                // Bytes 40-43: hAcc, 44-47: vAcc (mm)
+                pos->h_acc_mm = get_u32(&p[40]);
+                pos->v_acc_mm = get_u32(&p[44]);
 
-                // Bytes 44-47: vAcc (mm)
-                uint32_t v_acc_raw = p[44] | (p[45] << 8) | (p[46] << 16) | (p[47] << 24);
-                pos->v_acc = v_acc_raw / 1000.0f;
+                // Bytes 60-63: gSpeed (mm/s), 64-67: headMot (1e-5 degrees)
+                pos->g_speed_mm_s = (int32_t)get_u32(&p[60]);
+                pos->head_mot_e5 = (int32_t)get_u32(&p[64]);
+
+                // Bytes 0-3: iTOW - pair with NAV-HPPOSLLH of the same epoch
+                uint32_t itow = get_u32(&p[0]);
+
+                // Bytes 76-77: pDOP (0.01)
+                pos->p_dop = p[76] | (p[77] << 8);
+
+                // Bytes 78-79: flags3 (lastCorrectionAge in bits 1-4)
+                uint16_t flags3 = p[78] | (p[79] << 8);
+                pos->corr_age_s = corr_age_from_bin((flags3 >> 1) & 0x0F);
 
                 pos->valid = (valid_flags & 0x01) && (pos->fix_type >= 2);
 
-                // Remove parsed message from buffer
-                int remaining = ubx_buffer_len - (i + msg_total_len);
-                if (remaining > 0) {
-                    memmove(ubx_buffer, &ubx_buffer[i + msg_total_len], remaining);
-                }
-                ubx_buffer_len = remaining;
+                consume(i + msg_total_len);
 
-                return true;
+                // HPPOSLLH came first, or right behind in this read. If not,
+                // hold the PVT - it may be in the next read.
+                take_hppos(ubx_buffer, ubx_buffer_len);
+                if (apply_hppos(pos, itow) || !s_hp.expected) {
+                    return true;
+                }
+                s_held.pos = *pos;
+                s_held.itow = itow;
+                s_held.since_us = esp_timer_get_time();
+                s_held.pending = true;
+                memset(pos, 0, sizeof(zed_position_t));
+                i = -1;
+                continue;
             }
 
+            bool hppos = take_hppos(&ubx_buffer[i], ubx_buffer_len - i);
+
             // Skip this message
-            int remaining = ubx_buffer_len - (i + msg_total_len);
-            if (remaining > 0) {
-                memmove(ubx_buffer, &ubx_buffer[i + msg_total_len], remaining);
-            }
-            ubx_buffer_len = remaining;
+            consume(i + msg_total_len);
             i = -1;  // Restart search from beginning
+
+            if (hppos && s_held.pending && apply_hppos(&s_held.pos, s_held.itow)) {
+                return release_held(pos);
+            }
         }
     }
 
@@ -289,6 +455,21 @@ bool zed_rover_get_position(zed_position_t *pos)
     return false;
 }
 
+void zed_rover_position_deg(const zed_position_t *pos,
+                            double *lat_deg, double *lon_deg, double *alt_m)
+{
+    if (lat_deg) *lat_deg = pos->lat_e7 * 1e-7 + pos->lat_hp * 1e-9;
+    if (lon_deg) *lon_deg = pos->lon_e7 * 1e-7 + pos->lon_hp * 1e-9;
+    if (alt_m) *alt_m = pos->alt_mm * 1e-3 + pos->alt_hp * 1e-4;
+}
+
+void zed_rover_get_i2c_stats(zed_i2c_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_i2c;
+    }
+}
+
 const char* zed_rover_fix_type_str(uint8_t fix_type, uint8_t carr_soln)
 {
     if (carr_soln == 2) return "RTK FIXED";
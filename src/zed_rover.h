@@ -4,6 +4,7 @@
  * Handles:
  *   - Writing RTCM corrections to the receiver
  *   - Reading position/status from NAV-PVT messages
+ *     (plus NAV-HPPOSLLH, if the receiver is set to output it)
  */
 
 #ifndef ZED_ROVER_H
@@ -13,9 +14,18 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "metrics.h"
+
+// corr_age_s values that are not a plain number of seconds
+#define ZED_CORR_AGE_OVER_120S  0xFFFE  // 120 s or more
+#define ZED_CORR_AGE_UNKNOWN    0xFFFF  // No corrections received
 
 /**
  * Position and status data from NAV-PVT
+ *
+ * Kept in the receiver's own integer units end to end - parsing, the
+ * telemetry queue, NMEA and logs never touch a double. Use
+ * zed_rover_position_deg() where degrees and meters are really needed.
  */
 typedef struct {
     // Time
@@ -31,19 +41,45 @@ typedef struct {
     uint8_t carr_soln;      // 0=none, 1=float, 2=fixed
     uint8_t num_sv;         // Number of satellites used
 
-    // Position (high precision)
-    double latitude;        // degrees
-    double longitude;       // degrees
-    double altitude_msl;    // meters
+    // High precision extension (NAV-HPPOSLLH of the same epoch, else 0)
+    int8_t lat_hp;          // 1e-9 degrees, -99..99
+    int8_t lon_hp;          // 1e-9 degrees, -99..99
+    int8_t alt_hp;          // 0.1 mm, -9..9
 
-    // Accuracy estimates
-    float h_acc;            // horizontal accuracy (m)
-    float v_acc;            // vertical accuracy (m)
+    // Corrections
+    bool diff_soln;         // Differential corrections applied
 
     // Flags
     bool valid;             // Data is valid
+
+    // Position
+    int32_t lat_e7;         // 1e-7 degrees
+    int32_t lon_e7;         // 1e-7 degrees
+    int32_t alt_mm;         // Height above MSL (mm)
+
+    // Accuracy estimates
+    uint32_t h_acc_mm;      // Horizontal accuracy (mm)
+    uint32_t v_acc_mm;      // Vertical accuracy (mm)
+
+    // Motion
+    int32_t g_speed_mm_s;   // Ground speed (mm/s)
+    int32_t head_mot_e5;    // Heading of motion (1e-5 degrees, 0..360)
+    uint16_t p_dop;         // Position DOP (0.01)
+
+    uint16_t corr_age_s;    // Age of last correction (s, upper bound of the receiver's bin)
 } zed_position_t;
 
+/**
+ * I2C bus statistics (transactions with the receiver, not the boot scan)
+ */
+typedef struct {
+    uint32_t transactions;
+    uint32_t errors;                // Failed or timed out
+    uint32_t bytes_read;
+    uint32_t rtcm_bytes_written;
+    metrics_histogram_t latency_us; // Per transaction, errors included
+} zed_i2c_stats_t;
+
 /**
  * Initialize I2C and verify ZED-X20P communication
  */
@@ -68,10 +104,25 @@ int zed_rover_read(uint8_t *buffer, size_t max_len);
 
 /**
  * Poll for position update (NAV-PVT)
+ * Once the receiver has sent NAV-HPPOSLLH, a NAV-PVT is held for up to
+ * 50 ms until the NAV-HPPOSLLH of its epoch arrives.
  * Returns true if new position data available
  */
 bool zed_rover_get_position(zed_position_t *pos);
 
+/**
+ * Convert a position to degrees and meters MSL, high precision part included
+ * The only place positions become doubles (soft-float on this chip) - keep
+ * it out of per-epoch paths. Any output pointer may be NULL.
+ */
+void zed_rover_position_deg(const zed_position_t *pos,
+                            double *lat_deg, double *lon_deg, double *alt_m);
+
+/**
+ * Get I2C bus statistics
+ */
+void zed_rover_get_i2c_stats(zed_i2c_stats_t *stats);
+
 /**
  * Get fix type as string
  */